@@ -0,0 +1,154 @@
+// Page cache growth per --cache-policy.
+// Usage: zenithsearch_bench_cache_policy [--files N] [--size BYTES] [--dir DIR]
+// Writes N files of BYTES each under DIR (default 64 x 16 MiB in the temp
+// directory). For each policy it evicts the corpus from the page cache, counts a
+// pattern with one cold pass, and then counts how much of the corpus is resident
+// (mincore over a mapping of each file). Normal leaves the corpus cached, drop
+// and direct should leave next to none of it. On file systems without O_DIRECT
+// (tmpfs) direct falls back to buffered reads plus eviction. POSIX only.
+
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/SearchEngine.hpp"
+#include "platform/MappedFileProvider.hpp"
+#include "platform/StdFileReader.hpp"
+#include "platform/StdFilesystemEnumerator.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+class NullOut final : public zenith::core::IOutputWriter {
+public:
+    void write_match(const zenith::core::MatchRecord&) override {}
+    void write_file_summary(const zenith::core::FileMatchSummary&) override {}
+};
+
+class NullErr final : public zenith::core::IErrorWriter {
+public:
+    void write_error(const zenith::core::Error&) override {}
+};
+
+#ifndef _WIN32
+void evict(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    ::close(fd);
+}
+
+// Bytes of `path` in the page cache, in whole pages.
+std::size_t resident_bytes(const std::filesystem::path& path, std::size_t size) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || size == 0) {
+        if (fd >= 0) ::close(fd);
+        return 0;
+    }
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return 0;
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> vec((size + page - 1) / page);
+    std::size_t resident = 0;
+#ifdef __APPLE__
+    auto* status = reinterpret_cast<char*>(vec.data());
+#else
+    auto* status = vec.data();
+#endif
+    if (::mincore(map, size, status) == 0) {
+        for (const auto v : vec) resident += (v & 1) != 0 ? page : 0;
+    }
+    ::munmap(map, size);
+    return resident;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    std::puts("zenithsearch_bench_cache_policy needs mincore; not available on Windows");
+    return 0;
+#else
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+    using zenith::core::CachePolicy;
+
+    std::size_t files = 64;
+    std::size_t size = 16U << 20;
+    fs::path dir = fs::temp_directory_path() / "zenith_bench_cache_policy";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&] { return i + 1 < argc ? std::strtoull(argv[++i], nullptr, 10) : 0ULL; };
+        if (arg == "--files") files = static_cast<std::size_t>(next());
+        else if (arg == "--size") size = static_cast<std::size_t>(next());
+        else if (arg == "--dir" && i + 1 < argc) dir = argv[++i];
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "corpus_%zux%zu", files, size);
+    const auto marker = dir / name;
+    std::vector<fs::path> corpus;
+    for (std::size_t i = 0; i < files; ++i) {
+        std::snprintf(name, sizeof(name), "f%zu.txt", i);
+        corpus.push_back(dir / name);
+    }
+    if (!fs::exists(marker)) {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        std::string body(size, 'x');
+        for (std::size_t i = 0; i + 64 < size; i += 61) std::memcpy(body.data() + i, "token ", 6);
+        if (size >= 6) std::memcpy(body.data() + size / 2 - 3, "needle", 6);
+        for (const auto& path : corpus) std::ofstream(path, std::ios::binary) << body;
+        std::ofstream(marker) << "";
+    }
+
+    const zenith::platform::StdFilesystemEnumerator enumerator;
+    const zenith::core::NaiveSearchAlgorithm naive;
+    const zenith::core::BmhSearchAlgorithm bmh;
+    const zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullOut out;
+    NullErr err;
+
+    const double total_mib = static_cast<double>(files) * static_cast<double>(size) / (1 << 20);
+    std::printf("%zu files x %zu bytes (%.0f MiB)\n", files, size, total_mib);
+    std::printf("%8s %10s %10s %14s\n", "policy", "seconds", "MB/s", "cached MiB");
+    const std::pair<const char*, CachePolicy> policies[] = {
+        {"normal", CachePolicy::Normal}, {"drop", CachePolicy::Drop}, {"direct", CachePolicy::Direct}};
+    for (const auto& [label, policy] : policies) {
+        const zenith::platform::StdFileReader reader(policy);
+        const zenith::platform::MappedFileProvider mapped(policy);
+        zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+        zenith::core::SearchRequest req;
+        req.pattern = "needle";
+        req.input_paths = {dir.string()};
+        req.output_mode = zenith::core::OutputMode::Count;
+        req.cache_policy = policy;
+
+        for (const auto& path : corpus) evict(path);
+        const auto t0 = Clock::now();
+        engine.run(req);
+        const double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::size_t resident = 0;
+        for (const auto& path : corpus) resident += resident_bytes(path, size);
+        std::printf("%8s %10.3f %10.0f %14.1f\n", label, seconds, total_mib * (1 << 20) / seconds / 1e6,
+                    static_cast<double>(resident) / (1 << 20));
+    }
+    return 0;
+#endif
+}
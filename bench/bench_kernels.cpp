@@ -0,0 +1,197 @@
+// Kernel throughput micro-benchmark.
+// Usage: zenithsearch_bench_kernels [MiB]
+// Prints MB/s per pattern length for every literal kernel over log-like text, and
+// find_all vs count_all for frequent tokens (the --count path), --fuzzy
+// throughput per edit budget, --queries-from batches whose patterns share a
+// prefix, and snippet and JSON escaping.
+
+#include "core/FuzzySearch.hpp"
+#include "core/MultiPatternSearch.hpp"
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/RareByteSearchAlgorithm.hpp"
+#include "core/ShortPatternSearchAlgorithm.hpp"
+#include "core/TextUtils.hpp"
+#include "core/TwoWaySearchAlgorithm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::string make_corpus(std::size_t bytes) {
+    static const char* words[] = {"INFO", "request", "handled", "in", "ms", "user=", "id", "_ERROR", "E", "the", "and",
+                                  "status=200", "GET", "/api/v1/items", "latency", "cache", "miss", "hit", "worker"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> pick(0, std::size(words) - 1);
+    std::uniform_int_distribution<int> rare(0, 999);
+    std::string out;
+    out.reserve(bytes + 64);
+    while (out.size() < bytes) {
+        if (rare(rng) == 0) out += "E4711XQZ_TIMEOUT_CODE ";
+        out += words[pick(rng)];
+        out.push_back(rare(rng) < 60 ? '\n' : ' ');
+    }
+    out.resize(bytes);
+    return out;
+}
+
+double mb_per_s(const zenith::core::ISearchAlgorithm& algo, const std::string& hay, const std::string& pat, std::size_t& hits) {
+    double best = 0;
+    for (int rep = 0; rep < 3; ++rep) {
+        const auto t0 = std::chrono::steady_clock::now();
+        hits = algo.find_all(hay, pat).size();
+        const std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+        best = std::max(best, static_cast<double>(hay.size()) / 1e6 / dt.count());
+    }
+    return best;
+}
+
+double count_mb_per_s(const zenith::core::ISearchAlgorithm& algo, const std::string& hay, const std::string& pat, std::size_t& hits) {
+    double best = 0;
+    for (int rep = 0; rep < 3; ++rep) {
+        const auto t0 = std::chrono::steady_clock::now();
+        hits = algo.count_all(hay, pat);
+        const std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+        best = std::max(best, static_cast<double>(hay.size()) / 1e6 / dt.count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t mib = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 64;
+    const auto hay = make_corpus(mib * 1024U * 1024U);
+    const std::string source = "E4711XQZ_TIMEOUT_CODE";
+
+    const zenith::core::NaiveSearchAlgorithm naive;
+    const zenith::core::BmhSearchAlgorithm bmh;
+    const zenith::core::BoyerMooreSearchAlgorithm bm;
+    const zenith::core::ShortPatternSearchAlgorithm short_kernels;
+    const zenith::core::TwoWaySearchAlgorithm two_way;
+    const zenith::core::RareByteSearchAlgorithm rare_byte;
+    const std::vector<std::pair<const char*, const zenith::core::ISearchAlgorithm*>> kernels = {
+        {"naive", &naive}, {"bmh", &bmh}, {"boyer_moore", &bm}, {"short", &short_kernels}, {"two_way", &two_way},
+        {"rare_byte", &rare_byte}};
+
+    std::printf("corpus %zu MiB, MB/s (best of 3)\n%-4s %-18s", mib, "len", "pattern");
+    for (const auto& k : kernels) std::printf(" %12s", k.first);
+    std::printf(" %8s\n", "hits");
+    std::vector<std::string> patterns;
+    for (std::size_t len = 1; len <= source.size(); ++len) patterns.push_back(source.substr(0, len));
+    // Common bytes only: '_' and 'E' are frequent in the corpus.
+    patterns.push_back("_ERROR");
+    patterns.push_back("status=200 GET /api/v1/items");
+    for (const auto& pat : patterns) {
+        const auto len = pat.size();
+        std::size_t hits = 0;
+        std::printf("%-4zu %-18s", len, pat.c_str());
+        for (const auto& k : kernels) std::printf(" %12.0f", mb_per_s(*k.second, hay, pat, hits));
+        std::printf(" %8zu\n", hits);
+    }
+
+    // Adversarial inputs: runs of one byte, as in padded binary dumps.
+    const std::string runs(mib * 1024U * 1024U / 8U, 'a');
+    std::vector<std::pair<const char*, std::string>> adversarial = {
+        {"a{31}b", std::string(32, 'a')}, {"ba{31}", std::string(32, 'a')}, {"a{32}", std::string(32, 'a')}};
+    adversarial[0].second.back() = 'b';
+    adversarial[1].second.front() = 'b';
+    std::printf("\nruns of 'a', %zu MiB\n", runs.size() / (1024U * 1024U));
+    for (const auto& [name, pat] : adversarial) {
+        std::size_t hits = 0;
+        std::printf("%-4zu %-18s", pat.size(), name);
+        for (const auto& k : kernels) std::printf(" %12.0f", mb_per_s(*k.second, runs, pat, hits));
+        std::printf(" %8zu\n", hits);
+    }
+
+    // Frequent tokens: positions vectors dominate find_all, count_all only counts.
+    std::printf("\nfrequent tokens, MB/s find_all / count_all\n");
+    for (const std::string pat : {" ", "e", "in", "the", "_ERROR", "status=200 GET /api"}) {
+        std::size_t hits = 0;
+        std::printf("%-4zu %-18s", pat.size(), pat.c_str());
+        for (const auto& k : kernels) {
+            if (k.second == &naive) continue;
+            const double find = mb_per_s(*k.second, hay, pat, hits);
+            std::printf(" %s %.0f/%.0f", k.first, find, count_mb_per_s(*k.second, hay, pat, hits));
+        }
+        std::printf(" %8zu\n", hits);
+    }
+
+    // Approximate matching: pieces of at least 3 bytes are prefiltered with the
+    // literal kernel, shorter ones leave the whole text to the automaton.
+    std::printf("\nfuzzy, MB/s by edit budget k (hits)\n");
+    const std::string long_pattern = "status=200 GET /api/v1/items latency cache miss worker E4711XQZ_TIMEOUT_CODE user=id";
+    for (const std::string& pat : {std::string("_ERROR"), source, long_pattern}) {
+        std::printf("%-4zu %-18.18s", pat.size(), pat.c_str());
+        for (std::size_t k = 1; k <= 3; ++k) {
+            const auto& literal = zenith::core::FuzzySearcher::longest_piece(pat.size(), k) <= 16
+                                      ? static_cast<const zenith::core::ISearchAlgorithm&>(short_kernels)
+                                      : rare_byte;
+            const zenith::core::FuzzySearcher fuzzy(pat, k, literal);
+            double best = 0;
+            std::size_t hits = 0;
+            for (int rep = 0; rep < 3; ++rep) {
+                const auto t0 = std::chrono::steady_clock::now();
+                hits = fuzzy.find(hay).matches.size();
+                const std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+                best = std::max(best, static_cast<double>(hay.size()) / 1e6 / dt.count());
+            }
+            std::printf(" k=%zu %.0f (%zu)", k, best, hits);
+        }
+        std::printf("\n");
+    }
+
+    // Batches of ERR_nnnnn queries: every pattern shares the prefix, which also
+    // starts the corpus's frequent "_ERROR" word.
+    std::printf("\nbatch of ERR_nnnnn patterns, MB/s (hits)\n");
+    for (const std::size_t n : {1U, 8U, 100U, 2000U}) {
+        std::vector<std::string> patterns;
+        char name[16];
+        for (std::size_t i = 0; i < n; ++i) {
+            std::snprintf(name, sizeof(name), "ERR_%05zu", i * 7);
+            patterns.emplace_back(name);
+        }
+        const zenith::core::MultiPatternSearch search(patterns, std::vector<const zenith::core::ISearchAlgorithm*>(n, &rare_byte));
+        double best = 0;
+        std::size_t hits = 0;
+        for (int rep = 0; rep < 3; ++rep) {
+            hits = 0;
+            const auto t0 = std::chrono::steady_clock::now();
+            search.find(hay, [&](std::size_t, std::size_t) { ++hits; });
+            const std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+            best = std::max(best, static_cast<double>(hay.size()) / 1e6 / dt.count());
+        }
+        std::printf("%-6zu %.0f (%zu)\n", n, best, hits);
+    }
+
+    // Output escaping over snippet-sized pieces, appended into one reused buffer
+    // as the JSONL writer does.
+    std::printf("\nescaping 120-byte snippets, MB/s\n");
+    for (const bool json : {false, true}) {
+        double best = 0;
+        std::string out;
+        for (int rep = 0; rep < 3; ++rep) {
+            const auto t0 = std::chrono::steady_clock::now();
+            for (std::size_t at = 0; at + 120 <= hay.size(); at += 120) {
+                out.clear();
+                const std::string_view piece(hay.data() + at, 120);
+                if (json) {
+                    zenith::core::append_json_escaped(out, piece);
+                } else {
+                    zenith::core::append_sanitized(out, piece);
+                }
+            }
+            const std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+            best = std::max(best, static_cast<double>(hay.size()) / 1e6 / dt.count());
+        }
+        std::printf("%-10s %.0f\n", json ? "json" : "snippet", best);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Enumerated file list memory benchmark.
+// Usage: zenithsearch_bench_paths [files]            synthetic tree, default 10000000
+//        zenithsearch_bench_paths --tree DIR [files] create DIR with that many files
+//        zenithsearch_bench_paths --enumerate DIR [std|getdents] [--size]
+//                                                    enumerate an existing tree; --size
+//                                                    sets --max-bytes so sizes are read
+// Reports bytes per file for the interned PathTable list, next to what the previous
+// two-std::string FileItem layout would hold for the same paths.
+
+#include "core/PathTable.hpp"
+#include "platform/StdFilesystemEnumerator.hpp"
+#ifdef __linux__
+#include "platform/GetdentsEnumerator.hpp"
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+// Legacy layout: {std::string path; std::string normalized_path; uintmax_t size;}.
+std::size_t legacy_bytes(const std::string& path) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    const std::size_t heap = path.size() > inline_capacity ? path.size() + 1 : 0;
+    return 2 * sizeof(std::string) + sizeof(std::uintmax_t) + 2 * heap;
+}
+
+// Three directory levels of 100 entries, leaves named like build artifacts.
+template <typename Fn>
+void for_each_synthetic(std::size_t files, Fn&& fn) {
+    char dir1[32];
+    char dir2[32];
+    char dir3[32];
+    char leaf[48];
+    std::size_t n = 0;
+    for (std::size_t a = 0; n < files; ++a) {
+        std::snprintf(dir1, sizeof(dir1), "module_%03zu", a);
+        for (std::size_t b = 0; b < 100 && n < files; ++b) {
+            std::snprintf(dir2, sizeof(dir2), "src_%02zu", b);
+            for (std::size_t c = 0; c < 100 && n < files; ++c) {
+                std::snprintf(dir3, sizeof(dir3), "pkg_%02zu", c);
+                for (std::size_t d = 0; d < 10 && n < files; ++d, ++n) {
+                    std::snprintf(leaf, sizeof(leaf), "generated_object_%zu.o", d);
+                    fn(dir1, dir2, dir3, leaf, b == 0 && c == 0 && d == 0, c == 0 && d == 0, d == 0);
+                }
+            }
+        }
+    }
+}
+
+void report(const char* label, const zenith::core::FileList& list, std::size_t legacy, double seconds) {
+    const std::size_t interned = list.paths.memory_bytes() + list.files.capacity() * sizeof(zenith::core::FileItem);
+    const double n = static_cast<double>(list.files.size());
+    std::printf("%s: %zu files in %.2fs\n", label, list.files.size(), seconds);
+    std::printf("  interned: %10.1f MiB  %6.1f B/file (FileItem %zu B, %zu path nodes)\n", interned / 1048576.0,
+                interned / n, sizeof(zenith::core::FileItem), list.paths.size());
+    std::printf("  legacy:   %10.1f MiB  %6.1f B/file\n", legacy / 1048576.0, legacy / n);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+
+    if (argc >= 3 && std::strcmp(argv[1], "--tree") == 0) {
+        const fs::path root = argv[2];
+        const std::size_t files = argc > 3 ? static_cast<std::size_t>(std::strtoull(argv[3], nullptr, 10)) : 100000;
+        fs::path d1;
+        fs::path d2;
+        fs::path d3;
+        for_each_synthetic(files, [&](const char* a, const char* b, const char* c, const char* leaf, bool, bool, bool new_leaf_dir) {
+            if (new_leaf_dir) {
+                d3 = root / a / b / c;
+                fs::create_directories(d3);
+            }
+            std::ofstream(d3 / leaf);
+        });
+        std::printf("created %zu files under %s\n", files, root.string().c_str());
+        return 0;
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--enumerate") == 0) {
+        zenith::core::SearchRequest request;
+        request.input_paths = {argv[2]};
+        request.dedup_files = false;
+        const std::string backend = argc > 3 ? argv[3] : "std";
+        if (argc > 4 && std::strcmp(argv[4], "--size") == 0) request.max_bytes = UINTMAX_MAX - 1;
+        const zenith::platform::StdFilesystemEnumerator std_enumerator;
+#ifdef __linux__
+        const zenith::platform::GetdentsEnumerator getdents_enumerator;
+        const zenith::core::IFileEnumerator& enumerator =
+            backend == "getdents" ? static_cast<const zenith::core::IFileEnumerator&>(getdents_enumerator) : std_enumerator;
+#else
+        const zenith::core::IFileEnumerator& enumerator = std_enumerator;
+#endif
+        const auto t0 = Clock::now();
+        const auto list = enumerator.enumerate(request, {}, [](const zenith::core::Error&) {});
+        const std::chrono::duration<double> dt = Clock::now() - t0;
+        std::size_t legacy = 0;
+        for (const auto& f : list.files) legacy += legacy_bytes(list.paths.path(f.path));
+        report(backend.c_str(), list, legacy, dt.count());
+        return 0;
+    }
+
+    const std::size_t files = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 10000000;
+    zenith::core::FileList list;
+    const auto root = list.paths.add_root("/srv/build/tree", "/srv/build/tree");
+    zenith::core::PathId p1 = 0;
+    zenith::core::PathId p2 = 0;
+    zenith::core::PathId p3 = 0;
+    std::size_t legacy = 0;
+    std::string full;
+    const auto t0 = Clock::now();
+    for_each_synthetic(files, [&](const char* a, const char* b, const char* c, const char* leaf, bool new_a, bool new_b, bool new_c) {
+        if (new_a) p1 = list.paths.add_child(root, a);
+        if (new_b || new_a) p2 = list.paths.add_child(p1, b);
+        if (new_c || new_b || new_a) p3 = list.paths.add_child(p2, c);
+        list.files.push_back({list.paths.add_child(p3, leaf), 4096, {}});
+        full.assign("/srv/build/tree/").append(a).append("/").append(b).append("/").append(c).append("/").append(leaf);
+        legacy += legacy_bytes(full);
+    });
+    list.paths.shrink_to_fit();
+    list.files.shrink_to_fit();
+    const std::chrono::duration<double> dt = Clock::now() - t0;
+    report("synthetic", list, legacy, dt.count());
+    return 0;
+}
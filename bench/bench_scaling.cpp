@@ -0,0 +1,139 @@
+// Worker scaling benchmark for the search engine.
+// Usage: zenithsearch_bench_scaling [--files N] [--size BYTES] [--max-threads T] [--io-threads N] [--mmap auto|on|off] [--numa] [--dir DIR]
+// Writes N files of BYTES each under DIR (default 20000 x 4 KiB in the temp
+// directory), then counts a pattern at 1, 2, 4, ... T threads and prints files/s,
+// GB/s and the speedup over one thread. Many small files stress per-file costs and
+// the job queue; a few large ones (e.g. --files 256 --size 16777216) stress memory
+// bandwidth. --io-threads 0 has every worker do its own reads, for comparison with
+// the read-ahead stage. Files stay in the page cache after the first pass, so every run is warm.
+// Files are enumerated as the CLI does (getdents on Linux), so sizes are as
+// unknown to the engine as they are there.
+
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/SearchEngine.hpp"
+#include "platform/CpuTopology.hpp"
+#include "platform/MappedFileProvider.hpp"
+#include "platform/StdFileReader.hpp"
+#include "platform/StdFilesystemEnumerator.hpp"
+#ifdef __linux__
+#include "platform/GetdentsEnumerator.hpp"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace {
+
+class NullOut final : public zenith::core::IOutputWriter {
+public:
+    void write_match(const zenith::core::MatchRecord&) override {}
+    void write_file_summary(const zenith::core::FileMatchSummary&) override {}
+};
+
+class NullErr final : public zenith::core::IErrorWriter {
+public:
+    void write_error(const zenith::core::Error&) override {}
+};
+
+zenith::core::MmapMode mmap_mode_of(const std::string& name) {
+    if (name == "on") return zenith::core::MmapMode::On;
+    if (name == "off") return zenith::core::MmapMode::Off;
+    return zenith::core::MmapMode::Auto;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t files = 20000;
+    std::size_t size = 4096;
+    std::size_t max_threads = std::max(1U, std::thread::hardware_concurrency());
+    std::optional<std::size_t> io_threads;
+    bool numa = false;
+    auto mmap_mode = zenith::core::MmapMode::Auto;
+    fs::path dir = fs::temp_directory_path() / "zenith_bench_scaling";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&] { return i + 1 < argc ? std::strtoull(argv[++i], nullptr, 10) : 0ULL; };
+        if (arg == "--files") files = static_cast<std::size_t>(next());
+        else if (arg == "--size") size = static_cast<std::size_t>(next());
+        else if (arg == "--max-threads") max_threads = static_cast<std::size_t>(next());
+        else if (arg == "--io-threads") io_threads = static_cast<std::size_t>(next());
+        else if (arg == "--mmap" && i + 1 < argc) mmap_mode = mmap_mode_of(argv[++i]);
+        else if (arg == "--numa") numa = true;
+        else if (arg == "--dir" && i + 1 < argc) dir = argv[++i];
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "corpus_%zux%zu", files, size);
+    const auto marker = dir / name;
+    if (!fs::exists(marker)) {
+        fs::remove_all(dir);
+        std::string body(size, 'x');
+        for (std::size_t i = 0; i + 64 < size; i += 61) std::memcpy(body.data() + i, "token ", 6);
+        if (size >= 6) std::memcpy(body.data() + size / 2 - 3, "needle", 6);
+        fs::path sub;
+        for (std::size_t i = 0; i < files; ++i) {
+            if (i % 1000 == 0) {
+                std::snprintf(name, sizeof(name), "d%zu", i / 1000);
+                sub = dir / name;
+                fs::create_directories(sub);
+            }
+            std::snprintf(name, sizeof(name), "f%zu.txt", i);
+            std::ofstream(sub / name, std::ios::binary) << body;
+        }
+        std::ofstream(marker) << "";
+    }
+
+#ifdef __linux__
+    const zenith::platform::GetdentsEnumerator enumerator;
+#else
+    const zenith::platform::StdFilesystemEnumerator enumerator;
+#endif
+    const zenith::platform::StdFileReader reader;
+    const zenith::platform::MappedFileProvider mapped;
+    const zenith::core::NaiveSearchAlgorithm naive;
+    const zenith::core::BmhSearchAlgorithm bmh;
+    const zenith::core::BoyerMooreSearchAlgorithm bm;
+    const zenith::platform::CpuTopology topology;
+    NullOut out;
+    NullErr err;
+    zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+    engine.set_cpu_topology(&topology);
+
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {dir.string()};
+    req.output_mode = zenith::core::OutputMode::Count;
+    req.numa = numa;
+    req.io_threads = io_threads;
+    req.mmap_mode = mmap_mode;
+    engine.run(req); // warm the page cache
+
+    std::printf("%zu files x %zu bytes, %zu NUMA node(s)%s\n", files, size, topology.node_count(), numa ? ", --numa" : "");
+    std::printf("%8s %12s %10s %8s\n", "threads", "files/s", "GB/s", "speedup");
+    double base = 0;
+    for (std::size_t t = 1; t <= max_threads; t = t * 2 > max_threads && t != max_threads ? max_threads : t * 2) {
+        req.threads = t;
+        double best = 1e30;
+        for (int rep = 0; rep < 3; ++rep) {
+            const auto t0 = Clock::now();
+            engine.run(req);
+            best = std::min(best, std::chrono::duration<double>(Clock::now() - t0).count());
+        }
+        if (t == 1) base = best;
+        std::printf("%8zu %12.0f %10.2f %8.2f\n", t, files / best, static_cast<double>(files) * size / best / 1e9, base / best);
+        if (t == max_threads) break;
+    }
+    return 0;
+}
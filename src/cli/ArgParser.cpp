@@ -1,9 +1,14 @@
 #include "ArgParser.hpp"
 
+#include "core/TuningProfile.hpp"
+
 #include <algorithm>
 #include <cctype>
 #include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <sstream>
+#include <string_view>
 
 namespace zenith::cli {
 
@@ -27,12 +32,103 @@ core::Expected<std::uintmax_t, core::Error> parse_u64(const std::string& value,
     }
     return out;
 }
+
+// Byte count with an optional K/M/G (binary) suffix, e.g. 512M, up to `max`.
+core::Expected<std::uintmax_t, core::Error> parse_size(std::string value, const std::string& flag, std::uintmax_t max = UINTMAX_MAX) {
+    std::uintmax_t scale = 1;
+    if (!value.empty()) {
+        switch (std::toupper(static_cast<unsigned char>(value.back()))) {
+        case 'K': scale = 1024U; break;
+        case 'M': scale = 1024U * 1024U; break;
+        case 'G': scale = 1024U * 1024U * 1024U; break;
+        default: break;
+        }
+        if (scale != 1) value.pop_back();
+    }
+    auto parsed = parse_u64(value, flag);
+    if (!parsed) return parsed.error();
+    if (parsed.value() > max / scale) return core::Error{flag + " value is too large"};
+    return parsed.value() * scale;
+}
+
+// Duration with an ms, s or m suffix; plain numbers are seconds. E.g. 250ms, 2s.
+core::Expected<std::chrono::milliseconds, core::Error> parse_duration(std::string value, const std::string& flag) {
+    std::uintmax_t scale = 1000;
+    if (value.size() > 2 && value.ends_with("ms")) {
+        scale = 1;
+        value.resize(value.size() - 2);
+    } else if (value.size() > 1 && (value.back() == 's' || value.back() == 'm')) {
+        scale = value.back() == 'm' ? 60000 : 1000;
+        value.pop_back();
+    }
+    auto parsed = parse_u64(value, flag);
+    if (!parsed) return parsed.error();
+    if (parsed.value() == 0) return core::Error{flag + " must be greater than zero"};
+    // Half the steady clock's range (about 146 years), so a deadline of now plus
+    // the duration cannot overflow.
+    constexpr auto kMaxMs = static_cast<std::uintmax_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::duration::max()).count() / 2);
+    if (parsed.value() > kMaxMs / scale) return core::Error{flag + " value is too large"};
+    return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(parsed.value() * scale));
+}
+
+// Arguments after a subcommand word that are neither options nor the value of
+// `valued_option`.
+std::size_t count_operands(const std::vector<std::string>& args, std::string_view valued_option) {
+    std::size_t n = 0;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        if (!valued_option.empty() && args[i] == valued_option) {
+            ++i;
+        } else if (args[i].empty() || args[i][0] != '-' || args[i] == "-") {
+            ++n;
+        }
+    }
+    return n;
+}
 } // namespace
 
 core::Expected<ParseResult, core::Error> ArgParser::parse(const std::vector<std::string>& args) const {
     ParseResult result;
+    std::vector<std::string> positionals;
+    // A leading subcommand word followed by paths is a search for that word, as
+    // is any word after `--`: `zenithsearch tune notes.txt` searches notes.txt.
+    // decode takes one input file, so it needs two paths or `--` to be searched.
+    if (!args.empty() && args[0] == "tune" && count_operands(args, "--output") == 0) {
+        result.run_tune = true;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--help") {
+                result.show_help = true;
+            } else if (args[i] == "--output") {
+                if (i + 1 >= args.size() || args[i + 1].empty()) return core::Error{"missing value for --output"};
+                result.tune_output = args[++i];
+            } else {
+                return core::Error{"unknown tune option: " + args[i]};
+            }
+        }
+        return result;
+    }
+    if (!args.empty() && args[0] == "decode" && count_operands(args, {}) <= 1) {
+        result.run_decode = true;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--help") {
+                result.show_help = true;
+            } else if (args[i] == "--json") {
+                result.request.output_format = core::OutputFormat::Jsonl;
+            } else if (!args[i].empty() && args[i][0] == '-' && args[i] != "-") {
+                return core::Error{"unknown decode option: " + args[i]};
+            } else {
+                result.decode_input = args[i];
+            }
+        }
+        return result;
+    }
     for (std::size_t i = 0; i < args.size(); ++i) {
         const auto& arg = args[i];
+        if (arg == "--") {
+            // The rest is the pattern and paths, even when they start with '-'.
+            positionals.insert(positionals.end(), args.begin() + static_cast<std::ptrdiff_t>(i) + 1, args.end());
+            break;
+        }
         if (arg == "--help") {
             result.show_help = true;
             return result;
@@ -49,6 +145,22 @@ core::Expected<ParseResult, core::Error> ArgParser::parse(const std::vector<std:
             result.request.no_ignore = true;
             continue;
         }
+        if (arg == "--no-dedup") {
+            result.request.dedup_files = false;
+            continue;
+        }
+        if (arg == "--numa") {
+            result.request.numa = true;
+            continue;
+        }
+        if (arg == "--small-files-first") {
+            result.request.small_files_first = true;
+            continue;
+        }
+        if (arg == "--dedup-content") {
+            result.request.dedup_content = true;
+            continue;
+        }
         if (arg == "--count") {
             if (result.request.output_mode == core::OutputMode::FilesWithMatches) {
                 return core::Error{"--count conflicts with --files-with-matches"};
@@ -64,7 +176,15 @@ core::Expected<ParseResult, core::Error> ArgParser::parse(const std::vector<std:
             continue;
         }
         if (arg == "--json") {
-            result.request.json_output = true;
+            result.request.output_format = core::OutputFormat::Jsonl;
+            continue;
+        }
+        if (arg == "--stats") {
+            result.show_stats = true;
+            continue;
+        }
+        if (arg == "-q" || arg == "--quiet") {
+            result.request.quiet = true;
             continue;
         }
         if (arg == "--no-snippet") {
@@ -72,9 +192,11 @@ core::Expected<ParseResult, core::Error> ArgParser::parse(const std::vector<std:
             continue;
         }
 
-        if (arg == "--ext" || arg == "--max-bytes" || arg == "--binary" || arg == "--mmap" || arg == "--threads" ||
-            arg == "--stable-output" || arg == "--algo" || arg == "--exclude" || arg == "--exclude-dir" || arg == "--glob" ||
-            arg == "--follow-symlinks" || arg == "--max-matches" || arg == "--max-snippet-bytes") {
+        if (arg == "--ext" || arg == "--max-bytes" || arg == "--binary" || arg == "--encoding" || arg == "--fuzzy" || arg == "--format" || arg == "--mmap" ||
+            arg == "--cache-policy" || arg == "--mmap-window" || arg == "--threads" || arg == "--io-threads" || arg == "--stable-output" || arg == "--algo" || arg == "--exclude" ||
+            arg == "--exclude-dir" || arg == "--glob" || arg == "--follow-symlinks" || arg == "--max-matches" || arg == "--max-snippet-bytes" ||
+            arg == "--trace" || arg == "--max-memory" || arg == "--max-total-matches" || arg == "--profile" || arg == "--cache" ||
+            arg == "--cache-max" || arg == "--queries-from" || arg == "--timeout") {
             if (i + 1 >= args.size()) {
                 return core::Error{"missing value for " + arg};
             }
@@ -96,39 +218,92 @@ core::Expected<ParseResult, core::Error> ArgParser::parse(const std::vector<std:
                 auto parsed = parse_u64(value, "--threads");
                 if (!parsed) return parsed.error();
                 result.request.threads = static_cast<std::size_t>(parsed.value());
+            } else if (arg == "--io-threads") {
+                auto parsed = parse_u64(value, "--io-threads");
+                if (!parsed) return parsed.error();
+                result.request.io_threads = static_cast<std::size_t>(parsed.value());
+            } else if (arg == "--fuzzy") {
+                auto parsed = parse_u64(value, "--fuzzy");
+                if (!parsed) return parsed.error();
+                result.request.fuzzy_edits = static_cast<std::size_t>(parsed.value());
             } else if (arg == "--max-matches") {
                 auto parsed = parse_u64(value, "--max-matches");
                 if (!parsed) return parsed.error();
                 result.request.max_matches_per_file = static_cast<std::size_t>(parsed.value());
+            } else if (arg == "--max-total-matches") {
+                auto parsed = parse_u64(value, "--max-total-matches");
+                if (!parsed) return parsed.error();
+                if (parsed.value() == 0) return core::Error{"--max-total-matches must be at least 1"};
+                result.request.max_total_matches = static_cast<std::size_t>(parsed.value());
             } else if (arg == "--max-snippet-bytes") {
                 auto parsed = parse_u64(value, "--max-snippet-bytes");
                 if (!parsed) return parsed.error();
                 result.request.max_snippet_bytes = static_cast<std::size_t>(parsed.value());
+            } else if (arg == "--timeout") {
+                auto parsed = parse_duration(value, "--timeout");
+                if (!parsed) return parsed.error();
+                result.request.timeout = parsed.value();
+            } else if (arg == "--max-memory") {
+                auto parsed = parse_size(value, "--max-memory", SIZE_MAX);
+                if (!parsed) return parsed.error();
+                result.request.max_memory_bytes = static_cast<std::size_t>(parsed.value());
             } else if (arg == "--binary") {
                 if (value == "skip") result.request.binary_mode = core::BinaryMode::Skip;
                 else if (value == "scan") result.request.binary_mode = core::BinaryMode::Scan;
                 else return core::Error{"--binary must be skip or scan"};
+            } else if (arg == "--format") {
+                if (value == "text") result.request.output_format = core::OutputFormat::Human;
+                else if (value == "json") result.request.output_format = core::OutputFormat::Jsonl;
+                else if (value == "binary") result.request.output_format = core::OutputFormat::Binary;
+                else return core::Error{"--format must be text, json, or binary"};
+            } else if (arg == "--encoding") {
+                if (value == "auto") result.request.encoding = core::EncodingMode::Auto;
+                else if (value == "none") result.request.encoding = core::EncodingMode::None;
+                else return core::Error{"--encoding must be auto or none"};
             } else if (arg == "--mmap") {
                 if (value == "auto") result.request.mmap_mode = core::MmapMode::Auto;
                 else if (value == "on") result.request.mmap_mode = core::MmapMode::On;
                 else if (value == "off") result.request.mmap_mode = core::MmapMode::Off;
                 else return core::Error{"--mmap must be auto, on, or off"};
+            } else if (arg == "--mmap-window") {
+                auto parsed = parse_size(value, "--mmap-window", SIZE_MAX);
+                if (!parsed) return parsed.error();
+                result.request.mmap_window_bytes = static_cast<std::size_t>(parsed.value());
+            } else if (arg == "--cache-policy") {
+                if (value == "normal") result.request.cache_policy = core::CachePolicy::Normal;
+                else if (value == "drop") result.request.cache_policy = core::CachePolicy::Drop;
+                else if (value == "direct") result.request.cache_policy = core::CachePolicy::Direct;
+                else return core::Error{"--cache-policy must be normal, drop, or direct"};
             } else if (arg == "--stable-output") {
                 if (value == "on") result.request.stable_output = core::StableOutputMode::On;
                 else if (value == "off") result.request.stable_output = core::StableOutputMode::Off;
                 else return core::Error{"--stable-output must be on or off"};
             } else if (arg == "--algo") {
-                if (value == "auto") result.request.algorithm_mode = core::AlgorithmMode::Auto;
-                else if (value == "naive") result.request.algorithm_mode = core::AlgorithmMode::Naive;
-                else if (value == "boyer_moore") result.request.algorithm_mode = core::AlgorithmMode::BoyerMoore;
-                else if (value == "bmh") result.request.algorithm_mode = core::AlgorithmMode::Bmh;
-                else return core::Error{"--algo must be auto, naive, boyer_moore, or bmh"};
+                const auto mode = core::algorithm_mode_from_name(value);
+                if (!mode.has_value()) return core::Error{"--algo must be auto, naive, boyer_moore, bmh, two_way, short, or rare_byte"};
+                result.request.algorithm_mode = *mode;
             } else if (arg == "--exclude") {
                 result.request.exclude_globs.push_back(value);
             } else if (arg == "--exclude-dir") {
                 result.request.exclude_dirs.push_back(value);
             } else if (arg == "--glob") {
                 result.request.include_globs.push_back(value);
+            } else if (arg == "--trace") {
+                if (value.empty()) return core::Error{"--trace requires a file path"};
+                result.trace_path = value;
+            } else if (arg == "--profile") {
+                if (value.empty()) return core::Error{"--profile requires a file path"};
+                result.profile_path = value;
+            } else if (arg == "--cache") {
+                if (value.empty()) return core::Error{"--cache requires a directory"};
+                result.cache_dir = value;
+            } else if (arg == "--queries-from") {
+                if (value.empty()) return core::Error{"--queries-from requires a file path"};
+                result.queries_path = value;
+            } else if (arg == "--cache-max") {
+                auto parsed = parse_size(value, "--cache-max");
+                if (!parsed) return parsed.error();
+                result.cache_max_bytes = parsed.value();
             } else if (arg == "--follow-symlinks") {
                 if (value == "on") result.request.follow_symlinks = core::FollowSymlinksMode::On;
                 else if (value == "off") result.request.follow_symlinks = core::FollowSymlinksMode::Off;
@@ -141,18 +316,32 @@ core::Expected<ParseResult, core::Error> ArgParser::parse(const std::vector<std:
             return core::Error{"unknown option: " + arg};
         }
 
-        if (result.request.pattern.empty()) result.request.pattern = arg;
-        else result.request.input_paths.push_back(arg);
+        positionals.push_back(arg);
     }
 
-    if (result.request.pattern.empty()) return core::Error{"pattern is required"};
+    // With --queries-from every positional is a path.
+    auto first_path = positionals.begin();
+    if (result.queries_path.empty() && first_path != positionals.end()) result.request.pattern = *first_path++;
+    result.request.input_paths.assign(first_path, positionals.end());
+
+    if (!result.queries_path.empty() && result.request.fuzzy_edits > 0) return core::Error{"--queries-from conflicts with --fuzzy"};
+    if (!result.queries_path.empty() && result.request.output_format == core::OutputFormat::Binary) {
+        return core::Error{"--format binary takes a single pattern, not --queries-from"};
+    }
+    if (result.queries_path.empty() && result.request.pattern.empty()) return core::Error{"pattern is required"};
     if (result.request.input_paths.empty()) return core::Error{"at least one path is required"};
+    if (result.queries_path.empty() && result.request.fuzzy_edits >= result.request.pattern.size()) {
+        return core::Error{"--fuzzy must be smaller than the pattern length"};
+    }
 
     return result;
 }
 
 std::string ArgParser::help_text() {
-    return "Usage: zenithsearch [options] <pattern> <path...>\n"
+    return "Usage: zenithsearch [options] [--] <pattern> <path...>\n"
+           "       zenithsearch --queries-from FILE [options] <path...>\n"
+           "       zenithsearch tune [--output FILE]\n"
+           "       zenithsearch decode [--json] [FILE] (binary results to text or JSONL; stdin by default)\n"
            "Options:\n"
            "  --ext .log,.cpp,.h\n"
            "  --ignore-hidden\n"
@@ -161,18 +350,38 @@ std::string ArgParser::help_text() {
            "  --glob <glob> (repeatable include)\n"
            "  --no-ignore\n"
            "  --follow-symlinks (on|off) [default: off]\n"
+           "  --no-dedup (scan hardlinks and overlapping roots once per path)\n"
+           "  --dedup-content (scan byte-identical files once)\n"
            "  --max-bytes N\n"
            "  --binary (skip|scan) [default: skip]\n"
+           "  --encoding (auto|none) (auto searches UTF-16 files as text) [default: auto]\n"
+           "  --fuzzy K (matches within K edits of the pattern) [default: 0, exact]\n"
+           "  --queries-from FILE (one pattern per line, all searched in one pass)\n"
            "  --count\n"
            "  --files-with-matches\n"
-           "  --json\n"
+           "  --json (same as --format json)\n"
+           "  --format (text|json|binary) [default: text]\n"
+           "  -q, --quiet (no output, stop at first match)\n"
            "  --max-matches N [default: unlimited]\n"
+           "  --max-total-matches N [default: unlimited]\n"
            "  --max-snippet-bytes N [default: 120]\n"
            "  --no-snippet\n"
            "  --mmap (auto|on|off) [default: auto]\n"
-           "  --threads N [default: auto]\n"
+           "  --mmap-window SIZE (K|M|G suffix; map larger files a window at a time, 0 = whole) [default: 0, 256M on 32-bit]\n"
+           "  --cache-policy (normal|drop|direct) (page cache use; direct never maps) [default: normal]\n"
+           "  --threads N (scan workers) [default: auto]\n"
+           "  --io-threads N (read-ahead threads, at most N; 0 = none) [default: auto]\n"
+           "  --numa (pin workers to NUMA nodes with per-node job queues)\n"
+           "  --timeout DURATION (ms|s|m suffix; stop and report completed files, exit 124) [default: none]\n"
+           "  --small-files-first (scan smaller files first; output order unchanged)\n"
            "  --stable-output (on|off) [default: on]\n"
-           "  --algo (auto|naive|boyer_moore|bmh) [default: auto]\n"
+           "  --algo (auto|naive|boyer_moore|bmh|two_way|short|rare_byte) [default: auto]\n"
+           "  --max-memory SIZE (K|M|G suffix) [default: unlimited]\n"
+           "  --stats (print run counters to stderr)\n"
+           "  --trace FILE (Chrome trace-event JSON)\n"
+           "  --profile FILE (tune profile) [default: ZENITHSEARCH_PROFILE or user config dir]\n"
+           "  --cache DIR (reuse per-file results of unchanged files)\n"
+           "  --cache-max SIZE (K|M|G suffix) [default: 256M]\n"
            "  --help\n"
            "  --version\n";
 }
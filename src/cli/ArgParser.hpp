@@ -3,6 +3,7 @@
 #include "core/Expected.hpp"
 #include "core/Types.hpp"
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -10,6 +11,16 @@ namespace zenith::cli {
 
 struct ParseResult {
     core::SearchRequest request;
+    std::string trace_path;
+    std::string queries_path; // --queries-from; empty = the positional pattern
+    std::string profile_path; // --profile; empty = default location, if present
+    bool run_tune{false};     // `zenithsearch tune`
+    std::string tune_output;  // tune --output; empty = default location
+    bool run_decode{false};   // `zenithsearch decode`; --json sets request.output_format
+    std::string decode_input; // decode FILE; empty or "-" = stdin
+    std::string cache_dir;    // --cache; empty = no result cache
+    std::optional<std::uintmax_t> cache_max_bytes;
+    bool show_stats{false};
     bool show_help{false};
     bool show_version{false};
 };
@@ -0,0 +1,56 @@
+#include "BufferPool.hpp"
+
+#include <new>
+
+namespace zenith::core {
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        data_ = other.data_;
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
+std::span<std::byte> BufferPool::Lease::bytes() const {
+    if (data_ == nullptr) return {};
+    return {data_, pool_->buffer_bytes_};
+}
+
+void BufferPool::Lease::reset() {
+    if (data_ != nullptr) pool_->release(data_);
+    data_ = nullptr;
+}
+
+BufferPool::~BufferPool() {
+    for (auto* data : all_) ::operator delete(data, std::align_val_t{kAlignment});
+}
+
+BufferPool::Lease BufferPool::try_acquire() {
+    std::scoped_lock lock(mutex_);
+    if (!free_.empty()) {
+        auto* data = free_.back();
+        free_.pop_back();
+        return {this, data};
+    }
+    if (all_.size() >= count_ || buffer_bytes_ == 0) return {};
+    all_.reserve(count_);
+    free_.reserve(count_); // release() never allocates
+    auto* data = static_cast<std::byte*>(::operator new(buffer_bytes_, std::align_val_t{kAlignment}));
+    all_.push_back(data);
+    return {this, data};
+}
+
+std::size_t BufferPool::allocated() const {
+    std::scoped_lock lock(mutex_);
+    return all_.size();
+}
+
+void BufferPool::release(std::byte* data) {
+    std::scoped_lock lock(mutex_);
+    free_.push_back(data);
+}
+
+} // namespace zenith::core
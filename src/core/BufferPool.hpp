@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace zenith::core {
+
+// Fixed set of page-aligned buffers handed from the I/O stage to the scan stage.
+// Buffers are allocated on first use, so each is first touched by the thread
+// that fills it. All members are thread-safe.
+class BufferPool {
+public:
+    static constexpr std::size_t kAlignment = 4096;
+
+    // A buffer on loan; returns it to the pool when destroyed. Empty when the pool ran out.
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept : pool_(other.pool_), data_(other.data_) { other.data_ = nullptr; }
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { reset(); }
+
+        explicit operator bool() const { return data_ != nullptr; }
+        std::span<std::byte> bytes() const;
+        void reset();
+
+    private:
+        friend class BufferPool;
+        Lease(BufferPool* pool, std::byte* data) : pool_(pool), data_(data) {}
+        BufferPool* pool_{nullptr};
+        std::byte* data_{nullptr};
+    };
+
+    BufferPool(std::size_t count, std::size_t buffer_bytes) : count_(count), buffer_bytes_(buffer_bytes) {}
+    ~BufferPool();
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Never blocks: an empty lease means every buffer is in use.
+    Lease try_acquire();
+
+    std::size_t buffer_bytes() const { return buffer_bytes_; }
+    std::size_t allocated() const;
+
+private:
+    void release(std::byte* data);
+
+    std::size_t count_;
+    std::size_t buffer_bytes_;
+    mutable std::mutex mutex_;
+    std::vector<std::byte*> all_;
+    std::vector<std::byte*> free_;
+};
+
+} // namespace zenith::core
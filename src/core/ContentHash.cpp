@@ -0,0 +1,83 @@
+#include "ContentHash.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace zenith::core {
+namespace {
+
+constexpr std::uint64_t kP1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t kP2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t kP3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t kP4 = 0x85EBCA77C2B2AE63ULL;
+constexpr std::uint64_t kP5 = 0x27D4EB2F165667C5ULL;
+
+// Native-order reads: digests are only compared within one process. On
+// little-endian hosts the values match reference XXH64.
+
+std::uint64_t read64(const std::byte* p) {
+    std::uint64_t v = 0;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::uint32_t read32(const std::byte* p) {
+    std::uint32_t v = 0;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::uint64_t round(std::uint64_t acc, std::uint64_t input) { return std::rotl(acc + input * kP2, 31) * kP1; }
+
+std::uint64_t merge(std::uint64_t h, std::uint64_t lane) { return (h ^ round(0, lane)) * kP1 + kP4; }
+
+struct Lanes {
+    std::uint64_t v[4];
+    explicit Lanes(std::uint64_t seed) : v{seed + kP1 + kP2, seed + kP2, seed, seed - kP1} {}
+};
+
+// XXH64 after the 32-byte stripes: lane merge, tail and avalanche.
+std::uint64_t finish(const Lanes& lanes, std::uint64_t seed, const std::byte* tail, std::size_t tail_len, std::size_t total_len) {
+    std::uint64_t h = 0;
+    if (total_len >= 32) {
+        const auto& v = lanes.v;
+        h = std::rotl(v[0], 1) + std::rotl(v[1], 7) + std::rotl(v[2], 12) + std::rotl(v[3], 18);
+        for (const auto lane : v) h = merge(h, lane);
+    } else {
+        h = seed + kP5;
+    }
+    h += total_len;
+    std::size_t i = 0;
+    for (; i + 8 <= tail_len; i += 8) h = std::rotl(h ^ round(0, read64(tail + i)), 27) * kP1 + kP4;
+    if (i + 4 <= tail_len) {
+        h = std::rotl(h ^ (static_cast<std::uint64_t>(read32(tail + i)) * kP1), 23) * kP2 + kP3;
+        i += 4;
+    }
+    for (; i < tail_len; ++i) h = std::rotl(h ^ (static_cast<std::uint64_t>(tail[i]) * kP5), 11) * kP1;
+    h ^= h >> 33;
+    h *= kP2;
+    h ^= h >> 29;
+    h *= kP3;
+    h ^= h >> 32;
+    return h;
+}
+
+} // namespace
+
+ContentHash hash_content(std::span<const std::byte> bytes) {
+    Lanes a(0);
+    Lanes b(1);
+    const std::byte* p = bytes.data();
+    const std::size_t n = bytes.size();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int k = 0; k < 4; ++k) {
+            const auto word = read64(p + i + 8 * k);
+            a.v[k] = round(a.v[k], word);
+            b.v[k] = round(b.v[k], word);
+        }
+    }
+    return {finish(a, 0, p + i, n - i, n), finish(b, 1, p + i, n - i, n)};
+}
+
+} // namespace zenith::core
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace zenith::core {
+
+// 128-bit content digest: two XXH64 digests (seeds 0 and 1) computed in one
+// pass. Used to recognise byte-identical files, so it is fast rather than
+// collision resistant against crafted input.
+struct ContentHash {
+    std::uint64_t lo{0};
+    std::uint64_t hi{0};
+    auto operator<=>(const ContentHash&) const = default;
+};
+
+ContentHash hash_content(std::span<const std::byte> bytes);
+
+} // namespace zenith::core
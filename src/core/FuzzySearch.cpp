@@ -0,0 +1,211 @@
+#include "FuzzySearch.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <optional>
+
+namespace zenith::core {
+namespace {
+
+using Word = std::uint64_t;
+constexpr Word kBlockHigh = Word{1} << 63;
+
+// One text column of one 64-row block (Hyyrö's block formulation of Myers'
+// algorithm). `hin` is the horizontal delta entering the block's top row; the
+// return value is the delta leaving its row `high`.
+inline int advance(Word& pv, Word& mv, Word eq, int hin, Word high) {
+    const Word hin_neg = static_cast<Word>(hin < 0);
+    const Word xv = eq | mv;
+    eq |= hin_neg;
+    const Word xh = (((eq & pv) + pv) ^ pv) | eq;
+    Word ph = mv | ~(xh | pv);
+    Word mh = pv & xh;
+    const int hout = static_cast<int>((ph & high) != 0) - static_cast<int>((mh & high) != 0);
+    ph = (ph << 1) | static_cast<Word>(hin > 0);
+    mh = (mh << 1) | hin_neg;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+} // namespace
+
+FuzzySearcher::Automaton::Automaton(std::string_view pattern)
+    : size(pattern.size()), blocks((pattern.size() + 63) / 64), last_high(Word{1} << ((pattern.size() + 63) % 64)),
+      peq(blocks * 256, 0) {
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        peq[(i / 64) * 256 + static_cast<unsigned char>(pattern[i])] |= Word{1} << (i % 64);
+    }
+}
+
+template <typename It, typename OnScore>
+void FuzzySearcher::Automaton::run(It first, It last, bool anchored, OnScore&& on_score) const {
+    // Search mode keeps row 0 at distance 0 (a match may start anywhere);
+    // anchored mode charges one per text byte skipped.
+    const int hin = anchored ? 1 : 0;
+    auto score = static_cast<std::ptrdiff_t>(size);
+    if (blocks == 1) {
+        Word pv = ~Word{0};
+        Word mv = 0;
+        for (std::size_t j = 0; first != last; ++first, ++j) {
+            score += advance(pv, mv, peq[static_cast<unsigned char>(*first)], hin, last_high);
+            if (!on_score(j, static_cast<std::size_t>(score))) return;
+        }
+        return;
+    }
+    std::vector<Word> pv(blocks, ~Word{0});
+    std::vector<Word> mv(blocks, 0);
+    for (std::size_t j = 0; first != last; ++first, ++j) {
+        const Word* eq = peq.data() + static_cast<unsigned char>(*first);
+        int h = hin;
+        for (std::size_t b = 0; b + 1 < blocks; ++b) h = advance(pv[b], mv[b], eq[b * 256], h, kBlockHigh);
+        score += advance(pv[blocks - 1], mv[blocks - 1], eq[(blocks - 1) * 256], h, last_high);
+        if (!on_score(j, static_cast<std::size_t>(score))) return;
+    }
+}
+
+FuzzySearcher::FuzzySearcher(std::string_view pattern, std::size_t max_edits, const ISearchAlgorithm& literal)
+    : pattern_(pattern), max_edits_(max_edits), literal_(literal), forward_(pattern),
+      reverse_(std::string(pattern.rbegin(), pattern.rend())) {
+    const std::size_t parts = max_edits_ + 1;
+    if (pattern_.size() / parts < kMinPieceBytes) return;
+    const std::string_view whole = pattern_;
+    for (std::size_t i = 0; i < parts; ++i) {
+        const std::size_t begin = i * pattern_.size() / parts;
+        const std::size_t end = (i + 1) * pattern_.size() / parts;
+        pieces_.emplace_back(begin, whole.substr(begin, end - begin));
+    }
+}
+
+std::size_t FuzzySearcher::longest_piece(std::size_t pattern_size, std::size_t max_edits) {
+    const std::size_t parts = max_edits + 1;
+    return (pattern_size + parts - 1) / parts;
+}
+
+FuzzyScan FuzzySearcher::find(std::string_view text, bool partial, std::size_t done) const {
+    FuzzyScan out;
+    if (pieces_.empty()) {
+        scan_window(text, 0, text.size(), partial, done, out);
+        return out;
+    }
+    // A match holding piece (offset o) at text position p spans at most
+    // [p - o - k, p - o + m + k), so only those windows need the automaton.
+    const std::size_t m = pattern_.size();
+    const std::size_t k = max_edits_;
+    std::vector<std::pair<std::size_t, std::size_t>> windows;
+    std::size_t covered = 0;
+    for (const auto& [offset, piece] : pieces_) {
+        for (const std::size_t p : literal_.find_all(text, piece)) {
+            const std::size_t lead = offset + k;
+            const std::size_t begin = p > lead ? p - lead : 0;
+            const std::size_t end = std::min(text.size(), p - offset + m + k);
+            windows.emplace_back(begin, end);
+            covered += end - begin;
+        }
+        // Short pieces in dense text: verifying everything is cheaper.
+        if (covered > text.size()) {
+            scan_window(text, 0, text.size(), partial, done, out);
+            return out;
+        }
+    }
+    std::sort(windows.begin(), windows.end());
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    bool open = false;
+    for (const auto& [b, e] : windows) {
+        if (open && b <= end) {
+            end = std::max(end, e);
+            continue;
+        }
+        if (open) scan_window(text, begin, end, partial, done, out);
+        begin = b;
+        end = e;
+        open = true;
+    }
+    if (open) scan_window(text, begin, end, partial, done, out);
+    return out;
+}
+
+void FuzzySearcher::scan_window(std::string_view text, std::size_t from, std::size_t to, bool partial, std::size_t done,
+                                FuzzyScan& out) const {
+    const std::size_t m = pattern_.size();
+    auto gap = [m](const FuzzyMatch& match) {
+        const std::size_t len = match.end - match.start;
+        return len > m ? len - m : m - len;
+    };
+    // A closed run becomes a match only once no later run can overlap it; of
+    // overlapping ones the closest to the pattern wins. `pending_first` is the
+    // first end of the earliest run the pending match was chosen against.
+    std::optional<FuzzyMatch> pending;
+    std::size_t pending_first = 0;
+    bool in_run = false;
+    std::size_t first_end = 0;
+    std::size_t best_end = 0;
+    std::size_t best = 0;
+    auto close = [&] {
+        in_run = false;
+        if (best_end < done) return;
+        const FuzzyMatch match{match_start(text, from, best_end, best), best_end + 1, best};
+        if (pending.has_value() && match.start < pending->end) {
+            if (match.distance < pending->distance || (match.distance == pending->distance && gap(match) < gap(*pending))) pending = match;
+            return;
+        }
+        if (pending.has_value()) out.matches.push_back(*pending);
+        pending = match;
+        pending_first = first_end;
+    };
+    forward_.run(text.begin() + static_cast<std::ptrdiff_t>(from), text.begin() + static_cast<std::ptrdiff_t>(to),
+                 false, [&](std::size_t j, std::size_t distance) {
+                     const std::size_t at = from + j;
+                     if (distance <= max_edits_) {
+                         if (!in_run || distance < best) {
+                             if (!in_run) first_end = at;
+                             best_end = at;
+                             best = distance;
+                         }
+                         in_run = true;
+                     } else if (in_run) {
+                         close();
+                     }
+                     return true;
+                 });
+    // More text could extend the open run, or start one that overlaps the
+    // pending match (which needs an end before pending->end + context() - 1).
+    if (partial && to == text.size()) {
+        if (in_run) {
+            out.open_end = pending.has_value() ? pending_first : first_end;
+            return;
+        }
+        if (pending.has_value() && pending->end + context() - 1 > text.size()) {
+            out.open_end = pending_first;
+            return;
+        }
+    }
+    if (in_run) close();
+    if (pending.has_value()) out.matches.push_back(*pending);
+}
+
+std::size_t FuzzySearcher::match_start(std::string_view text, std::size_t from, std::size_t end,
+                                       std::size_t distance) const {
+    // Distances of the reversed pattern against text ending at `end`, growing
+    // leftwards; of the lengths that reach `distance`, prefer the one closest to
+    // the pattern size.
+    const std::size_t m = pattern_.size();
+    const std::size_t limit = std::min(end + 1 - from, context());
+    const auto last = std::make_reverse_iterator(text.begin() + static_cast<std::ptrdiff_t>(end + 1));
+    std::size_t length = std::min(m, limit);
+    std::size_t gap = std::numeric_limits<std::size_t>::max();
+    reverse_.run(last, last + static_cast<std::ptrdiff_t>(limit), true, [&](std::size_t j, std::size_t d) {
+        const std::size_t len = j + 1;
+        const std::size_t g = len > m ? len - m : m - len;
+        if (d == distance && g < gap) {
+            gap = g;
+            length = len;
+        }
+        return len < m || g < gap;
+    });
+    return end + 1 - length;
+}
+
+} // namespace zenith::core
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Interfaces.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zenith::core {
+
+// text[start, end) is within `distance` edits of the pattern.
+struct FuzzyMatch {
+    std::size_t start{0};
+    std::size_t end{0};
+    std::size_t distance{0};
+};
+
+struct FuzzyScan {
+    std::vector<FuzzyMatch> matches;
+    // With `partial`, the first end position of a match that may continue past
+    // the text; it is held back for the next call (see FuzzySearcher::find).
+    std::optional<std::size_t> open_end;
+};
+
+// Approximate substring search allowing up to k insertions, deletions and
+// substitutions, with Myers' bit-parallel edit distance (one 64-bit word for
+// patterns up to 64 bytes, blocks of words beyond). End positions within k of
+// the pattern that follow each other form one match, reported at its closest end;
+// a reverse pass over the reversed pattern then finds where it starts.
+//
+// Every such match contains one of k + 1 pattern pieces exactly (pigeonhole), so
+// when pieces are at least kMinPieceBytes long only windows around exact piece
+// occurrences, found with the literal kernel, are verified. Immutable after
+// construction; find() is thread-safe.
+class FuzzySearcher {
+public:
+    static constexpr std::size_t kMinPieceBytes = 3;
+
+    // Requires max_edits < pattern.size().
+    FuzzySearcher(std::string_view pattern, std::size_t max_edits, const ISearchAlgorithm& literal);
+
+    // Length of the longest prefilter piece, to pick the literal kernel.
+    static std::size_t longest_piece(std::size_t pattern_size, std::size_t max_edits);
+
+    // Matches in `text`, ordered by end. With `partial` (more text follows), a
+    // match that more text could still change is not reported; a later call must
+    // start at or before open_end + 1 - context() to report it, passing `done` so
+    // matches ending at or before it, reported by earlier calls, are skipped.
+    FuzzyScan find(std::string_view text, bool partial = false, std::size_t done = 0) const;
+
+    // Longest text a match can span: pattern size plus k.
+    std::size_t context() const { return pattern_.size() + max_edits_; }
+    std::size_t max_edits() const { return max_edits_; }
+
+private:
+    using Word = std::uint64_t;
+
+    // Match-vector tables of one pattern, one 256-entry table per 64-byte block.
+    struct Automaton {
+        explicit Automaton(std::string_view pattern);
+        // Calls on_score(j, distance) after each byte of [first, last). Search
+        // mode lets a match start anywhere; anchored mode (the reverse pass)
+        // makes it start at `first`.
+        template <typename It, typename OnScore>
+        void run(It first, It last, bool anchored, OnScore&& on_score) const;
+
+        std::size_t size{0};
+        std::size_t blocks{0};
+        Word last_high{0};
+        std::vector<Word> peq;
+    };
+
+    void scan_window(std::string_view text, std::size_t from, std::size_t to, bool partial, std::size_t done, FuzzyScan& out) const;
+    std::size_t match_start(std::string_view text, std::size_t from, std::size_t end, std::size_t distance) const;
+
+    std::string pattern_;
+    std::size_t max_edits_;
+    const ISearchAlgorithm& literal_;
+    Automaton forward_;
+    Automaton reverse_;
+    // (offset in the pattern, piece) for the prefilter; empty when pieces are too short.
+    std::vector<std::pair<std::size_t, std::string_view>> pieces_;
+};
+
+} // namespace zenith::core
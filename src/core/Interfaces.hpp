@@ -1,12 +1,16 @@
 #pragma once
 
 #include "Expected.hpp"
+#include "PathTable.hpp"
 #include "Types.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <span>
 #include <stop_token>
 #include <string>
@@ -19,15 +23,18 @@ class ISearchAlgorithm {
 public:
     virtual ~ISearchAlgorithm() = default;
     virtual std::vector<std::size_t> find_all(std::string_view buffer, std::string_view pattern) const = 0;
+    // Number of (overlapping) occurrences; kernels override this to count without
+    // materializing positions.
+    virtual std::size_t count_all(std::string_view buffer, std::string_view pattern) const {
+        return find_all(buffer, pattern).size();
+    }
 };
 
 class IFileEnumerator {
 public:
     using ErrorCallback = std::function<void(const Error&)>;
     virtual ~IFileEnumerator() = default;
-    virtual std::vector<FileItem> enumerate(const SearchRequest& request,
-                                            std::stop_token stop_token,
-                                            const ErrorCallback& on_error) const = 0;
+    virtual FileList enumerate(const SearchRequest& request, std::stop_token stop_token, const ErrorCallback& on_error) const = 0;
 };
 
 class IFileReader {
@@ -38,20 +45,53 @@ public:
                                               std::size_t chunk_size,
                                               std::stop_token stop_token,
                                               const std::function<Expected<void, Error>(const std::string&)>& on_chunk) const = 0;
+    // Reads the whole file into `buffer` and returns its length; a length larger
+    // than the buffer means the file did not fit, and is its size when the reader
+    // learns that on open. Readers override this to read straight into the buffer.
+    virtual Expected<std::size_t, Error> read_into(const std::string& path, std::span<std::byte> buffer) const {
+        std::size_t length = 0;
+        auto read = read_chunks(path, buffer.size() + 1, {}, [&](const std::string& chunk) -> Expected<void, Error> {
+            if (chunk.size() > buffer.size() - length) {
+                length = buffer.size() + 1;
+                return Error{"file does not fit"};
+            }
+            std::memcpy(buffer.data() + length, chunk.data(), chunk.size());
+            length += chunk.size();
+            return {};
+        });
+        if (length > buffer.size()) return length;
+        if (!read) return read.error();
+        return length;
+    }
+    // Hints that `path` will be read soon; the default does nothing.
+    virtual void prefetch(const std::string& /*path*/) const {}
 };
 
 class IMappedFile {
 public:
     virtual ~IMappedFile() = default;
+    // The whole file, or the current window of a windowed mapping.
     virtual std::span<const std::byte> bytes() const = 0;
     virtual std::uint64_t size() const = 0;
     virtual const std::string& path() const = 0;
+    // Bytes [offset, offset + length) of the file, clipped to its size. A windowed
+    // mapping maps them in place of its previous window, which becomes invalid;
+    // the default serves them from a whole-file mapping.
+    virtual Expected<std::span<const std::byte>, Error> map_window(std::uint64_t offset, std::size_t length) {
+        const auto all = bytes();
+        const auto start = static_cast<std::size_t>(std::min<std::uint64_t>(offset, all.size()));
+        return all.subspan(start, std::min(length, all.size() - start));
+    }
 };
 
 class IMappedFileProvider {
 public:
     virtual ~IMappedFileProvider() = default;
     virtual Expected<std::unique_ptr<IMappedFile>, Error> open(const std::string& path) const = 0;
+    // Opens `path` for map_window without mapping any of it up front, so address
+    // space and resident memory stay bounded by the window. The default maps the
+    // whole file.
+    virtual Expected<std::unique_ptr<IMappedFile>, Error> open_windowed(const std::string& path) const { return open(path); }
 };
 
 class IOutputWriter {
@@ -61,6 +101,27 @@ public:
     virtual void write_file_summary(const FileMatchSummary& summary) = 0;
 };
 
+// Per-file results kept across runs (--cache DIR), keyed by content stamp and a
+// query string that covers every request field the result depends on.
+// Implementations must be thread-safe.
+class IResultCache {
+public:
+    virtual ~IResultCache() = default;
+    // nullopt when the file cannot be stamped; such files are never cached.
+    virtual std::optional<FileStamp> stamp(const std::string& path) const = 0;
+    virtual std::optional<FileResult> lookup(const FileStamp& stamp, const std::string& query) = 0;
+    virtual void store(const FileStamp& stamp, const std::string& query, const FileResult& result) = 0;
+};
+
+// NUMA layout used to place workers when SearchRequest::numa is set.
+class ICpuTopology {
+public:
+    virtual ~ICpuTopology() = default;
+    virtual std::size_t node_count() const = 0;
+    // Restricts the calling thread to the CPUs of `node`; false when that is not possible.
+    virtual bool pin_current_thread(std::size_t node) const = 0;
+};
+
 class IErrorWriter {
 public:
     virtual ~IErrorWriter() = default;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Interfaces.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace zenith::core {
+
+// One window of a mapped file, starting at file offset `offset`. It owns the
+// `own` bytes from `first`: a match is reported by the window it starts in. The
+// bytes around them are context shared with the neighbouring windows.
+struct MappedWindow {
+    std::uint64_t offset{0};
+    std::span<const std::byte> bytes;
+    std::size_t first{0};
+    std::size_t own{0};
+};
+
+// Walks a file through IMappedFile::map_window. Window k owns file bytes
+// [k * step, (k + 1) * step) and also maps `before` bytes ahead of them and
+// `after` bytes past them, so a match of up to after + 1 bytes that starts in the
+// owned range lies wholly inside the window. Each window replaces the previous
+// one, so at most before + step + after bytes are mapped at a time.
+class MappedWindowIterator {
+public:
+    MappedWindowIterator(IMappedFile& file, std::size_t step, std::size_t before, std::size_t after)
+        : file_(file), step_(std::max<std::size_t>(step, 1)), before_(before), after_(after) {}
+
+    // The next window; nullopt after the last one.
+    Expected<std::optional<MappedWindow>, Error> next() {
+        if (owned_ >= file_.size()) return std::optional<MappedWindow>{};
+        const std::uint64_t begin = owned_ - std::min<std::uint64_t>(owned_, before_);
+        const auto first = static_cast<std::size_t>(owned_ - begin);
+        auto bytes = file_.map_window(begin, first + step_ + after_);
+        if (!bytes) return bytes.error();
+        const std::size_t own = bytes.value().size() > first ? std::min(step_, bytes.value().size() - first) : 0U;
+        owned_ += step_;
+        return std::optional<MappedWindow>{MappedWindow{begin, bytes.value(), first, own}};
+    }
+
+private:
+    IMappedFile& file_;
+    std::size_t step_;
+    std::size_t before_;
+    std::size_t after_;
+    std::uint64_t owned_{0};
+};
+
+} // namespace zenith::core
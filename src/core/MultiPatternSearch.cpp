@@ -0,0 +1,98 @@
+#include "MultiPatternSearch.hpp"
+
+#include <algorithm>
+
+namespace zenith::core {
+
+MultiPatternSearch::MultiPatternSearch(std::vector<std::string> patterns, std::vector<const ISearchAlgorithm*> kernels)
+    : patterns_(std::move(patterns)), kernels_(std::move(kernels)), automaton_(patterns_.size() > kKernelPatterns) {
+    for (const auto& p : patterns_) longest_ = std::max(longest_, p.size());
+    if (!automaton_) return;
+
+    for (const auto& p : patterns_) {
+        for (const char c : p) {
+            auto& cls = class_[static_cast<unsigned char>(c)];
+            if (cls == 0) cls = static_cast<std::uint16_t>(classes_++);
+        }
+    }
+
+    // Trie of the patterns; next_ holds node ids while it is built.
+    std::vector<std::vector<std::uint32_t>> ends(1);
+    next_.assign(classes_, 0);
+    for (std::size_t i = 0; i < patterns_.size(); ++i) {
+        const auto& p = patterns_[i];
+        if (p.empty()) continue;
+        std::uint32_t node = 0;
+        for (const char c : p) {
+            auto& child = next_[node * classes_ + class_[static_cast<unsigned char>(c)]];
+            if (child == 0) {
+                child = static_cast<std::uint32_t>(ends.size());
+                ends.emplace_back();
+                next_.resize(next_.size() + classes_, 0);
+            }
+            node = next_[node * classes_ + class_[static_cast<unsigned char>(c)]];
+        }
+        ends[node].push_back(static_cast<std::uint32_t>(i));
+    }
+
+    // Breadth first, so a node's failure target is complete before the node. A
+    // row still holds only the node's own children when it is reached; missing
+    // ones take the failure target's transition.
+    const std::size_t nodes = ends.size();
+    std::vector<std::uint32_t> fail(nodes, 0);
+    dict_.assign(nodes, 0);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(nodes);
+    queue.push_back(0);
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const auto node = queue[head];
+        for (std::size_t c = 0; c < classes_; ++c) {
+            auto& slot = next_[node * classes_ + c];
+            const auto via_fail = node == 0 ? 0U : next_[fail[node] * classes_ + c];
+            if (slot == 0) {
+                slot = via_fail;
+                continue;
+            }
+            fail[slot] = via_fail;
+            dict_[slot] = ends[via_fail].empty() ? dict_[via_fail] : via_fail;
+            queue.push_back(slot);
+        }
+    }
+
+    out_start_.assign(nodes + 1, 0);
+    for (std::size_t s = 0; s < nodes; ++s) {
+        out_start_[s + 1] = out_start_[s] + static_cast<std::uint32_t>(ends[s].size());
+        out_.insert(out_.end(), ends[s].begin(), ends[s].end());
+    }
+    // Row offsets instead of node ids, so a step is a single load, with the
+    // emitting nodes flagged so other steps touch nothing else.
+    for (auto& target : next_) {
+        const bool emits = !ends[target].empty() || dict_[target] != 0;
+        target = target * static_cast<std::uint32_t>(classes_) | (emits ? kEmits : 0U);
+    }
+}
+
+void MultiPatternSearch::find(std::string_view buffer, const std::function<void(std::size_t, std::size_t)>& on_match) const {
+    if (!automaton_) {
+        for (std::size_t i = 0; i < patterns_.size(); ++i) {
+            if (patterns_[i].empty()) continue;
+            for (const auto pos : kernels_[i]->find_all(buffer, patterns_[i])) on_match(i, pos);
+        }
+        return;
+    }
+    const auto* data = reinterpret_cast<const unsigned char*>(buffer.data());
+    const std::uint32_t* next = next_.data();
+    std::uint32_t entry = 0;
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        entry = next[(entry & ~kEmits) + class_[data[i]]];
+        if ((entry & kEmits) == 0) continue;
+        for (auto s = (entry & ~kEmits) / static_cast<std::uint32_t>(classes_); s != 0; s = dict_[s]) {
+            for (auto k = out_start_[s]; k < out_start_[s + 1]; ++k) {
+                const auto q = out_[k];
+                on_match(q, i + 1 - patterns_[q].size());
+            }
+        }
+    }
+}
+
+} // namespace zenith::core
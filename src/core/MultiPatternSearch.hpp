@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Interfaces.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zenith::core {
+
+// All occurrences of a batch of literal patterns in one buffer. Small batches run
+// each pattern's own kernel; larger ones make a single pass through an
+// Aho-Corasick automaton, so the cost per byte does not grow with the number of
+// patterns or with the prefixes they share. Immutable after construction;
+// find() is thread-safe.
+class MultiPatternSearch {
+public:
+    // Up to this many patterns run their own kernels.
+    static constexpr std::size_t kKernelPatterns = 8;
+
+    // kernels[i] searches patterns[i]; empty patterns never match.
+    MultiPatternSearch(std::vector<std::string> patterns, std::vector<const ISearchAlgorithm*> kernels);
+
+    // Calls on_match(pattern index, position) for every occurrence, overlapping
+    // ones included, in no particular order.
+    void find(std::string_view buffer, const std::function<void(std::size_t, std::size_t)>& on_match) const;
+
+    const std::vector<std::string>& patterns() const { return patterns_; }
+    std::size_t longest() const { return longest_; }
+
+private:
+    std::vector<std::string> patterns_;
+    std::vector<const ISearchAlgorithm*> kernels_;
+    std::size_t longest_{0};
+    bool automaton_{false};
+    // Bytes that occur in no pattern share class 0; the others get one class each.
+    std::array<std::uint16_t, 256> class_{};
+    std::size_t classes_{1};
+    // Dense transitions, one row of `classes_` entries per trie node (0 is the
+    // root), with failure links folded in. An entry is the next node's row offset,
+    // plus kEmits when a pattern ends there.
+    static constexpr std::uint32_t kEmits = 0x80000000U;
+    std::vector<std::uint32_t> next_;
+    // Patterns ending at each node: out_[out_start_[s], out_start_[s + 1]). `dict_`
+    // is the nearest node on the failure chain with patterns of its own (0 = none).
+    std::vector<std::uint32_t> out_start_;
+    std::vector<std::uint32_t> out_;
+    std::vector<std::uint32_t> dict_;
+};
+
+} // namespace zenith::core
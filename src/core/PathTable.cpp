@@ -0,0 +1,134 @@
+#include "PathTable.hpp"
+
+#include <algorithm>
+
+namespace zenith::core {
+namespace {
+
+#ifdef _WIN32
+constexpr char kPreferredSeparator = '\\';
+bool is_separator(char c) { return c == '/' || c == '\\'; }
+#else
+constexpr char kPreferredSeparator = '/';
+bool is_separator(char c) { return c == '/'; }
+#endif
+
+void append_name_normalized(std::string& out, std::string_view name) {
+    const auto start = out.size();
+    out += name;
+    std::replace(out.begin() + static_cast<std::ptrdiff_t>(start), out.end(), '\\', '/');
+}
+
+} // namespace
+
+PathTable::Node PathTable::make_node(std::uint64_t offset, std::size_t length, PathId parent) {
+    return {static_cast<std::uint32_t>(offset), static_cast<std::uint16_t>(offset >> 32),
+            static_cast<std::uint16_t>(std::min<std::size_t>(length, UINT16_MAX)), parent};
+}
+
+PathId PathTable::add_root(const std::string& raw, const std::string& normalized) {
+    const auto id = static_cast<PathId>(nodes_.size());
+    nodes_.push_back(make_node(roots_.size(), 0, kNoParent));
+    roots_.push_back({raw, normalized});
+    return id;
+}
+
+PathId PathTable::add_child(PathId parent, std::string_view name) {
+    const auto id = static_cast<PathId>(nodes_.size());
+    // Basenames are bounded by the filesystem (255 units); longer input is truncated.
+    nodes_.push_back(make_node(names_.size(), name.size(), parent));
+    names_.insert(names_.end(), name.begin(), name.begin() + nodes_.back().length);
+    return id;
+}
+
+void PathTable::shrink_to_fit() {
+    nodes_.shrink_to_fit();
+    names_.shrink_to_fit();
+    roots_.shrink_to_fit();
+}
+
+std::string PathTable::path(PathId id) const {
+    std::vector<PathId> chain;
+    for (PathId n = id; nodes_[n].parent != kNoParent; n = nodes_[n].parent) chain.push_back(n);
+    PathId root = id;
+    while (nodes_[root].parent != kNoParent) root = nodes_[root].parent;
+
+    std::string out = roots_[nodes_[root].offset()].raw;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        const bool drive_relative = out.size() == 2 && out[1] == ':' && kPreferredSeparator == '\\';
+        if (!out.empty() && !is_separator(out.back()) && !drive_relative) out.push_back(kPreferredSeparator);
+        out += name(nodes_[*it]);
+    }
+    return out;
+}
+
+void PathTable::append_normalized(std::string& out, PathId id, PathId stop) const {
+    thread_local std::vector<PathId> chain;
+    chain.clear();
+    for (PathId n = id; n != stop; n = nodes_[n].parent) chain.push_back(n);
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        const auto& node = nodes_[*it];
+        if (node.parent == kNoParent) {
+            // "./x" is lexically normal as "x", so a "." root contributes nothing
+            // to the paths below it.
+            const auto& root = roots_[node.offset()].normalized;
+            if (chain.size() == 1 || root != ".") out += root;
+            continue;
+        }
+        if (!out.empty() && out.back() != '/') out.push_back('/');
+        append_name_normalized(out, name(node));
+    }
+}
+
+std::string PathTable::normalized(PathId id) const {
+    std::string out;
+    append_normalized(out, id, kNoParent);
+    return out;
+}
+
+bool PathTable::normalized_less(PathId a, PathId b) const {
+    if (a == b) return false;
+    thread_local std::vector<PathId> chain_a;
+    thread_local std::vector<PathId> chain_b;
+    chain_a.clear();
+    chain_b.clear();
+    for (PathId n = a; n != kNoParent; n = nodes_[n].parent) chain_a.push_back(n);
+    for (PathId n = b; n != kNoParent; n = nodes_[n].parent) chain_b.push_back(n);
+
+    thread_local std::string text_a;
+    thread_local std::string text_b;
+    text_a.clear();
+    text_b.clear();
+    if (chain_a.back() != chain_b.back()) {
+        // Different roots (e.g. overlapping inputs): compare the full paths.
+        append_normalized(text_a, a, kNoParent);
+        append_normalized(text_b, b, kNoParent);
+        return text_a < text_b;
+    }
+
+    // Below the deepest shared ancestor both paths continue from identical text,
+    // so comparing the remaining components, each after a '/', is equivalent.
+    auto ia = chain_a.rbegin();
+    auto ib = chain_b.rbegin();
+    while (ia != chain_a.rend() && ib != chain_b.rend() && *ia == *ib) {
+        ++ia;
+        ++ib;
+    }
+    for (; ia != chain_a.rend(); ++ia) {
+        text_a.push_back('/');
+        append_name_normalized(text_a, name(nodes_[*ia]));
+    }
+    for (; ib != chain_b.rend(); ++ib) {
+        text_b.push_back('/');
+        append_name_normalized(text_b, name(nodes_[*ib]));
+    }
+    return text_a < text_b;
+}
+
+std::size_t PathTable::memory_bytes() const {
+    std::size_t total = nodes_.capacity() * sizeof(Node) + names_.capacity() + roots_.capacity() * sizeof(Root);
+    for (const auto& r : roots_) total += r.raw.capacity() + r.normalized.capacity();
+    return total;
+}
+
+} // namespace zenith::core
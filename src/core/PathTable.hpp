@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zenith::core {
+
+// Interned paths for enumerated files: one (parent, basename) node per file or
+// directory, with every name stored once in a shared character arena. Roots keep
+// the input path as given plus its normalized form. Full paths are materialized
+// on demand; the normalized form (the sort and match key) is '/'-joined and
+// lexically normal, the same as before interning.
+class PathTable {
+public:
+    static constexpr PathId kNoParent = UINT32_MAX;
+
+    PathId add_root(const std::string& raw, const std::string& normalized);
+    PathId add_child(PathId parent, std::string_view name);
+
+    // Path as the OS should open it: the root joined with preferred separators.
+    std::string path(PathId id) const;
+    std::string normalized(PathId id) const;
+
+    // Orders by normalized(); paths under the same root are compared from their
+    // deepest shared directory on, without materializing either path.
+    bool normalized_less(PathId a, PathId b) const;
+    bool normalized_equal(PathId a, PathId b) const { return a == b || (!normalized_less(a, b) && !normalized_less(b, a)); }
+
+    std::size_t size() const { return nodes_.size(); }
+    // Drops growth slack once enumeration is done.
+    void shrink_to_fit();
+    // Bytes held by nodes, names and roots (capacity, not just size).
+    std::size_t memory_bytes() const;
+
+private:
+    // 12 bytes: a 48-bit offset into names_ (or an index into roots_ for root
+    // nodes), the basename length and the parent.
+    struct Node {
+        std::uint32_t offset_lo;
+        std::uint16_t offset_hi;
+        std::uint16_t length;
+        PathId parent;
+        std::uint64_t offset() const { return (static_cast<std::uint64_t>(offset_hi) << 32) | offset_lo; }
+    };
+    static Node make_node(std::uint64_t offset, std::size_t length, PathId parent);
+    std::string_view name(const Node& node) const { return {names_.data() + node.offset(), node.length}; }
+    struct Root {
+        std::string raw;
+        std::string normalized;
+    };
+
+    // Appends the normalized text of the nodes below `stop` down to `id`.
+    void append_normalized(std::string& out, PathId id, PathId stop) const;
+
+    std::vector<Node> nodes_;
+    std::vector<char> names_;
+    std::vector<Root> roots_;
+};
+
+struct FileList {
+    PathTable paths;
+    std::vector<FileItem> files;
+};
+
+} // namespace zenith::core
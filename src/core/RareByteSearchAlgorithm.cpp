@@ -0,0 +1,90 @@
+#include "RareByteSearchAlgorithm.hpp"
+
+#include "RareBytes.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace zenith::core {
+namespace {
+
+// Verification may cost at most this many pattern bytes per scanned byte before
+// the prefilter is considered ineffective. Checked only after a short warm-up.
+constexpr std::size_t kMaxVerifyRatio = 4;
+constexpr std::size_t kWarmupBytes = 4096;
+
+// Calls sink(pos) for every occurrence, or hand_off(from) once for the remainder
+// of the buffer if the prefilter proves ineffective. Requires 0 < m <= n.
+template <typename Sink, typename HandOff>
+void scan_rare(std::string_view buffer, std::string_view pattern, Sink&& sink, HandOff&& hand_off) {
+    const char* hay = buffer.data();
+    const std::size_t m = pattern.size();
+    const std::size_t last_start = buffer.size() - m;
+    const auto anchors = select_rare_anchors(pattern);
+    const std::size_t a1 = anchors.rare1;
+    const std::size_t a2 = anchors.rare2;
+    std::size_t verified = 0;
+
+    auto check = [&](std::size_t pos) {
+        verified += m;
+        if (std::memcmp(hay + pos, pattern.data(), m) == 0) sink(pos);
+    };
+    auto ineffective = [&](std::size_t scanned) { return scanned >= kWarmupBytes && verified > kMaxVerifyRatio * scanned; };
+
+    std::size_t i = 0;
+#ifdef ZENITHSEARCH_HAVE_SSE2
+    const __m128i v1 = _mm_set1_epi8(pattern[a1]);
+    const __m128i v2 = _mm_set1_epi8(pattern[a2]);
+    for (; i + 16 <= last_start + 1; i += 16) {
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + a1));
+        const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + a2));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b1, v1), _mm_cmpeq_epi8(b2, v2))));
+        while (mask != 0) {
+            check(i + static_cast<std::size_t>(std::countr_zero(mask)));
+            mask &= mask - 1;
+        }
+        if (ineffective(i + 16)) return hand_off(i + 16);
+    }
+#else
+    while (i <= last_start) {
+        const void* hit = std::memchr(hay + i + a1, pattern[a1], last_start - i + 1);
+        if (hit == nullptr) return;
+        i = static_cast<std::size_t>(static_cast<const char*>(hit) - hay) - a1;
+        if (hay[i + a2] == pattern[a2]) check(i);
+        ++i;
+        if (ineffective(i)) return hand_off(i);
+    }
+#endif
+    for (; i <= last_start; ++i) {
+        if (hay[i + a1] == pattern[a1] && hay[i + a2] == pattern[a2]) check(i);
+    }
+}
+
+} // namespace
+
+std::vector<std::size_t> RareByteSearchAlgorithm::find_all(std::string_view buffer, std::string_view pattern) const {
+    std::vector<std::size_t> positions;
+    if (pattern.empty() || buffer.size() < pattern.size()) {
+        return positions;
+    }
+    scan_rare(
+        buffer, pattern, [&](std::size_t pos) { positions.push_back(pos); },
+        [&](std::size_t from) {
+            for (auto pos : fallback_.find_all(buffer.substr(from), pattern)) positions.push_back(from + pos);
+        });
+    return positions;
+}
+
+std::size_t RareByteSearchAlgorithm::count_all(std::string_view buffer, std::string_view pattern) const {
+    std::size_t count = 0;
+    if (pattern.empty() || buffer.size() < pattern.size()) {
+        return count;
+    }
+    scan_rare(
+        buffer, pattern, [&](std::size_t) { ++count; }, [&](std::size_t from) { count += fallback_.count_all(buffer.substr(from), pattern); });
+    return count;
+}
+
+} // namespace zenith::core
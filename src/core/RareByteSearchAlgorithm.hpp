@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Interfaces.hpp"
+#include "TwoWaySearchAlgorithm.hpp"
+
+namespace zenith::core {
+
+// Prefilter kernel for longer patterns: finds candidates by the pattern's two
+// rarest bytes (SSE2 when available, memchr otherwise) and verifies them with
+// memcmp. If candidates turn out to be frequent, so the prefilter stops paying for
+// itself, the rest of the buffer is handed to Two-Way, which keeps repetitive
+// inputs linear.
+class RareByteSearchAlgorithm final : public ISearchAlgorithm {
+public:
+    std::vector<std::size_t> find_all(std::string_view buffer, std::string_view pattern) const override;
+    std::size_t count_all(std::string_view buffer, std::string_view pattern) const override;
+
+private:
+    TwoWaySearchAlgorithm fallback_;
+};
+
+} // namespace zenith::core
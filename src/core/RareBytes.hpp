@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace zenith::core {
+
+// Frequency rank of every byte value: 0 is the rarest, 255 the most common.
+// Derived from byte counts over C/C++ headers, package documentation and system
+// logs (about 420 MB), so it favours letters, whitespace and code punctuation.
+inline constexpr std::array<std::uint8_t, 256> kByteFrequencyRank = {
+      0,   1,   2,   3,   4,   5,   6,  46,   7, 204, 240,   8, 104, 157,   9,  10,
+     11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  50,  21,  22,  23,  24,  25,
+    255, 161, 205, 194, 159, 156, 165, 177, 221, 222, 223, 187, 217, 229, 235, 246,
+    231, 228, 220, 203, 200, 202, 196, 193, 195, 199, 225, 188, 207, 191, 209, 155,
+    175, 214, 192, 216, 201, 224, 197, 190, 181, 210, 172, 178, 213, 198, 212, 208,
+    206, 162, 211, 230, 218, 189, 176, 173, 185, 171, 163, 180, 174, 179, 154, 241,
+    183, 249, 236, 244, 242, 254, 234, 233, 237, 251, 186, 227, 245, 238, 248, 250,
+    243, 184, 247, 252, 253, 239, 226, 215, 219, 232, 182, 170, 164, 169, 158,  26,
+    166, 141, 153, 108, 120, 115, 112, 103, 118, 101,  76,  72, 106, 117,  77,  84,
+    109,  83,  96, 116, 167,  97, 121,  91, 124, 136,  98,  99, 146, 135,  69, 133,
+    147, 138, 149, 111, 144, 107, 105, 143, 139, 148,  75, 137, 102, 132,  78,  89,
+    123, 142, 110, 130, 114, 113, 151, 131, 128,  92, 127, 134, 150, 122, 119,  88,
+     27,  28, 152, 160, 125, 140,  47,  65,  73,  68,  62,  66,  87,  29,  80,  74,
+    145, 126,  51,  30,  31,  63,  48,  79,  67,  70,  32,  54,  33,  34,  35,  52,
+     85, 129, 168,  86,  93, 100,  94,  82,  95,  90,  49,  64,  61,  53,  36,  71,
+     81,  37,  38,  55,  56,  39,  59,  40,  57,  41,  42,  43,  58,  60,  44,  45,
+};
+
+// Positions of the two rarest bytes of a pattern. The literal kernels look for
+// these first, so common bytes such as '_' or 'E' do not create a flood of false
+// candidates. `rare1` is the rarest; `rare2` differs from it whenever the pattern
+// has more than one byte.
+struct RareAnchors {
+    std::size_t rare1{0};
+    std::size_t rare2{0};
+};
+
+inline RareAnchors select_rare_anchors(std::string_view pattern) {
+    RareAnchors out;
+    if (pattern.size() < 2) return out;
+    // Command-line patterns cannot contain NUL; it only appears in UTF-16 encoded
+    // patterns, where it is the most common byte of the text being searched.
+    auto rank = [&](std::size_t i) { return pattern[i] == '\0' ? 256 : int{kByteFrequencyRank[static_cast<unsigned char>(pattern[i])]}; };
+    out.rare1 = 0;
+    out.rare2 = 1;
+    if (rank(1) < rank(0)) {
+        out.rare1 = 1;
+        out.rare2 = 0;
+    }
+    for (std::size_t i = 2; i < pattern.size(); ++i) {
+        if (rank(i) < rank(out.rare1)) {
+            out.rare2 = out.rare1;
+            out.rare1 = i;
+        } else if (rank(i) < rank(out.rare2)) {
+            out.rare2 = i;
+        }
+    }
+    return out;
+}
+
+} // namespace zenith::core
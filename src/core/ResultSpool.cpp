@@ -0,0 +1,198 @@
+#include "ResultSpool.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace zenith::core {
+namespace {
+
+// Heap bytes of one spill index entry: a std::map node holding a job and an offset.
+constexpr std::size_t kSpillEntryBytes = 4 * sizeof(void*) + sizeof(std::size_t) + sizeof(std::uint64_t);
+
+std::size_t heap_bytes(const std::string& s) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+}
+
+void put_varint(std::string& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void put_bytes(std::string& out, const std::string& s) {
+    put_varint(out, s.size());
+    out += s;
+}
+
+bool get_varint(std::FILE* f, std::uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int c = std::getc(f);
+        if (c == EOF) return false;
+        v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+bool get_bytes(std::FILE* f, std::string& s) {
+    std::uint64_t len = 0;
+    if (!get_varint(f, len)) return false;
+    s.resize(static_cast<std::size_t>(len));
+    return len == 0 || std::fread(s.data(), 1, s.size(), f) == s.size();
+}
+
+// Record layout: job, path, count, flags, match count, then (offset, snippet,
+// query) triples, query count, then (query, count) pairs.
+void encode(std::string& out, std::size_t job, const FileResult& fr) {
+    put_varint(out, job);
+    put_bytes(out, fr.path);
+    put_varint(out, fr.count);
+    out.push_back(static_cast<char>(fr.binary ? 1 : 0));
+    put_varint(out, fr.matches.size());
+    for (const auto& m : fr.matches) {
+        put_varint(out, m.offset);
+        put_bytes(out, m.snippet);
+        put_varint(out, m.query);
+    }
+    put_varint(out, fr.query_counts.size());
+    for (const auto& q : fr.query_counts) {
+        put_varint(out, q.query);
+        put_varint(out, q.count);
+    }
+}
+
+bool decode_body(std::FILE* f, FileResult& fr) {
+    std::uint64_t count = 0;
+    std::uint64_t n = 0;
+    if (!get_bytes(f, fr.path) || !get_varint(f, count)) return false;
+    const int flags = std::getc(f);
+    if (flags == EOF || !get_varint(f, n)) return false;
+    fr.count = static_cast<std::size_t>(count);
+    fr.binary = (flags & 1) != 0;
+    fr.any_match = true;
+    fr.completed = true;
+    fr.matches.resize(static_cast<std::size_t>(n));
+    std::uint64_t value = 0;
+    for (auto& m : fr.matches) {
+        if (!get_varint(f, m.offset) || !get_bytes(f, m.snippet) || !get_varint(f, value)) return false;
+        m.query = static_cast<std::size_t>(value);
+    }
+    if (!get_varint(f, n)) return false;
+    fr.query_counts.resize(static_cast<std::size_t>(n));
+    for (auto& q : fr.query_counts) {
+        if (!get_varint(f, value)) return false;
+        q.query = static_cast<std::size_t>(value);
+        if (!get_varint(f, value)) return false;
+        q.count = static_cast<std::size_t>(value);
+    }
+    return true;
+}
+
+// fseek takes a long, which is 32 bits on Windows.
+int seek(std::FILE* f, std::uint64_t offset, int origin) {
+#ifdef _WIN32
+    return _fseeki64(f, static_cast<__int64>(offset), origin);
+#else
+    return fseeko(f, static_cast<off_t>(offset), origin);
+#endif
+}
+
+} // namespace
+
+std::size_t retained_bytes(const FileResult& result) {
+    std::size_t total = sizeof(FileResult) + heap_bytes(result.path) + result.matches.capacity() * sizeof(FileMatch) +
+                        result.query_counts.capacity() * sizeof(QueryCount);
+    for (const auto& m : result.matches) total += heap_bytes(m.snippet);
+    return total;
+}
+
+ResultSpool::~ResultSpool() {
+    if (spill_ != nullptr) std::fclose(spill_);
+}
+
+Expected<void, Error> ResultSpool::put(std::size_t job, FileResult&& result) {
+    if (!result.any_match || !result.completed) {
+        std::scoped_lock lock(mutex_);
+        done_[job] = 1;
+        return {};
+    }
+    const auto bytes = retained_bytes(result);
+    std::scoped_lock lock(mutex_);
+    done_[job] = 1;
+    resident_.emplace(job, std::move(result));
+    resident_bytes_ += bytes;
+    peak_bytes_ = std::max(peak_bytes_, held_bytes_locked());
+    if (!budget_bytes_.has_value() || held_bytes_locked() <= *budget_bytes_ || failed_) return {};
+    return spill_locked();
+}
+
+std::size_t ResultSpool::held_bytes_locked() const { return resident_bytes_ + spilled_at_.size() * kSpillEntryBytes; }
+
+Expected<void, Error> ResultSpool::spill_locked() {
+    if (spill_ == nullptr) {
+        spill_ = std::tmpfile();
+        if (spill_ == nullptr) {
+            failed_ = true;
+            return Error{"unable to create spill file"};
+        }
+    }
+    // Offsets are committed to the index only once the whole batch is written.
+    std::vector<std::pair<std::size_t, std::uint64_t>> written;
+    written.reserve(resident_.size());
+    std::string buf;
+    std::uint64_t end = spill_end_;
+    bool ok = seek(spill_, end, SEEK_SET) == 0;
+    for (auto it = resident_.begin(); ok && it != resident_.end(); ++it) {
+        written.emplace_back(it->first, end + buf.size());
+        encode(buf, it->first, it->second);
+        if (buf.size() >= 64U * 1024U) {
+            ok = std::fwrite(buf.data(), 1, buf.size(), spill_) == buf.size();
+            end += buf.size();
+            buf.clear();
+        }
+    }
+    ok = ok && (buf.empty() || std::fwrite(buf.data(), 1, buf.size(), spill_) == buf.size()) && std::fflush(spill_) == 0;
+    if (!ok) {
+        failed_ = true;
+        return Error{"unable to write spill file"};
+    }
+    spill_end_ = end + buf.size();
+    spilled_at_.insert(written.begin(), written.end());
+    spilled_results_ += resident_.size();
+    resident_.clear();
+    resident_bytes_ = 0;
+    peak_bytes_ = std::max(peak_bytes_, held_bytes_locked());
+    return {};
+}
+
+bool ResultSpool::done(std::size_t job) {
+    std::scoped_lock lock(mutex_);
+    return done_[job] != 0;
+}
+
+Expected<std::optional<FileResult>, Error> ResultSpool::take(std::size_t job) {
+    std::scoped_lock lock(mutex_);
+    if (auto it = resident_.find(job); it != resident_.end()) {
+        std::optional<FileResult> out(std::move(it->second));
+        resident_bytes_ -= std::min(resident_bytes_, retained_bytes(*out));
+        resident_.erase(it);
+        return out;
+    }
+    const auto spilled = spilled_at_.find(job);
+    if (spilled == spilled_at_.end()) return std::optional<FileResult>{};
+    const auto at = spilled->second;
+    spilled_at_.erase(spilled);
+    std::optional<FileResult> out(FileResult{});
+    std::uint64_t stored = 0;
+    if (seek(spill_, at, SEEK_SET) != 0 || !get_varint(spill_, stored) || stored != job || !decode_body(spill_, *out)) {
+        return Error{"corrupt spill file"};
+    }
+    return out;
+}
+
+} // namespace zenith::core
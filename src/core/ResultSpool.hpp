@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Expected.hpp"
+#include "Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace zenith::core {
+
+// Approximate heap footprint of a result, including its match records and snippets.
+std::size_t retained_bytes(const FileResult& result);
+
+// Holds completed stable-output results until they are emitted in path order.
+// Resident results are accounted against an optional byte budget; when it is
+// exceeded every resident result is appended to one temporary spill file, whose
+// offsets are indexed by job, and take() reads a spilled result back with one
+// seek. The index counts against the budget too. If the file cannot be created
+// or written, put() reports it once and later results are kept in memory;
+// callers stop the run. All members are thread-safe.
+class ResultSpool {
+public:
+    ResultSpool(std::size_t jobs, std::optional<std::size_t> budget_bytes) : budget_bytes_(budget_bytes), done_(jobs, 0) {}
+    ~ResultSpool();
+    ResultSpool(const ResultSpool&) = delete;
+    ResultSpool& operator=(const ResultSpool&) = delete;
+
+    // Marks the job done. Results without matches, and incomplete results, are not
+    // retained. An error means spilling failed and the budget no longer holds.
+    Expected<void, Error> put(std::size_t job, FileResult&& result);
+
+    bool done(std::size_t job);
+
+    // Job indices must be non-decreasing across calls.
+    Expected<std::optional<FileResult>, Error> take(std::size_t job);
+
+    std::size_t peak_bytes() const { return peak_bytes_; }
+    std::size_t spilled_results() const { return spilled_results_; }
+
+private:
+    Expected<void, Error> spill_locked();
+    // Resident results and the spill index.
+    std::size_t held_bytes_locked() const;
+
+    std::optional<std::size_t> budget_bytes_;
+    std::mutex mutex_;
+    std::vector<std::uint8_t> done_;
+    std::map<std::size_t, FileResult> resident_;
+    std::size_t resident_bytes_{0};
+    std::size_t peak_bytes_{0};
+    std::size_t spilled_results_{0};
+    bool failed_{false};
+    std::FILE* spill_{nullptr};
+    std::uint64_t spill_end_{0};
+    // Offset of each spilled job's record, until it is taken.
+    std::map<std::size_t, std::uint64_t> spilled_at_;
+};
+
+} // namespace zenith::core
@@ -1,66 +1,317 @@
 #include "SearchEngine.hpp"
 
+#include "BufferPool.hpp"
+#include "ContentHash.hpp"
+#include "FuzzySearch.hpp"
+#include "MappedWindows.hpp"
+#include "MultiPatternSearch.hpp"
+#include "RareBytes.hpp"
+#include "ResultSpool.hpp"
+#include "TextEncoding.hpp"
 #include "TextUtils.hpp"
 
 #include <algorithm>
 #include <atomic>
-#include <deque>
+#include <condition_variable>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <numeric>
 #include <mutex>
+#include <optional>
+#include <set>
 #include <thread>
+#include <unordered_map>
 
 namespace zenith::core {
 namespace {
 
-bool is_binary_prefix(std::string_view prefix) { return std::find(prefix.begin(), prefix.end(), '\0') != prefix.end(); }
+// Scans of mapped files check for cancellation between slices this large.
+constexpr std::size_t kCountSliceBytes = 16U * 1024U * 1024U;
+// Under --max-matches, positions are collected in slices this large, so a file
+// with millions of hits does not materialize them all.
+constexpr std::size_t kCappedSliceBytes = 64U * 1024U;
+// Each --mmap-window window owns at least a page besides the context it shares
+// with its neighbours, so a tiny window cannot map the file once per byte.
+constexpr std::size_t kMinWindowStepBytes = 4096;
 
-bool is_binary_prefix(std::span<const std::byte> prefix) {
-    for (auto b : prefix) {
-        if (b == std::byte{0}) return true;
-    }
-    return false;
-}
+// memchr is vectorized by the C library.
+bool is_binary_prefix(std::string_view prefix) { return std::memchr(prefix.data(), 0, prefix.size()) != nullptr; }
+
+bool is_binary_prefix(std::span<const std::byte> prefix) { return std::memchr(prefix.data(), 0, prefix.size()) != nullptr; }
 
 std::size_t effective_threads(std::size_t configured) {
-    if (configured != 0) return std::clamp<std::size_t>(configured, 1, 32);
+    if (configured != 0) return configured;
     const auto hc = std::thread::hardware_concurrency();
-    const std::size_t base = hc == 0 ? 4 : static_cast<std::size_t>(hc);
-    return std::clamp<std::size_t>(base, 1, 32);
+    return hc == 0 ? 4 : static_cast<std::size_t>(hc);
+}
+
+// --dedup-content leaves smaller files alone: scanning them costs about what
+// hashing does, so a replayed result would save nothing.
+constexpr std::uintmax_t kContentDedupMinBytes = 4096;
+
+// With --numa, blocks of this many consecutive jobs are dealt to the nodes in turn,
+// which keeps stable output draining in path order.
+constexpr std::size_t kNumaJobBlock = 64;
+
+// Jobs are claimed by bumping an atomic cursor, so workers never serialize on a lock.
+struct alignas(64) JobQueue {
+    std::vector<std::size_t> jobs;
+    std::atomic<std::size_t> next{0};
+
+    std::optional<std::size_t> claim() {
+        if (next.load(std::memory_order_relaxed) >= jobs.size()) return std::nullopt;
+        const auto i = next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= jobs.size()) return std::nullopt;
+        return jobs[i];
+    }
+};
+
+// The I/O stage runs at most this many threads by default; it grows toward the
+// bound only while scan workers wait for input.
+std::size_t effective_io_threads(const std::optional<std::size_t>& configured, std::size_t workers) {
+    if (configured.has_value()) return *configured;
+    return std::clamp<std::size_t>(workers, 1, 8);
+}
+
+// Files the I/O stage keeps ready per scan worker.
+constexpr std::size_t kReadAheadPerWorker = 2;
+
+// Pooled buffers cover files below the mmap threshold (the ones that are streamed),
+// up to a cap that keeps the pool small on machines with many workers.
+std::size_t read_ahead_bytes(const SearchRequest& request) {
+    constexpr std::size_t kMaxBytes = 256U * 1024U;
+    const auto bytes = std::clamp<std::size_t>(request.mmap_threshold_bytes, BufferPool::kAlignment, kMaxBytes);
+    return (bytes + BufferPool::kAlignment - 1) / BufferPool::kAlignment * BufferPool::kAlignment;
 }
 
+// A claimed file on its way to a scan worker: its result cache answer, or the
+// whole file when the I/O stage read it ahead.
+struct PreparedFile {
+    std::size_t job{0};
+    std::optional<FileStamp> stamp;
+    std::optional<FileResult> hit;
+    BufferPool::Lease buffer;
+    std::size_t length{0};
+    // The enumerator's size; when it skipped the lookup, what a read that did not
+    // fit learned, else FileItem::kUnknownSize.
+    std::uintmax_t size{FileItem::kUnknownSize};
+    // The scan worker's own buffer, for small files that were not read ahead.
+    BufferPool* scratch{nullptr};
+};
+
 std::string make_snippet(std::string_view all, std::size_t pos, std::size_t pat_len, std::size_t snippet_cap) {
     const std::size_t half = snippet_cap / 2;
     const std::size_t start = (pos > half) ? pos - half : 0U;
     const std::size_t end = std::min(all.size(), pos + pat_len + half);
-    return sanitize_snippet(std::string(all.substr(start, end - start)));
+    return sanitize_snippet(all.substr(start, end - start));
+}
+
+// UTF-16 counterpart of make_snippet: up to snippet_cap / 2 code units on each
+// side, decoded to UTF-8. Code units start at `text` (after any BOM).
+std::string make_utf16_snippet(std::string_view all, std::size_t text, std::size_t pos, std::size_t pat_len, std::size_t snippet_cap,
+                               TextEncoding encoding) {
+    const std::size_t half = snippet_cap / 2 * 2;
+    const std::size_t start = pos - text > half ? pos - half : text;
+    const std::size_t end = std::min(all.size(), pos + pat_len + half);
+    return sanitize_snippet(decode_utf16(all.substr(start, end - start), encoding));
+}
+
+// How far a scan of UTF-16 text taken in pieces has got: code units start at
+// file offset `text` (after any BOM), and `offset` counts the text before file
+// offset `converted` as UTF-8.
+struct Utf16Progress {
+    std::uintmax_t text{0};
+    std::uintmax_t converted{0};
+    Utf8Counter offset;
+};
+
+// `files` is sorted by normalized path, so the first copy of each physical file is
+// the one with the smallest path. Files without an id dedup on identical paths.
+void drop_duplicate_files(std::vector<FileItem>& files, const PathTable& paths, SearchStats& stats) {
+    std::set<FileId> seen;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const bool duplicate = files[i].id.known() ? !seen.insert(files[i].id).second
+                                                   : kept > 0 && paths.normalized_equal(files[kept - 1].path, files[i].path);
+        if (duplicate) {
+            ++stats.duplicates_skipped;
+            if (files[i].size_known()) stats.duplicate_bytes_skipped += files[i].size;
+            continue;
+        }
+        if (kept != i) files[kept] = files[i];
+        ++kept;
+    }
+    files.resize(kept);
+}
+
+// Every request field a per-file result depends on, for result cache keys. Count
+// and files-with-matches runs produce the same results, so they share entries.
+std::string cache_query(const SearchRequest& request) {
+    std::string query = request.output_mode == OutputMode::Matches ? "matches" : "count";
+    query += request.binary_mode == BinaryMode::Skip ? " binary=skip" : " binary=scan";
+    query += request.encoding == EncodingMode::Auto ? " encoding=auto" : " encoding=none";
+    if (request.fuzzy_edits > 0) query += " fuzzy=" + std::to_string(request.fuzzy_edits);
+    if (request.output_mode == OutputMode::Matches) {
+        query += " max=" + (request.max_matches_per_file.has_value() ? std::to_string(*request.max_matches_per_file) : std::string("-"));
+        query += " snippet=" + (request.no_snippet ? std::string("-") : std::to_string(request.max_snippet_bytes));
+    }
+    query += " pattern=";
+    query += request.pattern;
+    return query;
 }
 
 } // namespace
 
-const ISearchAlgorithm& SearchEngine::choose_algorithm(AlgorithmMode mode, std::size_t pattern_len, std::uintmax_t file_size) const {
-    if (mode == AlgorithmMode::Naive) return naive_algorithm_;
-    if (mode == AlgorithmMode::Bmh) return bmh_algorithm_;
-    if (mode == AlgorithmMode::BoyerMoore) return boyer_moore_algorithm_;
+const ISearchAlgorithm& SearchEngine::algorithm_for(AlgorithmMode mode) const {
+    switch (mode) {
+    case AlgorithmMode::Naive: return naive_algorithm_;
+    case AlgorithmMode::Bmh: return bmh_algorithm_;
+    case AlgorithmMode::BoyerMoore: return boyer_moore_algorithm_;
+    case AlgorithmMode::TwoWay: return two_way_algorithm_;
+    case AlgorithmMode::Short: return short_algorithm_;
+    case AlgorithmMode::RareByte: return rare_byte_algorithm_;
+    case AlgorithmMode::Auto: break;
+    }
+    return rare_byte_algorithm_;
+}
+
+const ISearchAlgorithm& SearchEngine::choose_algorithm(const SearchRequest& request, std::size_t pattern_len) const {
+    if (request.algorithm_mode != AlgorithmMode::Auto) return algorithm_for(request.algorithm_mode);
 
-    if (pattern_len < 4) return naive_algorithm_;
-    if (pattern_len >= 8) return boyer_moore_algorithm_;
-    if (file_size >= 64U * 1024U) return bmh_algorithm_;
-    return naive_algorithm_;
+    const auto& tuned = request.auto_algorithm_by_length;
+    if (!tuned.empty()) {
+        for (std::size_t len = std::min(pattern_len, tuned.size() - 1); len > 0; --len) {
+            if (tuned[len] != AlgorithmMode::Auto) {
+                // Short kernels only specialize up to their maximum length.
+                if (tuned[len] == AlgorithmMode::Short && pattern_len > ShortPatternSearchAlgorithm::kMaxPatternLength) break;
+                return algorithm_for(tuned[len]);
+            }
+        }
+    }
+
+    // Both kernels find candidates by the pattern's rarest bytes; the long-pattern
+    // one falls back to Two-Way when that filter is ineffective.
+    if (pattern_len <= ShortPatternSearchAlgorithm::kMaxPatternLength) return short_algorithm_;
+    return rare_byte_algorithm_;
 }
 
 SearchStats SearchEngine::run(const SearchRequest& request, std::stop_token stop_token) const {
+    return run_impl(request, nullptr, nullptr, stop_token);
+}
+
+SearchStats SearchEngine::run_batch(const SearchRequest& request,
+                                    std::span<const std::string> patterns,
+                                    const QueryResultCallback& on_result,
+                                    std::stop_token stop_token) const {
+    std::vector<const ISearchAlgorithm*> kernels;
+    kernels.reserve(patterns.size());
+    for (const auto& p : patterns) kernels.push_back(&choose_algorithm(request, p.size()));
+    const MultiPatternSearch batch(std::vector<std::string>(patterns.begin(), patterns.end()), std::move(kernels));
+    return run_impl(request, &batch, &on_result, stop_token);
+}
+
+SearchStats SearchEngine::run_impl(const SearchRequest& request,
+                                   const MultiPatternSearch* batch,
+                                   const QueryResultCallback* on_result,
+                                   std::stop_token stop_token) const {
     SearchStats stats{};
-    auto files = enumerator_.enumerate(request, stop_token, [this](const Error& err) { errors_.write_error(err); });
-    std::sort(files.begin(), files.end(), [](const FileItem& a, const FileItem& b) { return a.normalized_path < b.normalized_path; });
+    // Internal stop source: follows the caller's token, and is also triggered by
+    // --quiet and --max-total-matches once the answer is known.
+    std::stop_source internal_stop;
+    std::stop_callback forward_stop(stop_token, [&] { internal_stop.request_stop(); });
+    const auto token = internal_stop.get_token();
+    std::atomic<bool> limit_reached{false};
+    std::atomic<bool> spill_failed{false};
+    auto finish_early = [&] {
+        limit_reached = true;
+        internal_stop.request_stop();
+    };
+    // --timeout: a timer stops the run like a cancellation; what completed before
+    // it fired is still reported. Joined (and disarmed) when the run returns.
+    // `timed_out` only says the timer fired: it may do so as the last file
+    // completes, so the run counts as timed out only if work was left undone.
+    std::atomic<bool> timed_out{false};
+    std::jthread deadline;
+    if (request.timeout.has_value()) {
+        deadline = std::jthread([&, limit = *request.timeout](std::stop_token disarm) {
+            std::mutex m;
+            std::condition_variable_any cv;
+            std::unique_lock lock(m);
+            cv.wait_for(lock, disarm, limit, [] { return false; });
+            if (disarm.stop_requested() || token.stop_requested()) return;
+            timed_out = true;
+            internal_stop.request_stop();
+        });
+    }
+
+    // Direct reads bypass the page cache, which mapping would fill: nothing is mapped.
+    const MmapMode mmap_mode = request.cache_policy == CachePolicy::Direct ? MmapMode::Off : request.mmap_mode;
+
+    TraceTrack* enumerator_track = trace_ != nullptr ? &trace_->add_track("enumerator") : nullptr;
+    FileList enumerated;
+    bool enumeration_stopped = false;
+    auto& files = enumerated.files;
+    const auto& paths = enumerated.paths;
+    {
+        std::string roots;
+        if (enumerator_track != nullptr) {
+            for (const auto& p : request.input_paths) roots += (roots.empty() ? "" : " ") + p;
+        }
+        TraceSpan span(enumerator_track, "enumerate", roots);
+        enumerated = enumerator_.enumerate(request, token, [this](const Error& err) { errors_.write_error(err); });
+        enumeration_stopped = token.stop_requested();
+        std::sort(files.begin(), files.end(), [&](const FileItem& a, const FileItem& b) { return paths.normalized_less(a.path, b.path); });
+        if (request.dedup_files) drop_duplicate_files(files, paths, stats);
+        span.set_size(files.size());
+    }
 
-    std::vector<FileResult> results(files.size());
-    std::mutex queue_mutex;
-    std::deque<std::size_t> jobs;
-    for (std::size_t i = 0; i < files.size(); ++i) jobs.push_back(i);
+    // Files larger than --mmap-window (and files of unknown size) are mapped a
+    // window at a time; 0 maps whole files.
+    const std::size_t window_bytes = request.mmap_window_bytes;
+    auto use_windows = [&](std::uintmax_t size) { return window_bytes > 0 && size > window_bytes; };
+
+    // Content dedup candidates share their size with another file; a file with a
+    // unique size cannot have an identical twin, so it is never hashed. Neither
+    // are small files (kContentDedupMinBytes) and windowed ones. A candidate is
+    // hashed only where its bytes are already whole in memory: a read buffer or
+    // a mapping. Streamed candidates are scanned on their own.
+    std::vector<std::uint8_t> content_candidate(files.size(), 0);
+    if (request.dedup_content) {
+        auto candidate_size = [&](const FileItem& f) { return f.size_known() && f.size >= kContentDedupMinBytes && !use_windows(f.size); };
+        std::unordered_map<std::uintmax_t, std::size_t> per_size;
+        for (const auto& f : files) {
+            if (candidate_size(f)) ++per_size[f.size];
+        }
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            content_candidate[i] = candidate_size(files[i]) && per_size[files[i].size] > 1 ? 1 : 0;
+        }
+    }
+    std::mutex content_mutex;
+    std::map<ContentHash, FileResult> content_results;
+    std::atomic<std::size_t> content_duplicates{0};
+
+    ResultSpool spool(files.size(), request.max_memory_bytes);
+    // One queue per NUMA node; workers drain their own node's queue, then steal.
+    const std::size_t nodes = request.numa && topology_ != nullptr ? std::max<std::size_t>(1, topology_->node_count()) : 1;
+    std::deque<JobQueue> queues(nodes);
+    std::vector<std::size_t> order(files.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    if (request.small_files_first) {
+        // Unknown sizes count as large, so those files come last.
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return files[a].size < files[b].size; });
+    }
+    for (std::size_t i = 0; i < order.size(); ++i) queues[(i / kNumaJobBlock) % nodes].jobs.push_back(order[i]);
 
     std::mutex emit_mutex;
     std::atomic<bool> any_match{false};
     std::atomic<bool> cancelled{false};
+    std::atomic<std::size_t> files_scanned{0};
+    std::atomic<std::uintmax_t> bytes_scanned{0};
+    std::atomic<std::size_t> files_completed{0};
+    std::atomic<std::uintmax_t> bytes_completed{0};
+    std::atomic<std::uintmax_t> total_matches{0};
 #ifdef ZENITHSEARCH_ENABLE_TEST_HOOKS
     std::atomic<std::size_t> completed_files{0};
     std::atomic<bool> injected_cancel{false};
@@ -70,73 +321,307 @@ SearchStats SearchEngine::run(const SearchRequest& request, std::stop_token stop
     }
 #endif
 
-    auto scan_file = [&](const FileItem& file) -> FileResult {
+    // Approximate matching finds the exact pattern pieces with the literal kernel
+    // for their length.
+    std::optional<FuzzySearcher> fuzzy;
+    if (request.fuzzy_edits > 0 && !request.pattern.empty() && batch == nullptr) {
+        const std::size_t k = std::min(request.fuzzy_edits, request.pattern.size() - 1);
+        fuzzy.emplace(request.pattern, k, choose_algorithm(request, FuzzySearcher::longest_piece(request.pattern.size(), k)));
+    }
+
+    // The pattern is encoded once per run, so UTF-16 files are searched in place.
+    // A pattern that is not valid UTF-8 leaves them to the binary check, as does
+    // approximate matching, whose edits count bytes.
+    std::optional<std::string> pattern_le;
+    std::optional<std::string> pattern_be;
+    if (request.encoding == EncodingMode::Auto && !fuzzy.has_value() && batch == nullptr) {
+        pattern_le = encode_utf16(request.pattern, TextEncoding::Utf16Le);
+        pattern_be = encode_utf16(request.pattern, TextEncoding::Utf16Be);
+    }
+    auto encoding_of = [&](std::span<const std::byte> prefix) {
+        return pattern_le.has_value() ? detect_encoding(prefix.first(std::min<std::size_t>(prefix.size(), 4096))) : TextEncoding::Bytes;
+    };
+    std::atomic<std::size_t> utf16_files{0};
+
+    // A size still unknown counts as large: mapping learns it.
+    auto use_mmap = [&](std::uintmax_t size) {
+        return mmap_mode == MmapMode::On || (mmap_mode == MmapMode::Auto && size >= request.mmap_threshold_bytes);
+    };
+    // Whether a file is read whole into a buffer of `buffer_bytes`: small files
+    // that are not mapped, and files whose size the enumerator skipped, unless
+    // --mmap on maps them anyway. The read learns such a size from its open and
+    // does not read a file that does not fit, which then goes to use_mmap.
+    auto read_whole = [&](std::uintmax_t size, std::size_t buffer_bytes) {
+        if (size == FileItem::kUnknownSize) return mmap_mode != MmapMode::On;
+        return size <= buffer_bytes && !use_mmap(size);
+    };
+
+    // Sets `failed` when a read error was reported, so the result is not cached,
+    // and `content` when the file was hashed and its result may be shared.
+    auto scan_file = [&](const PreparedFile& item, TraceTrack* track, bool& failed, std::optional<ContentHash>& content) -> FileResult {
+        const std::size_t job = item.job;
+        const auto& file = files[job];
         FileResult fr;
-        fr.path = file.path;
-        if (stop_token.stop_requested()) {
+        fr.path = paths.path(file.path);
+        const std::string& path = fr.path;
+        if (token.stop_requested()) {
             fr.completed = false;
             return fr;
         }
 
-        const auto& algorithm = choose_algorithm(request.algorithm_mode, request.pattern.size(), file.size);
-        const bool use_mmap = request.mmap_mode == MmapMode::On ||
-                              (request.mmap_mode == MmapMode::Auto && file.size >= request.mmap_threshold_bytes);
+        const auto& algorithm = choose_algorithm(request, request.pattern.size());
+        std::uintmax_t size = item.size;
+        std::uintmax_t trace_size = size != FileItem::kUnknownSize ? size : 0U;
 
-        auto add_match = [&](std::uintmax_t offset, std::string snippet) {
+        // Once --max-matches positions are kept, later matches are only counted.
+        auto matches_full = [&] {
+            return request.max_matches_per_file.has_value() && fr.matches.size() >= *request.max_matches_per_file;
+        };
+        // `snippet` builds the match's snippet; it is only called for kept matches.
+        auto add_match = [&](std::uintmax_t offset, auto&& snippet) {
             fr.any_match = true;
             ++fr.count;
-            if (request.output_mode == OutputMode::Count) return;
-            if (request.max_matches_per_file.has_value() && fr.matches.size() >= *request.max_matches_per_file) return;
-            fr.matches.push_back({file.path, offset, std::move(snippet), fr.binary});
+            if (request.quiet) finish_early();
+            if (request.output_mode == OutputMode::Count || matches_full()) return;
+            fr.matches.push_back({offset, request.no_snippet ? std::string{} : snippet()});
+        };
+        // Count and files-with-matches modes never look at positions or snippets, so
+        // they take the kernels' counting path instead.
+        const bool count_only = request.output_mode != OutputMode::Matches;
+        auto add_count = [&](std::size_t n) {
+            if (n == 0) return;
+            fr.any_match = true;
+            fr.count += n;
+            if (request.quiet) finish_early();
         };
 
-        if (use_mmap) {
-            auto mapped = mapped_provider_.open(file.path);
-            if (mapped) {
-                auto bytes = mapped.value()->bytes();
-                fr.binary = is_binary_prefix(bytes.subspan(0, std::min<std::size_t>(bytes.size(), 4096)));
-                if (fr.binary && request.binary_mode == BinaryMode::Skip) return fr;
-                std::string_view hay(reinterpret_cast<const char*>(bytes.data()), bytes.size());
-                auto pos = algorithm.find_all(hay, request.pattern);
-                for (auto p : pos) {
-                    if (stop_token.stop_requested()) {
-                        fr.completed = false;
-                        return fr;
-                    }
-                    add_match(p, request.no_snippet ? std::string{} : make_snippet(hay, p, request.pattern.size(), request.max_snippet_bytes));
+        // UTF-16 text: the encoded pattern runs over the raw bytes and matches must
+        // start on a code unit. `hay` starts at file offset `base`, and matches that
+        // start in [first, end) are reported. Offsets count bytes of the text as
+        // UTF-8; they and the snippets are converted only for matches that are kept,
+        // from where `progress` left off.
+        auto utf16_piece = [&](std::string_view hay, std::uintmax_t base, std::size_t first, std::size_t end, TextEncoding encoding,
+                               Utf16Progress& progress) {
+            const auto& pattern = encoding == TextEncoding::Utf16Le ? *pattern_le : *pattern_be;
+            const auto& kernel = choose_algorithm(request, pattern.size());
+            // Snippets start on a code unit inside `hay`.
+            const std::size_t lower = progress.text > base ? static_cast<std::size_t>(progress.text - base) : static_cast<std::size_t>(base % 2);
+            const std::size_t last = std::min(hay.size(), end + (pattern.empty() ? 0U : pattern.size() - 1U));
+            for (auto q : kernel.find_all(hay.substr(first, last - first), pattern)) {
+                const std::size_t p = first + q;
+                if (base + p < progress.text || (base + p - progress.text) % 2 != 0) continue;
+                if (token.stop_requested()) {
+                    fr.completed = false;
+                    return;
                 }
-                return fr;
+                if (count_only || matches_full()) {
+                    add_count(1);
+                    continue;
+                }
+                const auto from = static_cast<std::size_t>(progress.converted - base);
+                progress.offset.add(hay.substr(from, p - from), encoding);
+                progress.converted = base + p;
+                add_match(progress.offset.bytes,
+                          [&] { return make_utf16_snippet(hay, lower, p, pattern.size(), request.max_snippet_bytes, encoding); });
+            }
+        };
+        // Moves `progress` to the code unit at or before file offset `to`, before
+        // the bytes up to it are let go. Only needed while positions are kept.
+        auto utf16_advance = [&](std::string_view hay, std::uintmax_t base, std::uintmax_t to, TextEncoding encoding, Utf16Progress& progress) {
+            if (count_only || matches_full() || to <= progress.converted) return;
+            to -= (to - progress.text) % 2;
+            const auto from = static_cast<std::size_t>(progress.converted - base);
+            progress.offset.add(hay.substr(from, static_cast<std::size_t>(to - progress.converted)), encoding);
+            progress.converted = to;
+        };
+        auto scan_utf16 = [&](std::span<const std::byte> bytes, TextEncoding encoding) {
+            ++files_scanned;
+            ++utf16_files;
+            bytes_scanned += bytes.size();
+            std::string_view hay(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            const std::size_t text = bom_length(bytes, encoding);
+            Utf16Progress progress{text, text, {}};
+            utf16_piece(hay, 0, 0, hay.size(), encoding, progress);
+        };
+
+        // Batch queries: every pattern runs over the same bytes of one piece of the
+        // file starting at `base`. Hits that start inside the carry were reported
+        // with the previous piece.
+        std::unordered_map<std::size_t, std::size_t> query_hits;
+        auto batch_piece = [&](std::string_view text, std::uintmax_t base, std::size_t carry_size) {
+            batch->find(text, [&](std::size_t q, std::size_t pos) {
+                const auto& pattern = batch->patterns()[q];
+                if (pos + pattern.size() <= carry_size) return;
+                const std::size_t seen = ++query_hits[q];
+                fr.any_match = true;
+                ++fr.count;
+                if (request.quiet) finish_early();
+                if (count_only || (request.max_matches_per_file.has_value() && seen > *request.max_matches_per_file)) return;
+                fr.matches.push_back({base + pos,
+                                      request.no_snippet ? std::string{} : make_snippet(text, pos, pattern.size(), request.max_snippet_bytes), q});
+            });
+        };
+        auto finish_batch = [&] {
+            fr.query_counts.reserve(query_hits.size());
+            for (const auto& [q, n] : query_hits) fr.query_counts.push_back({q, n});
+            std::sort(fr.query_counts.begin(), fr.query_counts.end(), [](const QueryCount& a, const QueryCount& b) { return a.query < b.query; });
+        };
+
+        // Approximate matches of one piece of the file starting at `base`. A match
+        // that may continue past a partial piece is held back; the returned offset
+        // is where the next piece must start to finish it, or to find a match that
+        // ends in it. Matches ending at or before `reported` were already handled.
+        auto fuzzy_piece = [&](std::string_view text, std::uintmax_t base, bool partial, std::uintmax_t& reported) -> std::size_t {
+            const std::size_t done = reported > base ? static_cast<std::size_t>(reported - base) : 0U;
+            auto scan = fuzzy->find(text, partial, done);
+            // A run of near matches longer than a slice is reported in parts, so
+            // repetitive text cannot make the held-back piece grow without bound.
+            if (scan.open_end.has_value() && text.size() - *scan.open_end > kCountSliceBytes) scan = fuzzy->find(text, false, done);
+            for (const auto& match : scan.matches) {
+                if (token.stop_requested()) {
+                    fr.completed = false;
+                    return text.size();
+                }
+                if (count_only) {
+                    add_count(1);
+                    continue;
+                }
+                add_match(base + match.start, [&] { return make_snippet(text, match.start, match.end - match.start, request.max_snippet_bytes); });
             }
-            if (request.mmap_mode == MmapMode::On) {
-                errors_.write_error({file.path + ": mmap failed, fallback to stream: " + mapped.error().message});
+            const std::size_t context = fuzzy->context();
+            std::size_t keep = text.size() >= context ? text.size() - (context - 1) : 0;
+            if (scan.open_end.has_value()) {
+                keep = std::min(keep, *scan.open_end + 1 >= context ? *scan.open_end + 1 - context : 0);
+                reported = base + *scan.open_end;
+            } else {
+                reported = base + text.size();
             }
-        }
+            return keep;
+        };
 
-        if (request.binary_mode == BinaryMode::Skip) {
-            auto prefix = reader_.read_prefix(file.path, 4096);
-            if (!prefix) {
-                errors_.write_error({file.path + ": " + prefix.error().message});
-                return fr;
+        // Plain search over `hay`, which starts at file offset `base`: matches that
+        // start in [first, end) are reported, and the rest of `hay` is context.
+        // Sliced so cancellation is still noticed in very large files; each slice
+        // holds the matches that start inside it. Under --max-matches, positions
+        // are collected in small slices until enough are kept, and the rest is
+        // only counted.
+        auto scan_plain = [&](std::string_view hay, std::uintmax_t base, std::size_t first, std::size_t end) {
+            const std::size_t overlap = request.pattern.empty() ? 0U : request.pattern.size() - 1U;
+            for (std::size_t start = first, step = 0; start < end; start += step) {
+                if (token.stop_requested()) {
+                    fr.completed = false;
+                    return;
+                }
+                const bool counting = count_only || matches_full();
+                step = std::min(end - start, !counting && request.max_matches_per_file.has_value() ? kCappedSliceBytes : kCountSliceBytes);
+                const auto slice = hay.substr(start, step + overlap);
+                if (counting) {
+                    add_count(algorithm.count_all(slice, request.pattern));
+                    continue;
+                }
+                for (const auto p : algorithm.find_all(slice, request.pattern)) {
+                    add_match(base + start + p, [&] { return make_snippet(hay, start + p, request.pattern.size(), request.max_snippet_bytes); });
+                }
             }
-            fr.binary = is_binary_prefix(prefix.value());
-            if (fr.binary) return fr;
-        }
+        };
 
+        // Whole files in memory: mapped, or read ahead by the I/O stage. Callers
+        // hold the "scan" span.
+        auto scan_bytes = [&](std::span<const std::byte> bytes) {
+            if (const auto encoding = encoding_of(bytes); encoding != TextEncoding::Bytes) {
+                scan_utf16(bytes, encoding);
+                return;
+            }
+            fr.binary = is_binary_prefix(bytes.subspan(0, std::min<std::size_t>(bytes.size(), 4096)));
+            if (fr.binary && request.binary_mode == BinaryMode::Skip) return;
+            ++files_scanned;
+            bytes_scanned += bytes.size();
+            std::string_view hay(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            if (batch != nullptr) {
+                // Sliced like count-only scans below; each slice repeats the end
+                // of the previous one for hits that cross into it.
+                const std::size_t overlap = batch->longest() > 0 ? batch->longest() - 1 : 0U;
+                for (std::size_t start = 0; start < hay.size(); start += kCountSliceBytes) {
+                    if (token.stop_requested()) {
+                        fr.completed = false;
+                        return;
+                    }
+                    const std::size_t carry = std::min(start, overlap);
+                    batch_piece(hay.substr(start - carry, kCountSliceBytes + carry), start - carry, carry);
+                }
+                finish_batch();
+                return;
+            }
+            if (fuzzy.has_value()) {
+                // Sliced like count-only scans below.
+                std::uintmax_t reported = 0;
+                for (std::size_t begin = 0, end = 0; end < hay.size();) {
+                    if (token.stop_requested()) {
+                        fr.completed = false;
+                        return;
+                    }
+                    end = std::min(hay.size(), end + kCountSliceBytes);
+                    begin += fuzzy_piece(hay.substr(begin, end - begin), begin, end < hay.size(), reported);
+                }
+                return;
+            }
+            scan_plain(hay, 0, 0, hay.size());
+        };
+
+        // Streamed files, and windows of mapped files that are not scanned in
+        // place, arrive in chunks; a carry repeats the end of the previous chunk.
+        std::optional<TextEncoding> encoding; // from the prefix, or else the first chunk
         std::string carry;
         std::uintmax_t processed = 0;
-        auto rr = reader_.read_chunks(file.path, request.chunk_size, stop_token, [&](const std::string& chunk) -> Expected<void, Error> {
-            if (stop_token.stop_requested()) {
+        std::uintmax_t fuzzy_reported = 0;
+        Utf16Progress streamed;
+        auto scan_chunk = [&](std::string_view chunk) {
+            if (token.stop_requested()) {
                 fr.completed = false;
-                return {};
+                return;
             }
-            std::string combined = carry + chunk;
+            if (!encoding.has_value()) encoding = encoding_of(std::as_bytes(std::span(chunk)));
+            if (processed == 0) streamed.text = streamed.converted = bom_length(std::as_bytes(std::span(chunk)), *encoding);
+            std::string combined = carry;
+            combined += chunk;
             const std::size_t carry_size = carry.size();
-            auto positions = algorithm.find_all(combined, request.pattern);
-            for (auto pos : positions) {
-                if (pos + request.pattern.size() <= carry_size) continue;
-                const auto global_offset = processed - carry_size + pos;
-                add_match(global_offset,
-                          request.no_snippet ? std::string{} : make_snippet(combined, pos, request.pattern.size(), request.max_snippet_bytes));
+            if (*encoding != TextEncoding::Bytes) {
+                // The carry starts on a code unit: the earliest one where a match
+                // could still end in a later chunk, or the odd byte left over.
+                const std::uintmax_t base = processed - carry_size;
+                utf16_piece(combined, base, 0, combined.size(), *encoding, streamed);
+                processed += chunk.size();
+                const std::size_t units = pattern_le->empty() ? 0U : pattern_le->size() - 1U;
+                const std::size_t end = combined.size() & ~std::size_t{1};
+                const std::size_t keep = std::min(end, combined.size() > units ? (combined.size() - units + 1) & ~std::size_t{1} : 0U);
+                utf16_advance(combined, base, base + keep, *encoding, streamed);
+                carry = combined.substr(keep);
+                return;
+            }
+            if (batch != nullptr) {
+                batch_piece(combined, processed - carry_size, carry_size);
+                processed += chunk.size();
+                const std::size_t overlap = batch->longest() > 0 ? batch->longest() - 1 : 0U;
+                carry = combined.size() > overlap ? combined.substr(combined.size() - overlap) : combined;
+                return;
+            }
+            if (fuzzy.has_value()) {
+                // The carry is widened by k, and further to finish a held-back match.
+                const std::size_t keep = fuzzy_piece(combined, processed - carry_size, true, fuzzy_reported);
+                processed += chunk.size();
+                carry = combined.substr(keep);
+                return;
+            }
+            if (count_only || matches_full()) {
+                // The carry is shorter than the pattern, so every match here is new.
+                add_count(algorithm.count_all(combined, request.pattern));
+            } else {
+                auto positions = algorithm.find_all(combined, request.pattern);
+                for (auto pos : positions) {
+                    if (pos + request.pattern.size() <= carry_size) continue;
+                    add_match(processed - carry_size + pos,
+                              [&] { return make_snippet(combined, pos, request.pattern.size(), request.max_snippet_bytes); });
+                }
             }
             processed += chunk.size();
             if (request.pattern.size() > 1U) {
@@ -145,81 +630,535 @@ SearchStats SearchEngine::run(const SearchRequest& request, std::stop_token stop
             } else {
                 carry.clear();
             }
+        };
+        // After the last chunk; `complete` is false when reading failed.
+        auto finish_chunks = [&](bool complete) {
+            if (encoding.has_value() && *encoding != TextEncoding::Bytes) {
+                ++files_scanned;
+                ++utf16_files;
+                bytes_scanned += processed;
+                return;
+            }
+            // A match held back at the last chunk ends with the file.
+            if (fuzzy.has_value() && complete && fr.completed) fuzzy_piece(carry, processed - carry.size(), false, fuzzy_reported);
+            if (batch != nullptr) finish_batch();
+            ++files_scanned;
+            bytes_scanned += processed;
+        };
+
+        // Files larger than --mmap-window, mapped one window at a time. Text
+        // searched for one exact pattern, bytes or UTF-16, is scanned in place;
+        // windows carry the pattern length and the snippet context past their
+        // owned bytes, so the results equal a whole-file scan. Batches and fuzzy
+        // matching take the owned bytes as chunks. Callers hold the "scan" span.
+        auto scan_windows = [&](IMappedFile& mapped) {
+            const bool exact = batch == nullptr && !fuzzy.has_value();
+            const bool snippets = exact && !count_only && !request.no_snippet;
+            // UTF-16 snippets take snippet_cap / 2 code units on each side.
+            const std::size_t before = !snippets ? 0U : pattern_le.has_value() ? request.max_snippet_bytes / 2 * 2 : request.max_snippet_bytes / 2;
+            const std::size_t longest = std::max(request.pattern.size(), pattern_le.has_value() ? pattern_le->size() : 0U);
+            const std::size_t after = (exact && longest > 0 ? longest - 1U : 0U) + before;
+            const std::size_t context = before + after;
+            MappedWindowIterator windows(mapped, window_bytes > context + kMinWindowStepBytes ? window_bytes - context : kMinWindowStepBytes,
+                                         before, after);
+            Utf16Progress progress;
+            for (bool first = true;; first = false) {
+                if (token.stop_requested()) {
+                    fr.completed = false;
+                    return;
+                }
+                auto next = windows.next();
+                if (!next) {
+                    errors_.write_error({path + ": " + next.error().message});
+                    failed = true;
+                    break;
+                }
+                if (!next.value().has_value()) break;
+                const auto& window = *next.value();
+                if (first) {
+                    encoding = encoding_of(window.bytes);
+                    if (*encoding == TextEncoding::Bytes) {
+                        fr.binary = is_binary_prefix(window.bytes.subspan(0, std::min<std::size_t>(window.bytes.size(), 4096)));
+                        if (fr.binary && request.binary_mode == BinaryMode::Skip) return;
+                    } else {
+                        progress.text = progress.converted = bom_length(window.bytes, *encoding);
+                    }
+                }
+                std::string_view hay(reinterpret_cast<const char*>(window.bytes.data()), window.bytes.size());
+                const std::size_t end = window.first + window.own;
+                if (!exact) {
+                    scan_chunk(hay.substr(window.first, window.own));
+                } else if (*encoding != TextEncoding::Bytes) {
+                    utf16_piece(hay, window.offset, window.first, end, *encoding, progress);
+                    utf16_advance(hay, window.offset, window.offset + end, *encoding, progress);
+                    bytes_scanned += window.own;
+                } else {
+                    scan_plain(hay, window.offset, window.first, end);
+                    bytes_scanned += window.own;
+                }
+            }
+            if (!exact) {
+                finish_chunks(!failed);
+                return;
+            }
+            ++files_scanned;
+            if (encoding.value_or(TextEncoding::Bytes) != TextEncoding::Bytes) ++utf16_files;
+        };
+
+        // Hashes a content dedup candidate held whole in memory; true when the
+        // result of an identical file was replayed into fr.
+        auto replay_duplicate = [&](std::span<const std::byte> bytes) {
+            if (content_candidate[job] == 0) return false;
+            {
+                TraceSpan span(track, "hash", path, bytes.size());
+                content = hash_content(bytes);
+            }
+            std::scoped_lock lock(content_mutex);
+            const auto it = content_results.find(*content);
+            if (it == content_results.end()) return false;
+            ++content_duplicates;
+            content.reset();
+            auto own_path = std::move(fr.path);
+            fr = it->second;
+            fr.path = std::move(own_path);
+            return true;
+        };
+
+        if (item.buffer) {
+            const auto bytes = item.buffer.bytes().first(item.length);
+            if (replay_duplicate(bytes)) return fr;
+            TraceSpan span(track, "scan", path, item.length);
+            scan_bytes(bytes);
+            return fr;
+        }
+
+        // Small files the I/O stage did not read (there is none, or its pool ran
+        // out) take one open and one read into the worker's buffer, instead of a
+        // prefix read and a chunked stream. So do files of unknown size; one that
+        // does not fit goes on with the size the read learned.
+        if (item.scratch != nullptr && read_whole(size, item.scratch->buffer_bytes())) {
+            if (auto lease = item.scratch->try_acquire()) {
+                auto read = [&] {
+                    TraceSpan span(track, "read", path, trace_size);
+                    return reader_.read_into(path, lease.bytes());
+                }();
+                if (!read) {
+                    errors_.write_error({path + ": " + read.error().message});
+                    failed = true;
+                    return fr;
+                }
+                if (read.value() <= lease.bytes().size()) {
+                    const auto bytes = lease.bytes().first(read.value());
+                    if (replay_duplicate(bytes)) return fr;
+                    TraceSpan span(track, "scan", path, read.value());
+                    scan_bytes(bytes);
+                    return fr;
+                }
+                size = read.value();
+                trace_size = size;
+            }
+        }
+
+        if (use_mmap(size)) {
+            const bool windowed = use_windows(size);
+            auto mapped = [&] {
+                TraceSpan span(track, "map", path, trace_size);
+                return windowed ? mapped_provider_.open_windowed(path) : mapped_provider_.open(path);
+            }();
+            if (mapped && windowed) {
+                TraceSpan span(track, "scan", path, trace_size);
+                scan_windows(*mapped.value());
+                return fr;
+            }
+            if (mapped) {
+                auto bytes = mapped.value()->bytes();
+                if (replay_duplicate(bytes)) return fr;
+                TraceSpan span(track, "scan", path, bytes.size());
+                scan_bytes(bytes);
+                return fr;
+            }
+            if (mmap_mode == MmapMode::On) {
+                errors_.write_error({path + ": mmap failed, fallback to stream: " + mapped.error().message});
+            }
+        }
+
+        // One open per streamed file: the binary check holds back the first chunks
+        // until it has seen 4 KiB (or the whole file), then lets the read go on,
+        // or stops it.
+        const bool check_binary = request.binary_mode == BinaryMode::Skip;
+        bool checked = !check_binary;
+        std::string held;
+        auto check_prefix = [&] {
+            checked = true;
+            encoding = encoding_of(std::as_bytes(std::span(held)));
+            if (*encoding == TextEncoding::Bytes) fr.binary = is_binary_prefix(std::string_view(held).substr(0, 4096));
+            return !fr.binary;
+        };
+        TraceSpan span(track, "scan", path, trace_size);
+        auto rr = reader_.read_chunks(path, request.chunk_size, token, [&](const std::string& chunk) -> Expected<void, Error> {
+            if (checked) {
+                scan_chunk(chunk);
+                return {};
+            }
+            held += chunk;
+            if (held.size() < 4096) return {};
+            if (!check_prefix()) return Error{"binary"};
+            scan_chunk(held);
+            held = {};
             return {};
         });
+        if (rr && !checked && check_prefix() && !held.empty()) scan_chunk(held);
+        if (check_binary && fr.binary) return fr;
+        finish_chunks(rr.has_value());
         if (!rr) {
-            errors_.write_error({file.path + ": " + rr.error().message});
+            errors_.write_error({path + ": " + rr.error().message});
+            failed = true;
+        }
+        return fr;
+    };
+
+    // Batch results are not cached: the query would cover every pattern.
+    IResultCache* const cache = batch == nullptr ? cache_ : nullptr;
+    const std::string query = cache != nullptr ? cache_query(request) : std::string{};
+    std::atomic<std::size_t> cache_hits{0};
+    auto scan_shared = [&](const PreparedFile& item, TraceTrack* track, bool& failed) -> FileResult {
+        std::optional<ContentHash> content;
+        auto fr = scan_file(item, track, failed, content);
+        if (content.has_value() && fr.completed && !failed) {
+            std::scoped_lock lock(content_mutex);
+            content_results.emplace(*content, fr);
         }
         return fr;
     };
 
+    // Stamped before reading, and the cache refuses files modified within the
+    // timestamp granularity of that moment: a later write then moves the mtime,
+    // so a file changed mid-scan is stored under a stamp no later run will look
+    // up. Writes that keep size and mtime (an mtime restored by the writer, a
+    // clock stepped back) are not detected. True on a cache hit.
+    auto look_up = [&](PreparedFile& item, const std::string& path) {
+        if (cache == nullptr) return false;
+        item.stamp = cache->stamp(path);
+        if (!item.stamp.has_value()) return false;
+        item.hit = cache->lookup(*item.stamp, query);
+        if (!item.hit.has_value()) return false;
+        ++cache_hits;
+        item.hit->path = path;
+        return true;
+    };
+
+    auto scan_cached = [&](PreparedFile& item, TraceTrack* track) -> FileResult {
+        if (item.hit.has_value()) return std::move(*item.hit);
+        bool failed = false;
+        auto fr = scan_shared(item, track, failed);
+        item.buffer.reset(); // back to the pool before the result is emitted
+        if (item.stamp.has_value() && fr.completed && !failed) cache->store(*item.stamp, query, fr);
+        return fr;
+    };
+
+    // Callers serialize emit() under emit_mutex, which also guards emitted_matches.
+    // Against --max-total-matches, a kept match counts one, a file in
+    // files-with-matches mode one, and a count line its whole count, which is
+    // printed as is: the run stops after the file that reaches the limit.
+    std::size_t emitted_matches = 0;
+    auto budget_used = [&](std::size_t count) { return request.output_mode == OutputMode::FilesWithMatches ? std::size_t{1} : count; };
     auto emit = [&](const FileResult& fr) {
-        if (!fr.any_match) return;
+        if (!fr.any_match || request.quiet || limit_reached) return;
+        if (on_result != nullptr) {
+            // Matches are ordered by query, so each query's are one run.
+            std::size_t first = 0;
+            for (const auto& qc : fr.query_counts) {
+                std::size_t last = first;
+                while (last < fr.matches.size() && fr.matches[last].query == qc.query) ++last;
+                QueryResult result{qc.query, fr.path, qc.count, {}, fr.binary};
+                if (request.output_mode == OutputMode::Matches) {
+                    std::size_t remaining = last - first;
+                    if (request.max_total_matches.has_value()) remaining = std::min(remaining, *request.max_total_matches - emitted_matches);
+                    result.matches = std::span(fr.matches).subspan(first, remaining);
+                    result.count = result.matches.size();
+                }
+                (*on_result)(result);
+                emitted_matches += budget_used(result.count);
+                first = last;
+                if (request.max_total_matches.has_value() && emitted_matches >= *request.max_total_matches) {
+                    finish_early();
+                    return;
+                }
+            }
+            return;
+        }
+        std::size_t used = fr.count;
         if (request.output_mode == OutputMode::Matches) {
-            for (const auto& m : fr.matches) output_.write_match(m);
-        } else if (request.output_mode == OutputMode::Count) {
-            output_.write_file_summary({fr.path, fr.count, fr.binary});
+            used = fr.matches.size();
+            if (request.max_total_matches.has_value()) used = std::min(used, *request.max_total_matches - emitted_matches);
+            MatchRecord record{fr.path, 0, {}, fr.binary};
+            for (std::size_t i = 0; i < used; ++i) {
+                record.offset = fr.matches[i].offset;
+                record.snippet = fr.matches[i].snippet;
+                output_.write_match(record);
+            }
         } else {
-            output_.write_file_summary({fr.path, 1, fr.binary});
+            output_.write_file_summary({fr.path, request.output_mode == OutputMode::Count ? fr.count : 1U, fr.binary});
         }
+        emitted_matches += budget_used(used);
+        if (request.max_total_matches.has_value() && emitted_matches >= *request.max_total_matches) finish_early();
     };
 
     const auto workers_n = std::min<std::size_t>(effective_threads(request.threads), files.empty() ? 1 : files.size());
-    std::vector<std::jthread> workers;
-    workers.reserve(workers_n);
+    const auto io_n = std::min(effective_io_threads(request.io_threads, workers_n), files.size());
+    std::vector<TraceTrack*> worker_tracks(workers_n, nullptr);
+    std::vector<TraceTrack*> io_tracks(io_n, nullptr);
+    TraceTrack* emitter_track = nullptr;
+    if (trace_ != nullptr) {
+        for (std::size_t w = 0; w < workers_n; ++w) worker_tracks[w] = &trace_->add_track("worker " + std::to_string(w));
+        for (std::size_t i = 0; i < io_n; ++i) io_tracks[i] = &trace_->add_track("io " + std::to_string(i));
+        emitter_track = &trace_->add_track("emitter");
+    }
+    auto traced_emit = [&](const FileResult& fr, const FileItem& file) {
+        if (!fr.any_match) return;
+        TraceSpan span(emitter_track, "emit", fr.path, file.size_known() ? file.size : 0U);
+        emit(fr);
+    };
+
+    // Stable output is emitted as soon as the completed prefix grows, so a total
+    // match limit is satisfied by the first files in path order. Callers hold emit_mutex.
+    std::size_t emit_cursor = 0;
+    auto drain_stable = [&](bool all) {
+        while (emit_cursor < files.size() && !limit_reached && (all || spool.done(emit_cursor))) {
+            auto taken = spool.take(emit_cursor);
+            if (!taken) {
+                errors_.write_error(taken.error());
+            } else if (taken.value().has_value()) {
+                traced_emit(*taken.value(), files[emit_cursor]);
+            }
+            ++emit_cursor;
+        }
+    };
+
+    // I/O stage. Files are prepared in claim order into one ready deque per node,
+    // at most `window` at a time. Only the first `io_active` I/O threads run: a
+    // scan worker that finds nothing ready lets one more run, and an I/O thread
+    // that finds the window full parks the newest one.
+    const std::size_t window = kReadAheadPerWorker * workers_n;
+    BufferPool pool(io_n == 0 ? 0 : window + workers_n + io_n, read_ahead_bytes(request));
+    std::mutex stage_mutex;
+    std::condition_variable_any ready_cv;
+    std::condition_variable_any space_cv;
+    std::vector<std::deque<PreparedFile>> ready(nodes);
+    std::size_t ready_count = 0;
+    std::size_t io_running = io_n;
+    std::size_t io_active = std::min<std::size_t>(1, io_n);
+    std::size_t peak_io = io_active;
+    bool io_exhausted = false;
+    std::atomic<std::size_t> read_ahead_files{0};
 
-    for (std::size_t w = 0; w < workers_n; ++w) {
-        workers.emplace_back([&](std::stop_token) {
-            while (!stop_token.stop_requested()
+    auto halted = [&] {
+        return token.stop_requested()
 #ifdef ZENITHSEARCH_ENABLE_TEST_HOOKS
-                   && !injected_cancel.load()
+               || injected_cancel.load()
 #endif
-            ) {
-                std::size_t job = 0;
-                {
-                    std::scoped_lock lock(queue_mutex);
-                    if (jobs.empty()) return;
-                    job = jobs.front();
-                    jobs.pop_front();
-                }
+            ;
+    };
+
+    // Claims the next job, from `node`'s queue first; also returns the queue it came from.
+    auto claim = [&](std::size_t node) -> std::optional<std::pair<std::size_t, std::size_t>> {
+        for (std::size_t k = 0; k < nodes; ++k) {
+            const auto q = (node + k) % nodes;
+            if (auto job = queues[q].claim()) return std::pair{*job, q};
+        }
+        return std::nullopt;
+    };
 
-                auto fr = scan_file(files[job]);
-                if (fr.any_match) {
-                    any_match = true;
-                    std::sort(fr.matches.begin(), fr.matches.end(), [](const MatchRecord& a, const MatchRecord& b) { return a.offset < b.offset; });
+    // Small streamed files, and files of unknown size, are read whole into a
+    // pooled buffer; everything else (mapped files, larger files, an exhausted
+    // pool) only gets a read-ahead hint. A file that does not fit hands the size
+    // its read learned to the scan, and gets the hint too.
+    auto read_ahead = [&](PreparedFile& item, TraceTrack* track) {
+        const auto path = paths.path(files[item.job].path);
+        if (look_up(item, path)) return;
+        if (read_whole(item.size, pool.buffer_bytes())) {
+            if (auto lease = pool.try_acquire()) {
+                TraceSpan span(track, "read", path, item.size != FileItem::kUnknownSize ? item.size : 0U);
+                const auto read = reader_.read_into(path, lease.bytes());
+                // Read errors are left to the scan, which reads the file again and
+                // reports the error itself.
+                if (!read) return;
+                if (read.value() <= lease.bytes().size()) {
+                    item.buffer = std::move(lease);
+                    item.length = static_cast<std::size_t>(read.value());
+                    item.size = item.length;
+                    ++read_ahead_files;
+                    return;
                 }
-                if (!fr.completed) cancelled = true;
+                item.size = read.value();
+            }
+        }
+        TraceSpan span(track, "prefetch", path, item.size != FileItem::kUnknownSize ? item.size : 0U);
+        reader_.prefetch(path);
+    };
+
+    // Records a scanned file and emits what became ready.
+    auto complete = [&](std::size_t job, FileResult&& fr) {
+        if (fr.any_match) {
+            any_match = true;
+            total_matches += fr.count;
+            if (request.quiet) finish_early();
+            std::sort(fr.matches.begin(), fr.matches.end(),
+                      [](const FileMatch& a, const FileMatch& b) { return a.query != b.query ? a.query < b.query : a.offset < b.offset; });
+        }
+        if (!fr.completed) {
+            cancelled = true;
+        } else {
+            ++files_completed;
+            if (files[job].size_known()) bytes_completed += files[job].size;
+        }
 #ifdef ZENITHSEARCH_ENABLE_TEST_HOOKS
-                const auto done = ++completed_files;
-                if (cancel_after_files > 0 && done >= cancel_after_files) {
-                    injected_cancel = true;
-                    cancelled = true;
-                }
+        const auto done = ++completed_files;
+        if (cancel_after_files > 0 && done >= cancel_after_files) {
+            {
+                std::scoped_lock lock(stage_mutex);
+                injected_cancel = true;
+            }
+            ready_cv.notify_all();
+            space_cv.notify_all();
+            cancelled = true;
+        }
 #endif
 
-                if (request.stable_output == StableOutputMode::On) {
-                    results[job] = std::move(fr);
-                } else {
-                    std::scoped_lock lock(emit_mutex);
-                    emit(fr);
+        if (request.stable_output == StableOutputMode::On) {
+            auto put = spool.put(job, std::move(fr));
+            if (!put) {
+                // Past the memory budget with nowhere to spill: stop rather than grow.
+                errors_.write_error({put.error().message + "; stopping the search to stay within the memory budget"});
+                spill_failed = true;
+                internal_stop.request_stop();
+            }
+            std::scoped_lock lock(emit_mutex);
+            drain_stable(false);
+        } else if (fr.completed || !timed_out) {
+            // After a timeout only whole files are reported, as with stable output.
+            std::scoped_lock lock(emit_mutex);
+            traced_emit(fr, files[job]);
+        }
+    };
+
+    auto io_worker = [&](std::size_t i) {
+        const std::size_t node = i % nodes;
+        if (request.numa && topology_ != nullptr) topology_->pin_current_thread(node);
+        while (true) {
+            {
+                std::unique_lock lock(stage_mutex);
+                if (ready_count >= window && io_active > 1) --io_active;
+                space_cv.wait(lock, token, [&] { return halted() || io_exhausted || (i < io_active && ready_count < window); });
+            }
+            if (halted()) break;
+            const auto claimed = claim(node);
+            if (!claimed.has_value()) {
+                std::scoped_lock lock(stage_mutex);
+                io_exhausted = true;
+                space_cv.notify_all();
+                break;
+            }
+            PreparedFile item;
+            item.job = claimed->first;
+            item.size = files[item.job].size;
+            read_ahead(item, io_tracks[i]);
+            {
+                std::scoped_lock lock(stage_mutex);
+                ready[claimed->second].push_back(std::move(item));
+                ++ready_count;
+            }
+            ready_cv.notify_one();
+        }
+        std::scoped_lock lock(stage_mutex);
+        if (--io_running == 0) ready_cv.notify_all();
+    };
+
+    auto scan_worker = [&](std::size_t w) {
+        // Pinned workers fault mapped pages and allocate read buffers on their own node.
+        const std::size_t node = w % nodes;
+        if (request.numa && topology_ != nullptr) topology_->pin_current_thread(node);
+        BufferPool scratch(1, read_ahead_bytes(request)); // allocated on first use, on this node
+        while (!halted()) {
+            PreparedFile item;
+            if (io_n == 0) {
+                const auto claimed = claim(node);
+                if (!claimed.has_value()) return;
+                item.job = claimed->first;
+                item.size = files[item.job].size;
+                look_up(item, paths.path(files[item.job].path));
+            } else {
+                std::unique_lock lock(stage_mutex);
+                bool found = false;
+                while (!found && !halted()) {
+                    for (std::size_t k = 0; k < nodes && !found; ++k) {
+                        auto& q = ready[(node + k) % nodes];
+                        if (q.empty()) continue;
+                        item = std::move(q.front());
+                        q.pop_front();
+                        found = true;
+                    }
+                    if (found) break;
+                    if (io_running == 0) return;
+                    // Nothing ready: the I/O stage is behind, so let one more I/O thread run.
+                    if (io_active < io_n) {
+                        peak_io = std::max(peak_io, ++io_active);
+                        space_cv.notify_all();
+                    }
+                    ready_cv.wait(lock, token, [&] { return halted() || ready_count > 0 || io_running == 0; });
                 }
+                if (!found) return;
+                if (ready_count-- == window) space_cv.notify_all();
             }
-        });
-    }
+            item.scratch = &scratch;
+            complete(item.job, scan_cached(item, worker_tracks[w]));
+        }
+    };
 
-    for (auto& t : workers) {
-        if (t.joinable()) t.join();
+    // Scan workers first, then the I/O stage, on the engine's pool when it has one.
+    WorkerPool local_pool;
+    WorkerPool& threads = pool_ != nullptr ? *pool_ : local_pool;
+    threads.run(workers_n + io_n, [&](std::size_t t) {
+        if (t < workers_n) {
+            scan_worker(t);
+        } else {
+            io_worker(t - workers_n);
+        }
+    });
+    if (deadline.joinable()) {
+        deadline.request_stop();
+        deadline.join();
     }
 
     if (request.stable_output == StableOutputMode::On) {
-        for (const auto& fr : results) {
-            if (cancelled && !fr.completed) continue;
-            emit(fr);
-        }
+        // The spool only retains completed results, so cancelled files drop out here.
+        drain_stable(true);
+    }
+    stats.files_enumerated = files.size();
+    stats.files_scanned = files_scanned.load();
+    stats.bytes_scanned = bytes_scanned.load();
+    stats.files_completed = files_completed.load();
+    stats.bytes_completed = bytes_completed.load();
+    stats.cache_hits = cache_hits.load();
+    stats.content_duplicates = content_duplicates.load();
+    stats.utf16_files = utf16_files.load();
+    stats.read_ahead_files = read_ahead_files.load();
+    stats.peak_io_threads = peak_io;
+    stats.matches = total_matches.load();
+    if (request.algorithm_mode == AlgorithmMode::Auto && !request.pattern.empty() && !fuzzy.has_value() && batch == nullptr) {
+        const auto anchors = select_rare_anchors(request.pattern);
+        stats.anchors.push_back({anchors.rare1, request.pattern[anchors.rare1]});
+        if (request.pattern.size() > 1) stats.anchors.push_back({anchors.rare2, request.pattern[anchors.rare2]});
     }
+    stats.peak_retained_bytes = spool.peak_bytes();
+    stats.spilled_results = spool.spilled_results();
+    stats.spill_failed = spill_failed.load();
 
     stats.any_match = any_match.load();
-    stats.cancelled = cancelled.load() || stop_token.stop_requested()
+    // Files cut short by an early finish, the timeout or a failed spill are not a
+    // cancellation.
+    stats.timed_out = timed_out.load() && (enumeration_stopped || stats.files_completed < files.size());
+    stats.cancelled = (cancelled.load() && !limit_reached.load() && !stats.timed_out && !stats.spill_failed) || stop_token.stop_requested()
 #ifdef ZENITHSEARCH_ENABLE_TEST_HOOKS
                       || injected_cancel.load()
 #endif
@@ -1,11 +1,19 @@
 #pragma once
 
 #include "Interfaces.hpp"
+#include "RareByteSearchAlgorithm.hpp"
+#include "ShortPatternSearchAlgorithm.hpp"
+#include "Trace.hpp"
+#include "TwoWaySearchAlgorithm.hpp"
+#include "WorkerPool.hpp"
 
+#include <span>
 #include <stop_token>
 
 namespace zenith::core {
 
+class MultiPatternSearch;
+
 class SearchEngine {
 public:
     SearchEngine(const IFileEnumerator& enumerator,
@@ -25,10 +33,37 @@ public:
           output_(output),
           errors_(errors) {}
 
+    // Optional timeline recorder; when null (the default) no trace work is done.
+    void set_trace_recorder(TraceRecorder* trace) { trace_ = trace; }
+    // Optional result cache consulted before each file is read; completed results are stored back.
+    void set_result_cache(IResultCache* cache) { cache_ = cache; }
+    // NUMA layout for SearchRequest::numa; without one, --numa runs as a single node.
+    void set_cpu_topology(const ICpuTopology* topology) { topology_ = topology; }
+    // Optional threads kept across runs for the scan workers and the I/O stage;
+    // without a pool each run starts and joins its own.
+    void set_worker_pool(WorkerPool* pool) { pool_ = pool; }
+
     SearchStats run(const SearchRequest& request, std::stop_token stop_token = {}) const;
 
+    // Searches for every pattern in one traversal of the request's roots: each
+    // file is read or mapped once and all patterns run over its bytes. Results go
+    // to `on_result` per file and matching query (in path order, then query order,
+    // with stable output) instead of the output writer. request.pattern, fuzzy and
+    // UTF-16 matching and the result cache are not used.
+    SearchStats run_batch(const SearchRequest& request,
+                          std::span<const std::string> patterns,
+                          const QueryResultCallback& on_result,
+                          std::stop_token stop_token = {}) const;
+
 private:
-    const ISearchAlgorithm& choose_algorithm(AlgorithmMode mode, std::size_t pattern_len, std::uintmax_t file_size) const;
+    // `batch` and `on_result` are both set for run_batch and both null for run.
+    SearchStats run_impl(const SearchRequest& request,
+                         const MultiPatternSearch* batch,
+                         const QueryResultCallback* on_result,
+                         std::stop_token stop_token) const;
+    // Kernel for a pattern of `pattern_len` bytes (the request's, or its UTF-16 form).
+    const ISearchAlgorithm& choose_algorithm(const SearchRequest& request, std::size_t pattern_len) const;
+    const ISearchAlgorithm& algorithm_for(AlgorithmMode mode) const;
 
     const IFileEnumerator& enumerator_;
     const IFileReader& reader_;
@@ -38,6 +73,15 @@ private:
     const ISearchAlgorithm& boyer_moore_algorithm_;
     IOutputWriter& output_;
     IErrorWriter& errors_;
+    TraceRecorder* trace_{nullptr};
+    IResultCache* cache_{nullptr};
+    const ICpuTopology* topology_{nullptr};
+    WorkerPool* pool_{nullptr};
+
+    // Stateless kernels owned by the engine.
+    ShortPatternSearchAlgorithm short_algorithm_;
+    TwoWaySearchAlgorithm two_way_algorithm_;
+    RareByteSearchAlgorithm rare_byte_algorithm_;
 };
 
 } // namespace zenith::core
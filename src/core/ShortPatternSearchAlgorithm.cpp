@@ -0,0 +1,179 @@
+#include "ShortPatternSearchAlgorithm.hpp"
+
+#include "RareBytes.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+namespace zenith::core {
+namespace {
+
+template <std::size_t N>
+using word_t = std::conditional_t<(N <= 2), std::uint16_t, std::conditional_t<(N <= 4), std::uint32_t, std::uint64_t>>;
+
+constexpr char kOnes[8] = {'\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'};
+
+// Calls sink(pos) for every (overlapping) occurrence of a pattern of exactly N bytes.
+template <std::size_t N, typename Sink>
+void scan_fixed(std::string_view buffer, std::string_view pattern, Sink&& sink) {
+    const char* hay = buffer.data();
+    const std::size_t size = buffer.size();
+    if (size < N) return;
+    const std::size_t last_start = size - N;
+
+    if constexpr (N == 1) {
+        const char* p = hay;
+        const char* end = hay + size;
+        while (p < end) {
+            const void* hit = std::memchr(p, pattern[0], static_cast<std::size_t>(end - p));
+            if (hit == nullptr) return;
+            p = static_cast<const char*>(hit);
+            sink(static_cast<std::size_t>(p - hay));
+            ++p;
+        }
+    } else {
+        auto verify = [&](std::size_t i) {
+            if constexpr (N <= 8) {
+                using W = word_t<N>;
+                // Pattern and mask are loaded the same way as the haystack, so the
+                // compare is independent of byte order.
+                static_assert(sizeof(W) >= N);
+                const W mask = simd::load_partial<W>(kOnes, N);
+                const W want = simd::load_partial<W>(pattern.data(), N);
+                const std::size_t avail = size - i;
+                const W got = avail >= sizeof(W) ? simd::load<W>(hay + i) : simd::load_partial<W>(hay + i, avail);
+                return (got & mask) == want;
+            } else {
+                return simd::load<std::uint64_t>(hay + i) == simd::load<std::uint64_t>(pattern.data()) &&
+                       simd::load<std::uint64_t>(hay + i + N - 8) == simd::load<std::uint64_t>(pattern.data() + N - 8);
+            }
+        };
+
+        // Candidates must have the pattern's two rarest bytes at their offsets.
+        const auto anchors = select_rare_anchors(pattern);
+        const std::size_t a1 = anchors.rare1;
+        const std::size_t a2 = anchors.rare2;
+        std::size_t i = 0;
+#ifdef ZENITHSEARCH_HAVE_SSE2
+        const __m128i v1 = _mm_set1_epi8(pattern[a1]);
+        const __m128i v2 = _mm_set1_epi8(pattern[a2]);
+        const std::size_t reach = std::max(a1, a2);
+        for (; i + reach + 16 <= size; i += 16) {
+            const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + a1));
+            const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + a2));
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b1, v1), _mm_cmpeq_epi8(b2, v2))));
+            while (mask != 0) {
+                const auto pos = i + static_cast<std::size_t>(std::countr_zero(mask));
+                if (pos <= last_start && verify(pos)) sink(pos);
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i <= last_start; ++i) {
+            if (hay[i + a1] == pattern[a1] && verify(i)) sink(i);
+        }
+    }
+}
+
+using FindFn = void (*)(std::string_view, std::string_view, std::vector<std::size_t>&);
+
+template <std::size_t N>
+void find_fixed(std::string_view buffer, std::string_view pattern, std::vector<std::size_t>& out) {
+    scan_fixed<N>(buffer, pattern, [&](std::size_t pos) { out.push_back(pos); });
+}
+
+template <std::size_t... Ns>
+constexpr std::array<FindFn, sizeof...(Ns) + 1> make_find_table(std::index_sequence<Ns...>) {
+    return {nullptr, &find_fixed<Ns + 1>...};
+}
+
+constexpr auto kFindTable = make_find_table(std::make_index_sequence<ShortPatternSearchAlgorithm::kMaxPatternLength>{});
+
+// One- and two-byte patterns need no verification: the byte compares are the match,
+// so counts accumulate in byte lanes (up to 255 blocks) and are summed with SAD.
+template <std::size_t N>
+std::size_t count_exact(std::string_view buffer, std::string_view pattern) {
+    static_assert(N == 1 || N == 2);
+    const char* hay = buffer.data();
+    const std::size_t last_start = buffer.size() - N;
+    std::size_t count = 0;
+    std::size_t i = 0;
+#ifdef ZENITHSEARCH_HAVE_SSE2
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[N - 1]);
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 16 <= last_start + 1) {
+        __m128i lanes = zero;
+        for (int block = 0; block < 255 && i + 16 <= last_start + 1; ++block, i += 16) {
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i)), first);
+            if constexpr (N == 2) {
+                eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + 1)), last));
+            }
+            lanes = _mm_sub_epi8(lanes, eq); // matching lanes are -1
+        }
+        const __m128i sums = _mm_sad_epu8(lanes, zero);
+        count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) + static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+    }
+#endif
+    for (; i <= last_start; ++i) {
+        count += hay[i] == pattern[0] && hay[i + N - 1] == pattern[N - 1];
+    }
+    return count;
+}
+
+using CountFn = std::size_t (*)(std::string_view, std::string_view);
+
+template <std::size_t N>
+std::size_t count_fixed(std::string_view buffer, std::string_view pattern) {
+    if constexpr (N <= 2) {
+        return count_exact<N>(buffer, pattern);
+    } else {
+        std::size_t count = 0;
+        scan_fixed<N>(buffer, pattern, [&](std::size_t) { ++count; });
+        return count;
+    }
+}
+
+template <std::size_t... Ns>
+constexpr std::array<CountFn, sizeof...(Ns) + 1> make_count_table(std::index_sequence<Ns...>) {
+    return {nullptr, &count_fixed<Ns + 1>...};
+}
+
+constexpr auto kCountTable = make_count_table(std::make_index_sequence<ShortPatternSearchAlgorithm::kMaxPatternLength>{});
+
+} // namespace
+
+std::vector<std::size_t> ShortPatternSearchAlgorithm::find_all(std::string_view buffer, std::string_view pattern) const {
+    std::vector<std::size_t> positions;
+    if (pattern.empty() || buffer.size() < pattern.size()) {
+        return positions;
+    }
+    if (pattern.size() < kFindTable.size()) {
+        kFindTable[pattern.size()](buffer, pattern, positions);
+        return positions;
+    }
+    for (auto pos = buffer.find(pattern); pos != std::string_view::npos; pos = buffer.find(pattern, pos + 1)) {
+        positions.push_back(pos);
+    }
+    return positions;
+}
+
+std::size_t ShortPatternSearchAlgorithm::count_all(std::string_view buffer, std::string_view pattern) const {
+    std::size_t count = 0;
+    if (pattern.empty() || buffer.size() < pattern.size()) {
+        return count;
+    }
+    if (pattern.size() < kCountTable.size()) {
+        return kCountTable[pattern.size()](buffer, pattern);
+    }
+    for (auto pos = buffer.find(pattern); pos != std::string_view::npos; pos = buffer.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace zenith::core
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Interfaces.hpp"
+
+namespace zenith::core {
+
+// Length-specialized kernels for 1..16 byte patterns: memchr for a single byte,
+// masked 16/32/64-bit word compares for 2..8 bytes and 2x64-bit compares for
+// 9..16 bytes. Candidates come from an SSE2 filter on the pattern's two rarest
+// bytes (see RareBytes.hpp) when available. count_all for 1- and 2-byte patterns
+// accumulates SSE2 compare results in byte lanes instead of visiting each hit.
+// Longer patterns fall back to a plain std::string_view::find loop.
+class ShortPatternSearchAlgorithm final : public ISearchAlgorithm {
+public:
+    static constexpr std::size_t kMaxPatternLength = 16;
+
+    std::vector<std::size_t> find_all(std::string_view buffer, std::string_view pattern) const override;
+    std::size_t count_all(std::string_view buffer, std::string_view pattern) const override;
+};
+
+} // namespace zenith::core
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZENITHSEARCH_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace zenith::core::simd {
+
+// Unaligned little helpers shared by the byte kernels. Loads go through memcpy so
+// they are alignment- and aliasing-safe; compilers lower them to single moves.
+template <typename Word>
+inline Word load(const char* p) {
+    Word w;
+    std::memcpy(&w, p, sizeof(Word));
+    return w;
+}
+
+// Loads up to sizeof(Word) bytes, zero-filling past `avail`.
+template <typename Word>
+inline Word load_partial(const char* p, std::size_t avail) {
+    Word w{0};
+    std::memcpy(&w, p, avail < sizeof(Word) ? avail : sizeof(Word));
+    return w;
+}
+
+} // namespace zenith::core::simd
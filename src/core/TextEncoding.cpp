@@ -0,0 +1,168 @@
+#include "TextEncoding.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace zenith::core {
+namespace {
+
+constexpr char32_t kReplacement = 0xFFFD;
+
+std::uint16_t unit_at(std::string_view units, std::size_t i, TextEncoding encoding) {
+    const auto a = static_cast<unsigned char>(units[i]);
+    const auto b = static_cast<unsigned char>(units[i + 1]);
+    return static_cast<std::uint16_t>(encoding == TextEncoding::Utf16Le ? a | (b << 8) : (a << 8) | b);
+}
+
+void put_unit(std::string& out, std::uint16_t unit, TextEncoding encoding) {
+    const auto lo = static_cast<char>(unit & 0xFF);
+    const auto hi = static_cast<char>(unit >> 8);
+    if (encoding == TextEncoding::Utf16Le) {
+        out.push_back(lo);
+        out.push_back(hi);
+    } else {
+        out.push_back(hi);
+        out.push_back(lo);
+    }
+}
+
+std::size_t utf8_width(char32_t cp) { return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4; }
+
+// Calls `sink` with each code point of `units`; a trailing odd byte is ignored.
+template <typename Sink>
+void for_each_code_point(std::string_view units, TextEncoding encoding, Sink&& sink) {
+    const std::size_t n = units.size() & ~std::size_t{1};
+    for (std::size_t i = 0; i < n; i += 2) {
+        const std::uint16_t u = unit_at(units, i, encoding);
+        if (u >= 0xD800 && u <= 0xDBFF && i + 2 < n) {
+            const std::uint16_t low = unit_at(units, i + 2, encoding);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                sink(0x10000 + ((static_cast<char32_t>(u) - 0xD800) << 10) + (low - 0xDC00));
+                i += 2;
+                continue;
+            }
+        }
+        sink(u >= 0xD800 && u <= 0xDFFF ? kReplacement : static_cast<char32_t>(u));
+    }
+}
+
+// Branch-free so it vectorizes: every unit counts as its own code point
+// (surrogates as the 3-byte U+FFFD), then each high/low surrogate pair, one
+// 4-byte code point, gives back 2 bytes.
+template <bool LittleEndian>
+std::size_t utf8_size_of(std::string_view units) {
+    const auto* p = reinterpret_cast<const unsigned char*>(units.data());
+    const std::size_t n = units.size() / 2;
+    auto unit = [p](std::size_t i) -> unsigned {
+        return LittleEndian ? p[2 * i] | (p[2 * i + 1] << 8) : (p[2 * i] << 8) | p[2 * i + 1];
+    };
+    auto width = [](unsigned u) -> std::size_t { return 1U + (u >= 0x80 ? 1U : 0U) + (u >= 0x800 ? 1U : 0U); };
+    std::size_t size = 0;
+    std::size_t pairs = 0;
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        const unsigned u = unit(i);
+        size += width(u);
+        pairs += static_cast<std::size_t>(((u & 0xFC00) == 0xD800) & ((unit(i + 1) & 0xFC00) == 0xDC00));
+    }
+    if (n > 0) size += width(unit(n - 1));
+    return size - 2 * pairs;
+}
+
+} // namespace
+
+TextEncoding detect_encoding(std::span<const std::byte> prefix) {
+    if (prefix.size() >= 2) {
+        const auto b0 = static_cast<unsigned char>(prefix[0]);
+        const auto b1 = static_cast<unsigned char>(prefix[1]);
+        if (b0 == 0xFF && b1 == 0xFE) return TextEncoding::Utf16Le;
+        if (b0 == 0xFE && b1 == 0xFF) return TextEncoding::Utf16Be;
+    }
+    const std::size_t pairs = prefix.size() / 2;
+    // Most files have no NUL at all; memchr rules them out quickly.
+    if (pairs < 2 || std::memchr(prefix.data(), 0, pairs * 2) == nullptr) return TextEncoding::Bytes;
+    std::size_t zero_even = 0;
+    std::size_t zero_odd = 0;
+    for (std::size_t i = 0; i < pairs * 2; i += 2) {
+        const bool even = prefix[i] == std::byte{0};
+        const bool odd = prefix[i + 1] == std::byte{0};
+        if (even && odd) return TextEncoding::Bytes; // U+0000 does not occur in text
+        zero_even += even ? 1 : 0;
+        zero_odd += odd ? 1 : 0;
+    }
+    // At least 70% of units zero on one side and at most 10% on the other.
+    if (zero_odd * 10 >= pairs * 7 && zero_even * 10 <= pairs) return TextEncoding::Utf16Le;
+    if (zero_even * 10 >= pairs * 7 && zero_odd * 10 <= pairs) return TextEncoding::Utf16Be;
+    return TextEncoding::Bytes;
+}
+
+std::size_t bom_length(std::span<const std::byte> bytes, TextEncoding encoding) {
+    if (bytes.size() < 2 || encoding == TextEncoding::Bytes) return 0;
+    const auto b0 = static_cast<unsigned char>(bytes[0]);
+    const auto b1 = static_cast<unsigned char>(bytes[1]);
+    const bool bom = encoding == TextEncoding::Utf16Le ? (b0 == 0xFF && b1 == 0xFE) : (b0 == 0xFE && b1 == 0xFF);
+    return bom ? 2 : 0;
+}
+
+std::optional<std::string> encode_utf16(std::string_view utf8, TextEncoding encoding) {
+    std::string out;
+    out.reserve(utf8.size() * 2);
+    for (std::size_t i = 0; i < utf8.size();) {
+        const auto c = static_cast<unsigned char>(utf8[i]);
+        const std::size_t len = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+        if (len == 0 || utf8.size() - i < len) return std::nullopt;
+        char32_t cp = len == 1 ? c : c & (0xFF >> (len + 1));
+        for (std::size_t k = 1; k < len; ++k) {
+            const auto cont = static_cast<unsigned char>(utf8[i + k]);
+            if ((cont & 0xC0) != 0x80) return std::nullopt;
+            cp = (cp << 6) | (cont & 0x3F);
+        }
+        // Overlong forms, surrogates and values past U+10FFFF are not valid UTF-8.
+        if (utf8_width(cp) != len || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) return std::nullopt;
+        if (cp >= 0x10000) {
+            put_unit(out, static_cast<std::uint16_t>(0xD800 + ((cp - 0x10000) >> 10)), encoding);
+            put_unit(out, static_cast<std::uint16_t>(0xDC00 + ((cp - 0x10000) & 0x3FF)), encoding);
+        } else {
+            put_unit(out, static_cast<std::uint16_t>(cp), encoding);
+        }
+        i += len;
+    }
+    return out;
+}
+
+std::string decode_utf16(std::string_view units, TextEncoding encoding) {
+    std::string out;
+    out.reserve(units.size() / 2);
+    for_each_code_point(units, encoding, [&](char32_t cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    });
+    return out;
+}
+
+std::size_t utf8_size(std::string_view units, TextEncoding encoding) {
+    return encoding == TextEncoding::Utf16Le ? utf8_size_of<true>(units) : utf8_size_of<false>(units);
+}
+
+void Utf8Counter::add(std::string_view units, TextEncoding encoding) {
+    if (units.size() < 2) return;
+    bytes += utf8_size(units, encoding);
+    // The high half ending the last piece and the low half starting this one
+    // were each counted as a 3-byte U+FFFD.
+    if (high_surrogate_last && (unit_at(units, 0, encoding) & 0xFC00) == 0xDC00) bytes -= 2;
+    high_surrogate_last = (unit_at(units, (units.size() & ~std::size_t{1}) - 2, encoding) & 0xFC00) == 0xD800;
+}
+
+} // namespace zenith::core
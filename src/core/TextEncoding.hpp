@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace zenith::core {
+
+enum class TextEncoding { Bytes, Utf16Le, Utf16Be };
+
+// Encoding of a file from its first bytes: a UTF-16 byte order mark, or UTF-16
+// text without one, recognized by a zero byte on the same side of nearly every
+// code unit (mostly-ASCII text). Anything else is Bytes.
+TextEncoding detect_encoding(std::span<const std::byte> prefix);
+
+// Length of the byte order mark that starts `bytes` (0 or 2).
+std::size_t bom_length(std::span<const std::byte> bytes, TextEncoding encoding);
+
+// `utf8` as UTF-16 code units in `encoding`; nullopt when it is not valid UTF-8.
+std::optional<std::string> encode_utf16(std::string_view utf8, TextEncoding encoding);
+
+// UTF-8 for the whole code units in `units`; unpaired surrogates become U+FFFD.
+std::string decode_utf16(std::string_view units, TextEncoding encoding);
+
+// Size of decode_utf16(units, encoding) without building it.
+std::size_t utf8_size(std::string_view units, TextEncoding encoding);
+
+// UTF-8 size of UTF-16 text taken in consecutive pieces of whole code units. A
+// surrogate pair split between two pieces counts once, as in utf8_size of the
+// text in one piece.
+struct Utf8Counter {
+    std::uintmax_t bytes{0};
+    bool high_surrogate_last{false};
+    void add(std::string_view units, TextEncoding encoding);
+};
+
+} // namespace zenith::core
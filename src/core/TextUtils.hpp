@@ -1,46 +1,106 @@
 #pragma once
 
-#include <cctype>
+#include "Simd.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace zenith::core {
+namespace detail {
 
-inline std::string sanitize_snippet(const std::string& input) {
-    std::string out;
-    out.reserve(input.size());
-    for (unsigned char c : input) {
-        if (c == '\n') {
-            out += "\\n";
-        } else if (c == '\r') {
-            out += "\\r";
-        } else if (c == '\t') {
-            out += "\\t";
-        } else if (std::isprint(c) != 0) {
-            out.push_back(static_cast<char>(c));
+// Per-byte replacement for snippets and JSON strings: an empty entry means the
+// byte is copied as is. Snippets keep printable ASCII (what std::isprint accepts
+// in the "C" locale); JSON keeps every byte from 0x20 except quote and backslash.
+// Other control bytes and, in snippets, non-ASCII bytes become "..".
+using EscapeTable = std::array<std::string_view, 256>;
+
+constexpr EscapeTable make_escape_table(bool json) {
+    EscapeTable table{};
+    for (std::size_t c = 0; c < 256; ++c) {
+        if (c < 0x20 || (!json && c >= 0x7F)) table[c] = "..";
+    }
+    table['\n'] = "\\n";
+    table['\r'] = "\\r";
+    table['\t'] = "\\t";
+    if (json) {
+        table['"'] = "\\\"";
+        table['\\'] = "\\\\";
+    }
+    return table;
+}
+
+inline constexpr EscapeTable kSnippetEscapes = make_escape_table(false);
+inline constexpr EscapeTable kJsonEscapes = make_escape_table(true);
+
+// Length of the leading run of bytes that need no escaping.
+template <bool Json>
+inline std::size_t clean_prefix(const char* p, std::size_t n) {
+    std::size_t i = 0;
+#ifdef ZENITHSEARCH_HAVE_SSE2
+    // Sixteen bytes at a time: signed compares find control bytes (and, for
+    // snippets, DEL and non-ASCII, which are negative as signed bytes).
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i del = _mm_set1_epi8(0x7F);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i bad;
+        if constexpr (Json) {
+            // Bytes >= 0x80 are negative but clean: only 0x00..0x1F is low.
+            const __m128i control = _mm_andnot_si128(_mm_cmplt_epi8(v, _mm_setzero_si128()), _mm_cmplt_epi8(v, space));
+            bad = _mm_or_si128(control, _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
         } else {
-            out += "..";
+            bad = _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del));
         }
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(bad));
+        if (mask != 0) return i + static_cast<std::size_t>(std::countr_zero(mask));
+    }
+#endif
+    const auto& table = Json ? kJsonEscapes : kSnippetEscapes;
+    while (i < n && table[static_cast<unsigned char>(p[i])].empty()) ++i;
+    return i;
+}
+
+template <bool Json>
+inline void append_escaped(std::string& out, std::string_view input) {
+    const auto& table = Json ? kJsonEscapes : kSnippetEscapes;
+    const char* p = input.data();
+    std::size_t n = input.size();
+    while (n > 0) {
+        const std::size_t run = clean_prefix<Json>(p, n);
+        out.append(p, run);
+        if (run == n) return;
+        out += table[static_cast<unsigned char>(p[run])];
+        p += run + 1;
+        n -= run + 1;
     }
+}
+
+} // namespace detail
+
+// Appends `input` with line breaks and tabs escaped and other unprintable bytes
+// replaced by "..". Clean runs are copied whole.
+inline void append_sanitized(std::string& out, std::string_view input) { detail::append_escaped<false>(out, input); }
+
+// Appends `input` escaped for a JSON string (other control bytes become "..").
+inline void append_json_escaped(std::string& out, std::string_view input) { detail::append_escaped<true>(out, input); }
+
+inline std::string sanitize_snippet(std::string_view input) {
+    std::string out;
+    out.reserve(input.size());
+    append_sanitized(out, input);
     return out;
 }
 
-inline std::string json_escape(const std::string& input) {
+inline std::string json_escape(std::string_view input) {
     std::string out;
-    for (unsigned char c : input) {
-        switch (c) {
-        case '\\': out += "\\\\"; break;
-        case '"': out += "\\\""; break;
-        case '\n': out += "\\n"; break;
-        case '\r': out += "\\r"; break;
-        case '\t': out += "\\t"; break;
-        default:
-            if (c < 0x20) {
-                out += "..";
-            } else {
-                out.push_back(static_cast<char>(c));
-            }
-        }
-    }
+    out.reserve(input.size());
+    append_json_escaped(out, input);
     return out;
 }
 
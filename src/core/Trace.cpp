@@ -0,0 +1,47 @@
+#include "Trace.hpp"
+
+#include "TextUtils.hpp"
+
+#include <cstdio>
+#include <ostream>
+
+namespace zenith::core {
+namespace {
+
+std::string format_us(std::int64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%lld.%03lld", static_cast<long long>(ns / 1000), static_cast<long long>(ns % 1000));
+    return buf;
+}
+
+} // namespace
+
+void TraceRecorder::write_chrome_json(std::ostream& out) const {
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto sep = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    for (const auto& track : tracks_) {
+        sep();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track->tid() << ",\"args\":{\"name\":\""
+            << json_escape(track->name()) << "\"}}";
+        sep();
+        out << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track->tid()
+            << ",\"args\":{\"sort_index\":" << track->tid() << "}}";
+    }
+
+    for (const auto& track : tracks_) {
+        for (const auto& ev : track->events()) {
+            sep();
+            out << "{\"name\":\"" << ev.name << "\",\"cat\":\"zenith\",\"ph\":\"X\",\"pid\":1,\"tid\":" << track->tid()
+                << ",\"ts\":" << format_us(ev.start_ns) << ",\"dur\":" << format_us(ev.duration_ns) << ",\"args\":{\"path\":\""
+                << json_escape(ev.path) << "\",\"size\":" << ev.size << "}}";
+        }
+    }
+    out << "]}\n";
+}
+
+} // namespace zenith::core
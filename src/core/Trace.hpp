@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace zenith::core {
+
+struct TraceEvent {
+    const char* name{""};
+    std::int64_t start_ns{0};
+    std::int64_t duration_ns{0};
+    std::string path;
+    std::uintmax_t size{0};
+};
+
+// A single timeline row. Each track is written by exactly one thread at a time,
+// so recording never takes a lock.
+class TraceTrack {
+public:
+    TraceTrack(std::string name, std::size_t tid, std::chrono::steady_clock::time_point epoch)
+        : name_(std::move(name)), tid_(tid), epoch_(epoch) {}
+
+    std::int64_t now_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    void record(const char* name, std::int64_t start_ns, std::string path, std::uintmax_t size) {
+        events_.push_back({name, start_ns, now_ns() - start_ns, std::move(path), size});
+    }
+
+    const std::string& name() const { return name_; }
+    std::size_t tid() const { return tid_; }
+    const std::vector<TraceEvent>& events() const { return events_; }
+
+private:
+    std::string name_;
+    std::size_t tid_;
+    std::chrono::steady_clock::time_point epoch_;
+    std::vector<TraceEvent> events_;
+};
+
+// Owns the tracks of one or more runs. Tracks must be added before the threads
+// that write to them start; the recorder itself is not thread-safe.
+class TraceRecorder {
+public:
+    TraceRecorder() : epoch_(std::chrono::steady_clock::now()) {}
+
+    TraceTrack& add_track(std::string name) {
+        tracks_.push_back(std::make_unique<TraceTrack>(std::move(name), tracks_.size() + 1, epoch_));
+        return *tracks_.back();
+    }
+
+    const std::vector<std::unique_ptr<TraceTrack>>& tracks() const { return tracks_; }
+
+    // Chrome trace-event JSON, loadable by chrome://tracing and Perfetto.
+    void write_chrome_json(std::ostream& out) const;
+
+private:
+    std::chrono::steady_clock::time_point epoch_;
+    std::vector<std::unique_ptr<TraceTrack>> tracks_;
+};
+
+// Records one complete span on destruction. A null track makes it a no-op that
+// never reads the clock, which keeps the disabled path free.
+class TraceSpan {
+public:
+    TraceSpan(TraceTrack* track, const char* name, const std::string& path = {}, std::uintmax_t size = 0)
+        : track_(track), name_(name) {
+        if (track_ != nullptr) {
+            path_ = path;
+            size_ = size;
+            start_ns_ = track_->now_ns();
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    ~TraceSpan() {
+        if (track_ != nullptr) track_->record(name_, start_ns_, std::move(path_), size_);
+    }
+
+    void set_size(std::uintmax_t size) { size_ = size; }
+
+private:
+    TraceTrack* track_;
+    const char* name_;
+    std::string path_;
+    std::uintmax_t size_{0};
+    std::int64_t start_ns_{0};
+};
+
+} // namespace zenith::core
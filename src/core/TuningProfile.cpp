@@ -0,0 +1,90 @@
+#include "TuningProfile.hpp"
+
+#include <charconv>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace zenith::core {
+namespace {
+
+constexpr std::pair<AlgorithmMode, const char*> kAlgorithmNames[] = {
+    {AlgorithmMode::Auto, "auto"},       {AlgorithmMode::Naive, "naive"},     {AlgorithmMode::BoyerMoore, "boyer_moore"},
+    {AlgorithmMode::Bmh, "bmh"},         {AlgorithmMode::TwoWay, "two_way"},  {AlgorithmMode::Short, "short"},
+    {AlgorithmMode::RareByte, "rare_byte"},
+};
+
+bool parse_size(std::string_view text, std::size_t& out) {
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc{} && ptr == text.data() + text.size();
+}
+
+} // namespace
+
+std::optional<AlgorithmMode> algorithm_mode_from_name(std::string_view name) {
+    for (const auto& [mode, n] : kAlgorithmNames) {
+        if (name == n) return mode;
+    }
+    return std::nullopt;
+}
+
+const char* algorithm_mode_name(AlgorithmMode mode) {
+    for (const auto& [m, n] : kAlgorithmNames) {
+        if (m == mode) return n;
+    }
+    return "auto";
+}
+
+Expected<TuningProfile, Error> parse_tuning_profile(std::istream& in) {
+    TuningProfile profile;
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        const auto eq = line.find('=');
+        if (eq == std::string::npos) return Error{"profile line " + std::to_string(line_no) + ": expected key=value"};
+        const std::string_view key(line.data(), eq);
+        const std::string_view value(line.data() + eq + 1, line.size() - eq - 1);
+        auto bad = [&] { return Error{"profile line " + std::to_string(line_no) + ": invalid value for " + std::string(key)}; };
+
+        std::size_t n = 0;
+        if (key == "version") {
+            if (!parse_size(value, n)) return bad();
+            if (n != 1) return Error{"unsupported profile version " + std::string(value)};
+        } else if (key == "mmap_threshold_bytes") {
+            if (!parse_size(value, n)) return bad();
+            profile.mmap_threshold_bytes = n;
+        } else if (key == "chunk_size") {
+            if (!parse_size(value, n) || n == 0) return bad();
+            profile.chunk_size = n;
+        } else if (key.starts_with("algo.")) {
+            const auto mode = algorithm_mode_from_name(value);
+            if (!parse_size(key.substr(5), n) || n == 0 || n > 4096 || !mode.has_value() || *mode == AlgorithmMode::Auto) return bad();
+            if (profile.auto_algorithm_by_length.size() <= n) profile.auto_algorithm_by_length.resize(n + 1, AlgorithmMode::Auto);
+            profile.auto_algorithm_by_length[n] = *mode;
+        }
+        // Unknown keys are ignored so newer profiles stay readable.
+    }
+    return profile;
+}
+
+void write_tuning_profile(const TuningProfile& profile, std::ostream& out) {
+    out << "# zenithsearch tune profile\n"
+        << "version=1\n";
+    if (profile.mmap_threshold_bytes.has_value()) out << "mmap_threshold_bytes=" << *profile.mmap_threshold_bytes << '\n';
+    if (profile.chunk_size.has_value()) out << "chunk_size=" << *profile.chunk_size << '\n';
+    for (std::size_t len = 1; len < profile.auto_algorithm_by_length.size(); ++len) {
+        const auto mode = profile.auto_algorithm_by_length[len];
+        if (mode != AlgorithmMode::Auto) out << "algo." << len << '=' << algorithm_mode_name(mode) << '\n';
+    }
+}
+
+void apply_tuning_profile(const TuningProfile& profile, SearchRequest& request) {
+    if (profile.mmap_threshold_bytes.has_value()) request.mmap_threshold_bytes = *profile.mmap_threshold_bytes;
+    if (profile.chunk_size.has_value()) request.chunk_size = *profile.chunk_size;
+    request.auto_algorithm_by_length = profile.auto_algorithm_by_length;
+}
+
+} // namespace zenith::core
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Expected.hpp"
+#include "Types.hpp"
+
+#include <iosfwd>
+#include <optional>
+#include <string_view>
+
+namespace zenith::core {
+
+std::optional<AlgorithmMode> algorithm_mode_from_name(std::string_view name);
+const char* algorithm_mode_name(AlgorithmMode mode);
+
+// Machine profile written by `zenithsearch tune` and read at startup. Text format,
+// one `key=value` per line, '#' comments:
+//   version=1
+//   mmap_threshold_bytes=65536
+//   chunk_size=1048576
+//   algo.<len>=<kernel>   (the highest <len> also covers longer patterns)
+Expected<TuningProfile, Error> parse_tuning_profile(std::istream& in);
+void write_tuning_profile(const TuningProfile& profile, std::ostream& out);
+
+// Copies the profile into the request: thresholds, chunk size and the Auto kernel table.
+void apply_tuning_profile(const TuningProfile& profile, SearchRequest& request);
+
+} // namespace zenith::core
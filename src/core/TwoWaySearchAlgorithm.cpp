@@ -0,0 +1,161 @@
+#include "TwoWaySearchAlgorithm.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace zenith::core {
+namespace {
+
+// Returns the start of the right half of a critical factorization of the pattern
+// and stores its period. Computes the maximal suffix under both byte orders and
+// keeps the longer one. The `npos + k` arithmetic relies on unsigned wraparound.
+std::size_t critical_factorization(const unsigned char* x, std::size_t m, std::size_t& period) {
+    if (m < 3) {
+        period = 1;
+        return m - 1;
+    }
+    constexpr std::size_t npos = SIZE_MAX;
+
+    std::size_t max_suffix = npos;
+    std::size_t j = 0;
+    std::size_t k = 1;
+    std::size_t p = 1;
+    while (j + k < m) {
+        const auto a = x[j + k];
+        const auto b = x[max_suffix + k];
+        if (a < b) {
+            j += k;
+            k = 1;
+            p = j - max_suffix;
+        } else if (a == b) {
+            if (k != p) {
+                ++k;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            max_suffix = j++;
+            k = p = 1;
+        }
+    }
+    period = p;
+
+    std::size_t max_suffix_rev = npos;
+    j = 0;
+    k = p = 1;
+    while (j + k < m) {
+        const auto a = x[j + k];
+        const auto b = x[max_suffix_rev + k];
+        if (b < a) {
+            j += k;
+            k = 1;
+            p = j - max_suffix_rev;
+        } else if (a == b) {
+            if (k != p) {
+                ++k;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            max_suffix_rev = j++;
+            k = p = 1;
+        }
+    }
+
+    if (max_suffix_rev + 1 < max_suffix + 1) return max_suffix + 1;
+    period = p;
+    return max_suffix_rev + 1;
+}
+
+// Calls sink(pos) for every occurrence; the caller has checked 0 < m <= n.
+template <typename Sink>
+void scan_two_way(std::string_view buffer, std::string_view pattern, Sink&& sink) {
+
+    const auto* x = reinterpret_cast<const unsigned char*>(pattern.data());
+    const auto* y = reinterpret_cast<const unsigned char*>(buffer.data());
+    const std::size_t m = pattern.size();
+    const std::size_t n = buffer.size();
+
+    std::size_t period = 0;
+    const std::size_t suffix = critical_factorization(x, m, period);
+
+    // Distance from each byte's last occurrence to the end of the pattern. The
+    // last pattern byte maps to 0, which is what lets the scans below skip it.
+    std::array<std::size_t, 256> shift_table;
+    shift_table.fill(m);
+    for (std::size_t i = 0; i < m; ++i) shift_table[x[i]] = m - i - 1;
+
+    std::size_t j = 0;
+    if (std::memcmp(x, x + period, suffix) == 0) {
+        // Periodic pattern: after a hit or a right-half match, `memory` bytes of
+        // the left half are already known to match and are not compared again.
+        std::size_t memory = 0;
+        while (j + m <= n) {
+            std::size_t shift = shift_table[y[j + m - 1]];
+            if (shift > 0) {
+                if (memory != 0 && shift < period) shift = m - period;
+                memory = 0;
+                j += shift;
+                continue;
+            }
+            std::size_t i = std::max(suffix, memory);
+            while (i < m - 1 && x[i] == y[i + j]) ++i;
+            if (m - 1 <= i) {
+                i = suffix - 1;
+                while (memory < i + 1 && x[i] == y[i + j]) --i;
+                if (i + 1 < memory + 1) sink(j);
+                j += period;
+                memory = m - period;
+            } else {
+                j += i - suffix + 1;
+                memory = 0;
+            }
+        }
+    } else {
+        // Non-periodic: occurrences are at least this far apart.
+        period = std::max(suffix, m - suffix) + 1;
+        while (j + m <= n) {
+            const std::size_t shift = shift_table[y[j + m - 1]];
+            if (shift > 0) {
+                j += shift;
+                continue;
+            }
+            std::size_t i = suffix;
+            while (i < m - 1 && x[i] == y[i + j]) ++i;
+            if (m - 1 <= i) {
+                i = suffix - 1;
+                while (i != SIZE_MAX && x[i] == y[i + j]) --i;
+                if (i == SIZE_MAX) sink(j);
+                j += period;
+            } else {
+                j += i - suffix + 1;
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::vector<std::size_t> TwoWaySearchAlgorithm::find_all(std::string_view buffer, std::string_view pattern) const {
+    std::vector<std::size_t> positions;
+    if (pattern.empty() || buffer.size() < pattern.size()) {
+        return positions;
+    }
+    scan_two_way(buffer, pattern, [&](std::size_t pos) { positions.push_back(pos); });
+    return positions;
+}
+
+std::size_t TwoWaySearchAlgorithm::count_all(std::string_view buffer, std::string_view pattern) const {
+    std::size_t count = 0;
+    if (pattern.empty() || buffer.size() < pattern.size()) {
+        return count;
+    }
+    scan_two_way(buffer, pattern, [&](std::size_t) { ++count; });
+    return count;
+}
+
+} // namespace zenith::core
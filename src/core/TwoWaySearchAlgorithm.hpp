@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Interfaces.hpp"
+
+namespace zenith::core {
+
+// Crochemore-Perrin Two-Way search with a bad-character skip table. Worst case
+// is O(n + m) with constant extra memory, including overlapping occurrences of
+// periodic patterns, so repetitive inputs cannot make it quadratic.
+class TwoWaySearchAlgorithm final : public ISearchAlgorithm {
+public:
+    std::vector<std::size_t> find_all(std::string_view buffer, std::string_view pattern) const override;
+    std::size_t count_all(std::string_view buffer, std::string_view pattern) const override;
+};
+
+} // namespace zenith::core
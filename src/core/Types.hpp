@@ -1,9 +1,14 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
+#include <compare>
 #include <cstdint>
+#include <functional>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
@@ -11,10 +16,13 @@ namespace zenith::core {
 
 enum class BinaryMode { Skip, Scan };
 enum class OutputMode { Matches, Count, FilesWithMatches };
+enum class OutputFormat { Human, Jsonl, Binary };
 enum class MmapMode { Auto, On, Off };
 enum class StableOutputMode { On, Off };
-enum class AlgorithmMode { Auto, Naive, BoyerMoore, Bmh };
+enum class AlgorithmMode { Auto, Naive, BoyerMoore, Bmh, TwoWay, Short, RareByte };
 enum class FollowSymlinksMode { Off, On };
+enum class EncodingMode { Auto, None };
+enum class CachePolicy { Normal, Drop, Direct };
 
 struct Error {
     std::string message;
@@ -27,31 +35,106 @@ struct SearchRequest {
     bool ignore_hidden{false};
     std::optional<std::uintmax_t> max_bytes;
     BinaryMode binary_mode{BinaryMode::Skip};
+    // Auto searches UTF-16 files (BOM or heuristic) with the pattern in their
+    // encoding; None treats every file as bytes.
+    EncodingMode encoding{EncodingMode::Auto};
+    // Report text within this many insertions, deletions or substitutions of the
+    // pattern; 0 = exact. Must be smaller than the pattern.
+    std::size_t fuzzy_edits{0};
     OutputMode output_mode{OutputMode::Matches};
-    bool json_output{false};
+    OutputFormat output_format{OutputFormat::Human};
     std::size_t chunk_size{1024U * 1024U};
 
     MmapMode mmap_mode{MmapMode::Auto};
+    // Page cache use of the reader: Drop evicts what it read, Direct bypasses the
+    // cache (O_DIRECT) and so never maps files.
+    CachePolicy cache_policy{CachePolicy::Normal};
     std::size_t mmap_threshold_bytes{64U * 1024U};
-    std::size_t threads{0}; // 0 = auto
+    // Larger files are mapped in windows of this many bytes, one at a time, so
+    // address space and resident memory stay bounded; 0 = map whole files. The
+    // default windows only where the address space is 32-bit.
+    std::size_t mmap_window_bytes{sizeof(void*) < 8 ? 256U * 1024U * 1024U : 0U};
+    std::size_t threads{0}; // 0 = auto (one per hardware thread)
+    // Upper bound for the I/O stage that reads files ahead of the scan workers;
+    // nullopt = auto, 0 = scan workers do their own I/O. The stage grows toward
+    // this bound while the workers wait for input and shrinks while they lag.
+    std::optional<std::size_t> io_threads;
+    // Pin workers to NUMA nodes and give each node its own job queue.
+    bool numa{false};
     StableOutputMode stable_output{StableOutputMode::On};
     AlgorithmMode algorithm_mode{AlgorithmMode::Auto};
+    // Kernel chosen by Auto mode per pattern length, usually from a tune profile.
+    // Auto entries defer to the built-in rule; the last entry covers longer patterns.
+    std::vector<AlgorithmMode> auto_algorithm_by_length;
 
     std::vector<std::string> exclude_globs;
     std::vector<std::string> exclude_dirs;
     std::vector<std::string> include_globs;
     bool no_ignore{false};
     FollowSymlinksMode follow_symlinks{FollowSymlinksMode::Off};
+    // Scan each physical file once across all input paths (hardlinks, overlapping
+    // roots), keeping its smallest normalized path.
+    bool dedup_files{true};
+    // Scan byte-identical files once: files whose sizes collide are hashed and the
+    // first result per content is replayed for the other paths.
+    bool dedup_content{false};
 
     std::optional<std::size_t> max_matches_per_file;
     std::size_t max_snippet_bytes{120};
     bool no_snippet{false};
+
+    // Stop all workers once the answer is known: on the first match (quiet), or
+    // after this many matches have been emitted (first N in path order when stable).
+    bool quiet{false};
+    std::optional<std::size_t> max_total_matches;
+
+    // Stable-output results beyond this many retained bytes are spilled to temporary files.
+    std::optional<std::size_t> max_memory_bytes;
+
+    // Stop the run this long after it starts. Files completed by then are still
+    // reported (in path order with stable output); SearchStats::timed_out is set.
+    std::optional<std::chrono::milliseconds> timeout;
+    // Claim files smallest first, so a timed-out run has covered more of them.
+    // Output order is unchanged.
+    bool small_files_first{false};
+};
+
+struct TuningProfile {
+    std::optional<std::size_t> mmap_threshold_bytes;
+    std::optional<std::size_t> chunk_size;
+    std::vector<AlgorithmMode> auto_algorithm_by_length;
+};
+
+// All zero when unknown.
+struct FileId {
+    std::uint64_t device{0};
+    std::uint64_t inode{0};
+    bool known() const { return device != 0 || inode != 0; }
+    auto operator<=>(const FileId&) const = default;
 };
 
+// Content identity for the result cache: a write changes the size or the
+// modification time of the file behind `id`, unless it lands within the same
+// timestamp tick (see DiskResultCache::stamp) or the writer restores the mtime.
+struct FileStamp {
+    FileId id;
+    std::uintmax_t size{0};
+    std::int64_t mtime_ns{0};
+    auto operator<=>(const FileStamp&) const = default;
+};
+
+// Index of a node in the enumerator's PathTable (see PathTable.hpp).
+using PathId = std::uint32_t;
+
 struct FileItem {
-    std::string path;
-    std::string normalized_path;
+    // Left by enumerators that skip the size lookup when no filter needs it.
+    static constexpr std::uintmax_t kUnknownSize = UINTMAX_MAX;
+
+    PathId path{0};
     std::uintmax_t size{0};
+    FileId id{}; // filled by enumerators when dedup_files is on
+
+    bool size_known() const { return size != kUnknownSize; }
 };
 
 struct MatchRecord {
@@ -67,18 +150,80 @@ struct FileMatchSummary {
     bool binary{false};
 };
 
+// A match held in a FileResult; the path and binary flag are the file's.
+struct FileMatch {
+    std::uintmax_t offset{0};
+    std::string snippet;
+    std::size_t query{0}; // index into the batch (SearchEngine::run_batch), else 0
+};
+
+// Matches of one batch query in one file.
+struct QueryCount {
+    std::size_t query{0};
+    std::size_t count{0};
+};
+
 struct FileResult {
     std::string path;
-    std::vector<MatchRecord> matches;
+    std::vector<FileMatch> matches;
     std::size_t count{0};
     bool any_match{false};
     bool binary{false};
     bool completed{true};
+    // Batch runs only: the queries that matched, in query order. `count` is their
+    // total and `matches` are ordered by query, then offset.
+    std::vector<QueryCount> query_counts;
+};
+
+// One batch query's result for one file, passed to the run_batch callback. The
+// views are valid during the call only.
+struct QueryResult {
+    std::size_t query{0};
+    std::string_view path;
+    std::size_t count{0};
+    std::span<const FileMatch> matches; // empty unless OutputMode::Matches
+    bool binary{false};
+};
+
+using QueryResultCallback = std::function<void(const QueryResult&)>;
+
+struct PatternAnchor {
+    std::size_t index{0};
+    char byte{0};
 };
 
 struct SearchStats {
     bool any_match{false};
     bool cancelled{false};
+    std::size_t files_enumerated{0};
+    std::size_t duplicates_skipped{0};
+    std::uintmax_t duplicate_bytes_skipped{0};
+    std::size_t files_scanned{0};
+    std::uintmax_t bytes_scanned{0};
+    // Files whose results are complete (scanned to the end, skipped, or answered
+    // without reading) and their sizes: what a stopped run covered.
+    std::size_t files_completed{0};
+    std::uintmax_t bytes_completed{0};
+    // The run stopped at SearchRequest::timeout; not counted as cancelled.
+    bool timed_out{false};
+    // Files answered by the result cache without reading them.
+    std::size_t cache_hits{0};
+    // Files answered by replaying the result of an identical file (dedup_content).
+    std::size_t content_duplicates{0};
+    // Files searched as UTF-16 text.
+    std::size_t utf16_files{0};
+    // Files the I/O stage read whole into a pooled buffer ahead of the scan.
+    std::size_t read_ahead_files{0};
+    // Most I/O threads active at once (0 without an I/O stage).
+    std::size_t peak_io_threads{0};
+    std::uintmax_t matches{0};
+    // Rarest pattern bytes used as candidate anchors by --algo auto.
+    std::vector<PatternAnchor> anchors;
+    std::size_t peak_retained_bytes{0};
+    std::size_t spilled_results{0};
+    // Results over max_memory_bytes could not be spilled, so the run stopped
+    // early; completed files before that point are still reported.
+    bool spill_failed{false};
 };
 
 } // namespace zenith::core
@@ -0,0 +1,53 @@
+#include "WorkerPool.hpp"
+
+namespace zenith::core {
+
+WorkerPool::~WorkerPool() {
+    {
+        std::scoped_lock lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    threads_.clear(); // joins
+}
+
+void WorkerPool::run(std::size_t count, const std::function<void(std::size_t)>& task) {
+    if (count == 0) return;
+    std::scoped_lock serial(run_mutex_);
+    std::unique_lock lock(mutex_);
+    while (threads_.size() < count) {
+        const std::size_t index = threads_.size();
+        threads_.emplace_back([this, index] { serve(index); });
+    }
+    task_ = &task;
+    count_ = count;
+    running_ = count;
+    ++generation_;
+    wake_.notify_all();
+    done_.wait(lock, [&] { return running_ == 0; });
+    task_ = nullptr;
+}
+
+std::size_t WorkerPool::size() const {
+    std::scoped_lock lock(mutex_);
+    return threads_.size();
+}
+
+void WorkerPool::serve(std::size_t index) {
+    std::size_t seen = 0;
+    std::unique_lock lock(mutex_);
+    while (true) {
+        // A thread started during a run joins that run.
+        wake_.wait(lock, [&] { return stopping_ || (generation_ != seen && task_ != nullptr); });
+        if (stopping_) return;
+        seen = generation_;
+        if (index >= count_) continue;
+        const auto* task = task_;
+        lock.unlock();
+        (*task)(index);
+        lock.lock();
+        if (--running_ == 0) done_.notify_all();
+    }
+}
+
+} // namespace zenith::core
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zenith::core {
+
+// Threads kept across runs, so a long-lived SearchEngine does not start its scan
+// and I/O threads again for every query. Threads are started on first use and
+// joined by the destructor.
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Calls task(0) .. task(count - 1), each on its own thread, so tasks may wait
+    // on each other; returns when all have returned. The pool grows to `count`
+    // threads. Concurrent calls run one after the other.
+    void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    std::size_t size() const;
+
+private:
+    void serve(std::size_t index);
+
+    std::mutex run_mutex_; // one run at a time
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::jthread> threads_;
+    const std::function<void(std::size_t)>* task_{nullptr};
+    std::size_t count_{0};
+    std::size_t running_{0};
+    std::size_t generation_{0};
+    bool stopping_{false};
+};
+
+} // namespace zenith::core
@@ -1,14 +1,24 @@
 #include "cli/ArgParser.hpp"
 #include "core/NaiveSearchAlgorithm.hpp"
 #include "core/SearchEngine.hpp"
+#include "core/TuningProfile.hpp"
+#include "platform/BinaryResults.hpp"
+#include "platform/CpuTopology.hpp"
 #include "platform/MappedFileProvider.hpp"
 #include "platform/OutputWriters.hpp"
+#include "platform/ResultCache.hpp"
 #include "platform/StdFileReader.hpp"
 #include "platform/StdFilesystemEnumerator.hpp"
+#include "platform/Tuner.hpp"
+#ifdef __linux__
+#include "platform/GetdentsEnumerator.hpp"
+#endif
 
 #include <atomic>
 #include <csignal>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <stop_token>
 #include <thread>
@@ -16,12 +26,71 @@
 
 #ifdef _WIN32
 #define NOMINMAX
+#include <fcntl.h>
+#include <io.h>
 #include <windows.h>
 #endif
 
 namespace {
 std::atomic<bool>* g_cancelled = nullptr;
 
+// --queries-from: one pattern per line; blank lines are skipped.
+zenith::core::Expected<std::vector<std::string>, zenith::core::Error> read_queries(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return zenith::core::Error{"unable to open queries file: " + path};
+    std::vector<std::string> queries;
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) queries.push_back(std::move(line));
+    }
+    if (queries.empty()) return zenith::core::Error{"no patterns in queries file: " + path};
+    return queries;
+}
+
+// `zenithsearch decode`: replays a --format binary stream through the text or
+// JSONL writer, with the pattern and mode from its header.
+int decode(const zenith::cli::ParseResult& parsed) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    const bool from_stdin = parsed.decode_input.empty() || parsed.decode_input == "-";
+    if (!from_stdin) {
+        file.open(parsed.decode_input, std::ios::binary);
+        if (!file) {
+            std::cerr << "error: unable to open " << parsed.decode_input << '\n';
+            return 2;
+        }
+        in = &file;
+    }
+#ifdef _WIN32
+    if (from_stdin) _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    zenith::platform::BinaryResultsReader reader(*in);
+    auto header = reader.read_header();
+    if (!header) {
+        std::cerr << "error: " << header.error().message << '\n';
+        return 2;
+    }
+    auto request = parsed.request;
+    request.pattern = header.value().pattern;
+    request.output_mode = header.value().mode;
+    request.no_snippet = !header.value().snippets;
+    auto output = zenith::platform::make_output_writer(request, std::cout);
+    while (true) {
+        auto record = reader.next();
+        if (!record) {
+            std::cerr << "error: " << record.error().message << '\n';
+            return 2;
+        }
+        if (!record.value().has_value()) return 0;
+        const auto& result = *record.value();
+        if (result.type == zenith::platform::BinaryRecordType::Match) {
+            output->write_match(result.match);
+        } else {
+            output->write_file_summary(result.summary);
+        }
+    }
+}
+
 void signal_handler(int) {
     if (g_cancelled != nullptr) {
         g_cancelled->store(true);
@@ -60,6 +129,57 @@ int main(int argc, char** argv) {
         std::cout << "zenithsearch v1.0.0\n";
         return 0;
     }
+    if (parsed.value().run_tune) {
+        const auto path = parsed.value().tune_output.empty() ? zenith::platform::default_profile_path()
+                                                             : std::filesystem::path(parsed.value().tune_output);
+        if (path.empty()) {
+            std::cerr << "error: no profile location; pass --output FILE\n";
+            return 2;
+        }
+        zenith::platform::StdFileReader reader;
+        zenith::platform::MappedFileProvider mapped_provider;
+        const zenith::platform::Tuner tuner(reader, mapped_provider);
+        auto profile = tuner.run({}, std::cerr);
+        if (!profile) {
+            std::cerr << "error: " << profile.error().message << '\n';
+            return 2;
+        }
+        if (auto saved = zenith::platform::save_tuning_profile(profile.value(), path); !saved) {
+            std::cerr << "error: " << saved.error().message << '\n';
+            return 2;
+        }
+        std::cout << "wrote " << path.string() << '\n';
+        return 0;
+    }
+
+    if (parsed.value().run_decode) return decode(parsed.value());
+
+    // An explicit --profile must load; the default one is optional and only warns.
+    auto& request = parsed.value().request;
+    const bool explicit_profile = !parsed.value().profile_path.empty();
+    const auto profile_path = explicit_profile ? std::filesystem::path(parsed.value().profile_path) : zenith::platform::default_profile_path();
+    std::error_code exists_ec;
+    if (explicit_profile || (!profile_path.empty() && std::filesystem::exists(profile_path, exists_ec))) {
+        auto profile = zenith::platform::load_tuning_profile(profile_path);
+        if (profile) {
+            zenith::core::apply_tuning_profile(profile.value(), request);
+        } else if (explicit_profile) {
+            std::cerr << "error: " << profile.error().message << '\n';
+            return 2;
+        } else {
+            std::cerr << "warning: ignoring " << profile.error().message << '\n';
+        }
+    }
+
+    std::vector<std::string> queries;
+    if (!parsed.value().queries_path.empty()) {
+        auto read = read_queries(parsed.value().queries_path);
+        if (!read) {
+            std::cerr << "error: " << read.error().message << '\n';
+            return 2;
+        }
+        queries = std::move(read.value());
+    }
 
     std::atomic<bool> cancelled{false};
     g_cancelled = &cancelled;
@@ -70,16 +190,49 @@ int main(int argc, char** argv) {
     SetConsoleCtrlHandler(ctrl_handler, TRUE);
 #endif
 
+#ifdef __linux__
+    zenith::platform::GetdentsEnumerator enumerator;
+#else
     zenith::platform::StdFilesystemEnumerator enumerator;
-    zenith::platform::StdFileReader reader;
-    zenith::platform::MappedFileProvider mapped_provider;
+#endif
+    zenith::platform::StdFileReader reader(request.cache_policy);
+    zenith::platform::MappedFileProvider mapped_provider(request.cache_policy);
     zenith::core::NaiveSearchAlgorithm naive_algorithm;
     zenith::core::BmhSearchAlgorithm bmh_algorithm;
     zenith::core::BoyerMooreSearchAlgorithm bm_algorithm;
+#ifdef _WIN32
+    if (request.output_format == zenith::core::OutputFormat::Binary) _setmode(_fileno(stdout), _O_BINARY);
+#endif
     auto output = zenith::platform::make_output_writer(parsed.value().request, std::cout);
     zenith::platform::StreamErrorWriter err(std::cerr);
 
     zenith::core::SearchEngine engine(enumerator, reader, mapped_provider, naive_algorithm, bmh_algorithm, bm_algorithm, *output, err);
+    zenith::platform::CpuTopology topology;
+    if (parsed.value().request.numa) engine.set_cpu_topology(&topology);
+
+    const auto& trace_path = parsed.value().trace_path;
+    std::ofstream trace_out;
+    zenith::core::TraceRecorder trace;
+    if (!trace_path.empty()) {
+        trace_out.open(trace_path, std::ios::binary | std::ios::trunc);
+        if (!trace_out) {
+            std::cerr << "error: unable to open trace file: " << trace_path << '\n';
+            return 2;
+        }
+        engine.set_trace_recorder(&trace);
+    }
+
+    std::unique_ptr<zenith::platform::DiskResultCache> cache;
+    if (!parsed.value().cache_dir.empty()) {
+        auto opened = zenith::platform::DiskResultCache::open(
+            parsed.value().cache_dir, parsed.value().cache_max_bytes.value_or(zenith::platform::DiskResultCache::kDefaultMaxBytes));
+        if (!opened) {
+            std::cerr << "error: " << opened.error().message << '\n';
+            return 2;
+        }
+        cache = std::move(opened.value());
+        engine.set_result_cache(cache.get());
+    }
 
     std::stop_source stop_source;
     std::jthread cancel_monitor([&](std::stop_token st) {
@@ -92,10 +245,55 @@ int main(int argc, char** argv) {
         }
     });
 
-    const auto stats = engine.run(parsed.value().request, stop_source.get_token());
+    zenith::core::SearchStats stats;
+    if (queries.empty()) {
+        stats = engine.run(request, stop_source.get_token());
+    } else {
+        // One writer per query, so every record names its pattern.
+        std::vector<std::unique_ptr<zenith::core::IOutputWriter>> writers;
+        writers.reserve(queries.size());
+        auto query_request = request;
+        for (const auto& q : queries) {
+            query_request.pattern = q;
+            writers.push_back(zenith::platform::make_output_writer(query_request, std::cout, true));
+        }
+        stats = engine.run_batch(request, queries, [&](const zenith::core::QueryResult& result) {
+            auto& writer = *writers[result.query];
+            if (request.output_mode != zenith::core::OutputMode::Matches) {
+                writer.write_file_summary({std::string(result.path), result.count, result.binary});
+                return;
+            }
+            zenith::core::MatchRecord record{std::string(result.path), 0, {}, result.binary};
+            for (const auto& match : result.matches) {
+                record.offset = match.offset;
+                record.snippet = match.snippet;
+                writer.write_match(record);
+            }
+        }, stop_source.get_token());
+    }
     cancel_monitor.request_stop();
     if (cancel_monitor.joinable()) cancel_monitor.join();
 
+    if (cache) {
+        if (auto saved = cache->save(); !saved) std::cerr << "warning: " << saved.error().message << '\n';
+    }
+
+    if (request.timeout.has_value() && !request.quiet) {
+        if (request.output_format == zenith::core::OutputFormat::Jsonl) {
+            zenith::platform::write_jsonl_status(stats, std::cout);
+        } else if (stats.timed_out) {
+            std::cerr << "warning: timed out; " << stats.files_completed << " of " << stats.files_enumerated << " files searched\n";
+        }
+    }
+    if (parsed.value().show_stats) {
+        zenith::platform::write_stats(stats, std::cerr);
+    }
+    if (trace_out.is_open()) {
+        trace.write_chrome_json(trace_out);
+    }
+
     if (stats.cancelled || cancelled.load()) return 130;
+    if (stats.spill_failed) return 2;
+    if (stats.timed_out) return 124;
     return stats.any_match ? 0 : 1;
 }
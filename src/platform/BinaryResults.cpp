@@ -0,0 +1,199 @@
+#include "BinaryResults.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+namespace zenith::platform {
+namespace {
+
+constexpr std::uint64_t kFlagSnippets = 1;
+constexpr std::uint64_t kPathBinary = 1;
+
+void put_varint(std::string& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// Signed steps between offsets: 0, -1, 1, -2, ... map to 0, 1, 2, 3, ...
+std::uint64_t zigzag(std::int64_t v) { return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63); }
+std::int64_t unzigzag(std::uint64_t v) { return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1); }
+
+void put_bytes(std::string& out, std::string_view s) {
+    put_varint(out, s.size());
+    out += s;
+}
+
+// Cursor over one record body or the header.
+struct Cursor {
+    std::string_view data;
+
+    bool varint(std::uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && !data.empty(); shift += 7) {
+            const auto c = static_cast<unsigned char>(data.front());
+            data.remove_prefix(1);
+            v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+            if ((c & 0x80) == 0) return true;
+        }
+        return false;
+    }
+    bool bytes(std::string& s) {
+        std::uint64_t len = 0;
+        if (!varint(len) || len > data.size()) return false;
+        s.assign(data.substr(0, static_cast<std::size_t>(len)));
+        data.remove_prefix(static_cast<std::size_t>(len));
+        return true;
+    }
+};
+
+bool read_varint(std::istream& in, std::uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int c = in.get();
+        if (c == std::char_traits<char>::eof()) return false;
+        v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+bool read_block(std::istream& in, std::string& block) {
+    std::uint64_t len = 0;
+    if (!read_varint(in, len)) return false;
+    block.resize(static_cast<std::size_t>(len));
+    return len == 0 || in.read(block.data(), static_cast<std::streamsize>(block.size())).good();
+}
+
+core::Error corrupt(const char* what) { return core::Error{std::string("corrupt binary result stream: ") + what}; }
+
+} // namespace
+
+BinaryOutputWriter::BinaryOutputWriter(std::ostream& out, core::OutputMode mode, const std::string& pattern, bool no_snippet)
+    : out_(out), snippets_(mode == core::OutputMode::Matches && !no_snippet) {
+    std::string header;
+    header.push_back(static_cast<char>(mode));
+    put_varint(header, snippets_ ? kFlagSnippets : 0);
+    put_bytes(header, pattern);
+    std::string prefix(kBinaryResultsMagic, sizeof(kBinaryResultsMagic));
+    put_varint(prefix, kBinaryResultsVersion);
+    put_varint(prefix, header.size());
+    out_ << prefix << header;
+}
+
+std::uint64_t BinaryOutputWriter::path_id(const std::string& path, bool binary) {
+    const auto [it, added] = ids_.try_emplace(path, ids_.size());
+    if (added) {
+        body_.clear();
+        put_varint(body_, it->second);
+        put_varint(body_, binary ? kPathBinary : 0);
+        put_bytes(body_, path);
+        write_record(BinaryRecordType::Path);
+    }
+    return it->second;
+}
+
+void BinaryOutputWriter::write_record(BinaryRecordType type) {
+    std::string prefix(1, static_cast<char>(type));
+    put_varint(prefix, body_.size());
+    out_ << prefix << body_;
+}
+
+void BinaryOutputWriter::write_match(const core::MatchRecord& record) {
+    const auto id = path_id(record.path, record.binary);
+    // A file's matches arrive together and in order, so after the first each
+    // offset is sent as the (usually small) step from the previous one.
+    const bool same_file = last_id_ == id;
+    body_.clear();
+    put_varint(body_, id);
+    put_varint(body_, same_file ? zigzag(static_cast<std::int64_t>(record.offset - last_offset_)) : record.offset);
+    if (snippets_) put_bytes(body_, record.snippet);
+    write_record(BinaryRecordType::Match);
+    last_id_ = id;
+    last_offset_ = record.offset;
+}
+
+void BinaryOutputWriter::write_file_summary(const core::FileMatchSummary& summary) {
+    const auto id = path_id(summary.path, summary.binary);
+    body_.clear();
+    put_varint(body_, id);
+    put_varint(body_, summary.count);
+    write_record(BinaryRecordType::Summary);
+}
+
+core::Expected<BinaryResultsHeader, core::Error> BinaryResultsReader::read_header() {
+    char magic[sizeof(kBinaryResultsMagic)];
+    if (!in_.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kBinaryResultsMagic)) {
+        return core::Error{"not a binary result stream"};
+    }
+    if (!read_varint(in_, header_.version)) return corrupt("truncated header");
+    if (header_.version != kBinaryResultsVersion) {
+        return core::Error{"unsupported binary result stream version " + std::to_string(header_.version)};
+    }
+    std::string block;
+    if (!read_block(in_, block)) return corrupt("truncated header");
+    Cursor cursor{block};
+    std::uint64_t flags = 0;
+    if (cursor.data.empty() || static_cast<unsigned char>(cursor.data.front()) > static_cast<unsigned char>(core::OutputMode::FilesWithMatches)) {
+        return corrupt("unknown output mode");
+    }
+    header_.mode = static_cast<core::OutputMode>(cursor.data.front());
+    cursor.data.remove_prefix(1);
+    if (!cursor.varint(flags) || !cursor.bytes(header_.pattern)) return corrupt("truncated header");
+    header_.snippets = (flags & kFlagSnippets) != 0;
+    return header_;
+}
+
+core::Expected<std::optional<BinaryResult>, core::Error> BinaryResultsReader::next() {
+    std::string block;
+    while (true) {
+        const int type = in_.get();
+        if (type == std::char_traits<char>::eof()) return std::optional<BinaryResult>{};
+        if (!read_block(in_, block)) return corrupt("truncated record");
+        Cursor cursor{block};
+        std::uint64_t id = 0;
+        switch (static_cast<BinaryRecordType>(type)) {
+        case BinaryRecordType::Path: {
+            std::uint64_t flags = 0;
+            std::string path;
+            if (!cursor.varint(id) || !cursor.varint(flags) || !cursor.bytes(path)) return corrupt("truncated path record");
+            if (id != paths_.size()) return corrupt("path ids out of order");
+            paths_.push_back(std::move(path));
+            binary_.push_back((flags & kPathBinary) != 0);
+            continue;
+        }
+        case BinaryRecordType::Match: {
+            std::uint64_t delta = 0;
+            BinaryResult result;
+            if (!cursor.varint(id) || !cursor.varint(delta)) return corrupt("truncated match record");
+            if (id >= paths_.size()) return corrupt("unknown path id");
+            if (header_.snippets && !cursor.bytes(result.match.snippet)) return corrupt("truncated match record");
+            const bool same_file = last_id_ == id;
+            result.type = BinaryRecordType::Match;
+            result.match.path = paths_[id];
+            result.match.offset = same_file ? last_offset_ + static_cast<std::uintmax_t>(unzigzag(delta)) : delta;
+            result.match.binary = binary_[id];
+            last_id_ = id;
+            last_offset_ = result.match.offset;
+            return std::optional<BinaryResult>{std::move(result)};
+        }
+        case BinaryRecordType::Summary: {
+            std::uint64_t count = 0;
+            if (!cursor.varint(id) || !cursor.varint(count)) return corrupt("truncated summary record");
+            if (id >= paths_.size()) return corrupt("unknown path id");
+            BinaryResult result;
+            result.type = BinaryRecordType::Summary;
+            result.summary = {paths_[id], static_cast<std::size_t>(count), binary_[id]};
+            return std::optional<BinaryResult>{std::move(result)};
+        }
+        default:
+            continue; // a record type added by a later version
+        }
+    }
+}
+
+} // namespace zenith::platform
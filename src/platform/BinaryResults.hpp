@@ -0,0 +1,78 @@
+#pragma once
+
+#include "core/Expected.hpp"
+#include "core/Interfaces.hpp"
+#include "core/Types.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zenith::platform {
+
+// `--format binary`: a length-prefixed record stream for machine consumers
+// (layout in docs/CLI.md). Integers are LEB128 varints; paths are sent once and
+// referred to by id afterwards.
+inline constexpr char kBinaryResultsMagic[4] = {'Z', 'S', 'R', 'B'};
+inline constexpr std::uint64_t kBinaryResultsVersion = 1;
+
+enum class BinaryRecordType : std::uint8_t { Path = 1, Match = 2, Summary = 3 };
+
+struct BinaryResultsHeader {
+    std::uint64_t version{kBinaryResultsVersion};
+    core::OutputMode mode{core::OutputMode::Matches};
+    bool snippets{true};
+    std::string pattern;
+};
+
+class BinaryOutputWriter final : public core::IOutputWriter {
+public:
+    // Writes the stream header.
+    BinaryOutputWriter(std::ostream& out, core::OutputMode mode, const std::string& pattern, bool no_snippet);
+    void write_match(const core::MatchRecord& record) override;
+    void write_file_summary(const core::FileMatchSummary& summary) override;
+
+private:
+    // Id of `path`, sending its path record first when it is new.
+    std::uint64_t path_id(const std::string& path, bool binary);
+    void write_record(BinaryRecordType type);
+
+    std::ostream& out_;
+    bool snippets_;
+    std::unordered_map<std::string, std::uint64_t> ids_;
+    std::string body_; // reused for every record
+    std::optional<std::uint64_t> last_id_; // path of the previous match record
+    std::uintmax_t last_offset_{0};
+};
+
+// One decoded record: a match (Matches mode) or a file summary.
+struct BinaryResult {
+    BinaryRecordType type{BinaryRecordType::Match};
+    core::MatchRecord match;
+    core::FileMatchSummary summary;
+};
+
+// Reads a stream written by BinaryOutputWriter. Unknown record types are
+// skipped, so readers of version 1 accept streams that add new ones.
+class BinaryResultsReader {
+public:
+    explicit BinaryResultsReader(std::istream& in) : in_(in) {}
+
+    // Must be called first.
+    core::Expected<BinaryResultsHeader, core::Error> read_header();
+    // The next match or summary; nullopt at the end of the stream.
+    core::Expected<std::optional<BinaryResult>, core::Error> next();
+
+private:
+    std::istream& in_;
+    BinaryResultsHeader header_;
+    std::vector<std::string> paths_;
+    std::vector<bool> binary_;
+    std::optional<std::uint64_t> last_id_;
+    std::uintmax_t last_offset_{0};
+};
+
+} // namespace zenith::platform
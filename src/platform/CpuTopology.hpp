@@ -0,0 +1,28 @@
+#pragma once
+
+#include "core/Interfaces.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace zenith::platform {
+
+// NUMA nodes and their CPUs, read once at construction: sysfs on Linux,
+// GetNumaNodeProcessorMaskEx on Windows. Elsewhere there is a single node and
+// pinning is unsupported.
+class CpuTopology final : public core::ICpuTopology {
+public:
+    CpuTopology();
+
+    std::size_t node_count() const override { return nodes_.empty() ? 1 : nodes_.size(); }
+    bool pin_current_thread(std::size_t node) const override;
+
+private:
+    struct Node {
+        std::uint16_t group{0}; // Windows processor group
+        std::vector<unsigned> cpus;
+    };
+    std::vector<Node> nodes_;
+};
+
+} // namespace zenith::platform
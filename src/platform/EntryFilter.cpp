@@ -0,0 +1,80 @@
+#include "EntryFilter.hpp"
+
+#include "Glob.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+namespace zenith::platform {
+namespace {
+
+std::string to_lower(std::string_view s) {
+    std::string out(s);
+    std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return out;
+}
+
+} // namespace
+
+bool EntryFilter::needs_normalized() const {
+    return !request_.exclude_globs.empty() || !request_.include_globs.empty() || !request_.no_ignore;
+}
+
+bool EntryFilter::prune_dir(std::string_view name, const std::string& normalized) const {
+    if (request_.ignore_hidden && !name.empty() && name[0] == '.') return true;
+    if (!request_.exclude_dirs.empty() && basename_match(name, request_.exclude_dirs)) return true;
+    return !request_.exclude_globs.empty() && match_any(request_.exclude_globs, normalized + "/x");
+}
+
+bool EntryFilter::include_file(std::string_view name, std::string_view parent_name, const std::string& normalized, std::uintmax_t size) const {
+    if (request_.ignore_hidden && !name.empty() && name[0] == '.') return false;
+    if (!request_.exclude_dirs.empty() && basename_match(parent_name, request_.exclude_dirs)) return false;
+    if (!request_.exclude_globs.empty() && match_any(request_.exclude_globs, normalized)) return false;
+    if (!request_.extensions.empty() && !request_.extensions.contains(normalize_extension(name))) return false;
+    if (!request_.include_globs.empty() && !match_any(request_.include_globs, normalized)) return false;
+    if (request_.max_bytes.has_value() && size > *request_.max_bytes) return false;
+    return true;
+}
+
+std::vector<std::string> load_ignore_patterns(const std::filesystem::path& dir) {
+    std::vector<std::string> patterns;
+    std::ifstream in(dir / ".zenithignore");
+    if (!in) {
+        return patterns;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        patterns.push_back(normalize_for_match((dir / line).lexically_normal().generic_string()));
+    }
+    return patterns;
+}
+
+bool match_any(const std::vector<std::string>& globs, const std::string& normalized) {
+    for (const auto& g : globs) {
+        if (glob_match(g, normalized)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string normalize_extension(std::string_view name) {
+    const auto dot = name.rfind('.');
+    if (dot == std::string_view::npos || dot == 0 || name == "..") return {};
+    return to_lower(name.substr(dot));
+}
+
+bool basename_match(std::string_view name, const std::vector<std::string>& patterns) {
+#ifdef _WIN32
+    const auto lowered = to_lower(name);
+    return std::any_of(patterns.begin(), patterns.end(), [&](const std::string& p) { return to_lower(p) == lowered; });
+#else
+    return std::find(patterns.begin(), patterns.end(), name) != patterns.end();
+#endif
+}
+
+} // namespace zenith::platform
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core/Types.hpp"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zenith::platform {
+
+// Request filters shared by the directory enumerators, on plain names and
+// normalized ('/'-separated) paths so backends need not build std::filesystem
+// paths per entry.
+class EntryFilter {
+public:
+    explicit EntryFilter(const core::SearchRequest& request) : request_(request) {}
+
+    // Whether checks need the entry's normalized path (globs or ignore files).
+    bool needs_normalized() const;
+    // --max-bytes filters on the size; --dedup-content groups files by it,
+    // --small-files-first orders them by it, and --timeout reports it as coverage.
+    // Reading does not need it: the engine learns an unknown size when it opens
+    // the file, before choosing between a whole read, a mapping and a stream, so
+    // enumerators that can skip the lookup should.
+    bool needs_size() const {
+        return request_.max_bytes.has_value() || request_.dedup_content || request_.small_files_first || request_.timeout.has_value();
+    }
+
+    // --ignore-hidden, --exclude-dir and --exclude for a directory.
+    bool prune_dir(std::string_view name, const std::string& normalized) const;
+    // --ignore-hidden, --exclude-dir (on the parent's name), --exclude, --ext, --glob
+    // and --max-bytes for a file. `size` is only consulted when needs_size().
+    bool include_file(std::string_view name, std::string_view parent_name, const std::string& normalized, std::uintmax_t size) const;
+
+private:
+    const core::SearchRequest& request_;
+};
+
+// `.zenithignore` patterns of `dir`, each anchored at the directory and normalized.
+std::vector<std::string> load_ignore_patterns(const std::filesystem::path& dir);
+bool match_any(const std::vector<std::string>& globs, const std::string& normalized);
+
+// Lowercased extension with std::filesystem::path::extension() rules (".bashrc" has none).
+std::string normalize_extension(std::string_view name);
+bool basename_match(std::string_view name, const std::vector<std::string>& patterns);
+
+} // namespace zenith::platform
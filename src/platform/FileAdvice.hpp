@@ -0,0 +1,11 @@
+#pragma once
+
+#include <filesystem>
+
+namespace zenith::platform {
+
+// Asks the kernel to start reading `path` into the page cache without waiting for
+// it. Best effort: errors are ignored, and platforms without such a hint do nothing.
+void advise_will_need(const std::filesystem::path& path);
+
+} // namespace zenith::platform
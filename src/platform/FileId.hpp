@@ -0,0 +1,18 @@
+#pragma once
+
+#include "core/Types.hpp"
+
+#include <filesystem>
+#include <optional>
+
+namespace zenith::platform {
+
+// Identity of the file a path resolves to: (st_dev, st_ino) on POSIX, (volume
+// serial, file index) on Windows. nullopt when it cannot be determined.
+std::optional<core::FileId> query_file_id(const std::filesystem::path& path);
+// Identity plus size and modification time, from the same single lookup.
+std::optional<core::FileStamp> query_file_stamp(const std::filesystem::path& path);
+// Current time on the clock and epoch FileStamp::mtime_ns is reported in.
+std::int64_t file_stamp_now_ns();
+
+} // namespace zenith::platform
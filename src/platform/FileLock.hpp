@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core/Expected.hpp"
+#include "core/Types.hpp"
+
+#include <filesystem>
+
+namespace zenith::platform {
+
+// Exclusive lock on a lock file, held until the object is destroyed: flock on
+// POSIX, LockFileEx on Windows. Advisory, so it only orders processes that take
+// it too. acquire() creates the file if needed and blocks until granted.
+class FileLock {
+public:
+    static core::Expected<FileLock, core::Error> acquire(const std::filesystem::path& path);
+
+    FileLock(FileLock&& other) noexcept;
+    FileLock& operator=(FileLock&& other) noexcept;
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+    ~FileLock();
+
+private:
+#ifdef _WIN32
+    using Handle = void*;
+#else
+    using Handle = int;
+#endif
+    explicit FileLock(Handle handle) : handle_(handle) {}
+    void release();
+
+    Handle handle_;
+};
+
+} // namespace zenith::platform
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "core/Interfaces.hpp"
+
+namespace zenith::platform {
+
+// Linux enumerator: reads directories with getdents64 and classifies entries by
+// d_type, so regular files and directories cost no stat. Subdirectories are opened
+// with openat relative to the parent descriptor. Sizes are fetched with statx only
+// when EntryFilter::needs_size() (FileItem::kUnknownSize otherwise); the engine
+// learns the others from the open that reads the file.
+// Followed symlink cycles are cut by (dev, ino). Filters match StdFilesystemEnumerator's.
+class GetdentsEnumerator final : public core::IFileEnumerator {
+public:
+    core::FileList enumerate(const core::SearchRequest& request, std::stop_token stop_token, const ErrorCallback& on_error) const override;
+};
+
+} // namespace zenith::platform
@@ -6,7 +6,14 @@ namespace zenith::platform {
 
 class MappedFileProvider final : public core::IMappedFileProvider {
 public:
+    // Under CachePolicy::Drop a mapped file's pages are evicted when it is closed.
+    explicit MappedFileProvider(core::CachePolicy policy = core::CachePolicy::Normal) : policy_(policy) {}
+
     core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> open(const std::string& path) const override;
+    core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> open_windowed(const std::string& path) const override;
+
+private:
+    core::CachePolicy policy_;
 };
 
 } // namespace zenith::platform
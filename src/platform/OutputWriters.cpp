@@ -1,12 +1,26 @@
 #include "OutputWriters.hpp"
 
+#include "BinaryResults.hpp"
+
+#include <charconv>
+#include <cstdio>
 #include <ostream>
 
 namespace zenith::platform {
+namespace {
+
+void append_number(std::string& out, std::uintmax_t value) {
+    char buf[24];
+    const auto end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+    out.append(buf, end);
+}
+
+} // namespace
 
 void StreamErrorWriter::write_error(const core::Error& error) { out_ << error.message << '\n'; }
 
 void HumanOutputWriter::write_match(const core::MatchRecord& record) {
+    if (!label_.empty()) out_ << label_ << ':';
     out_ << record.path << ':' << record.offset;
     if (!no_snippet_) {
         out_ << ':' << record.snippet;
@@ -15,6 +29,7 @@ void HumanOutputWriter::write_match(const core::MatchRecord& record) {
 }
 
 void HumanOutputWriter::write_file_summary(const core::FileMatchSummary& summary) {
+    if (!label_.empty()) out_ << label_ << ':';
     if (mode_ == core::OutputMode::Count) {
         out_ << summary.path << ':' << summary.count << '\n';
     } else {
@@ -22,30 +37,84 @@ void HumanOutputWriter::write_file_summary(const core::FileMatchSummary& summary
     }
 }
 
+// Records are assembled in `line_`, which keeps its capacity, and written with
+// one call; strings are escaped straight into it.
 void JsonlOutputWriter::write_match(const core::MatchRecord& record) {
-    out_ << "{\"path\":\"" << core::json_escape(record.path) << "\",\"mode\":\"match\",\"pattern\":\""
-         << core::json_escape(pattern_) << "\",\"offset\":" << record.offset << ",\"binary\":" << (record.binary ? "true" : "false");
+    line_.assign("{\"path\":\"");
+    core::append_json_escaped(line_, record.path);
+    line_ += "\",\"mode\":\"match\",\"pattern\":\"";
+    line_ += pattern_;
+    line_ += "\",\"offset\":";
+    append_number(line_, record.offset);
+    line_ += record.binary ? ",\"binary\":true" : ",\"binary\":false";
     if (!no_snippet_) {
-        out_ << ",\"snippet\":\"" << core::json_escape(record.snippet) << "\"";
+        line_ += ",\"snippet\":\"";
+        core::append_json_escaped(line_, record.snippet);
+        line_ += '"';
     }
-    out_ << "}" << '\n';
+    line_ += "}\n";
+    out_.write(line_.data(), static_cast<std::streamsize>(line_.size()));
 }
 
 void JsonlOutputWriter::write_file_summary(const core::FileMatchSummary& summary) {
-    const char* mode_name = mode_ == core::OutputMode::Count ? "count" : "files_with_matches";
-    out_ << "{\"path\":\"" << core::json_escape(summary.path) << "\",\"mode\":\"" << mode_name << "\",\"pattern\":\""
-         << core::json_escape(pattern_) << "\",\"binary\":" << (summary.binary ? "true" : "false");
+    line_.assign("{\"path\":\"");
+    core::append_json_escaped(line_, summary.path);
+    line_ += mode_ == core::OutputMode::Count ? "\",\"mode\":\"count\",\"pattern\":\"" : "\",\"mode\":\"files_with_matches\",\"pattern\":\"";
+    line_ += pattern_;
+    line_ += summary.binary ? "\",\"binary\":true" : "\",\"binary\":false";
     if (mode_ == core::OutputMode::Count) {
-        out_ << ",\"count\":" << summary.count;
+        line_ += ",\"count\":";
+        append_number(line_, summary.count);
+    }
+    line_ += "}\n";
+    out_.write(line_.data(), static_cast<std::streamsize>(line_.size()));
+}
+
+void write_stats(const core::SearchStats& stats, std::ostream& out) {
+    out << "files_enumerated: " << stats.files_enumerated << '\n'
+        << "duplicates_skipped: " << stats.duplicates_skipped << '\n'
+        << "duplicate_bytes_skipped: " << stats.duplicate_bytes_skipped << '\n'
+        << "files_scanned: " << stats.files_scanned << '\n'
+        << "bytes_scanned: " << stats.bytes_scanned << '\n'
+        << "files_completed: " << stats.files_completed << '\n'
+        << "bytes_completed: " << stats.bytes_completed << '\n'
+        << "cache_hits: " << stats.cache_hits << '\n'
+        << "content_duplicates: " << stats.content_duplicates << '\n'
+        << "utf16_files: " << stats.utf16_files << '\n'
+        << "read_ahead_files: " << stats.read_ahead_files << '\n'
+        << "peak_io_threads: " << stats.peak_io_threads << '\n'
+        << "matches: " << stats.matches << '\n';
+    out << "anchors:";
+    if (stats.anchors.empty()) out << " none";
+    for (const auto& a : stats.anchors) {
+        const auto c = static_cast<unsigned char>(a.byte);
+        char buf[8];
+        if (c >= 0x20 && c < 0x7F && c != '\'') {
+            std::snprintf(buf, sizeof(buf), "'%c'", c);
+        } else {
+            std::snprintf(buf, sizeof(buf), "0x%02x", c);
+        }
+        out << ' ' << buf << '@' << a.index;
     }
-    out_ << "}" << '\n';
+    out << '\n'
+        << "peak_retained_bytes: " << stats.peak_retained_bytes << '\n'
+        << "spilled_results: " << stats.spilled_results << '\n';
 }
 
-std::unique_ptr<core::IOutputWriter> make_output_writer(const core::SearchRequest& request, std::ostream& out) {
-    if (request.json_output) {
+void write_jsonl_status(const core::SearchStats& stats, std::ostream& out) {
+    out << "{\"mode\":\"status\",\"timed_out\":" << (stats.timed_out ? "true" : "false")
+        << ",\"files_completed\":" << stats.files_completed << ",\"files_enumerated\":" << stats.files_enumerated
+        << ",\"bytes_completed\":" << stats.bytes_completed << "}\n";
+}
+
+std::unique_ptr<core::IOutputWriter> make_output_writer(const core::SearchRequest& request, std::ostream& out, bool label_query) {
+    if (request.output_format == core::OutputFormat::Jsonl) {
         return std::make_unique<JsonlOutputWriter>(out, request.output_mode, request.pattern, request.no_snippet);
     }
-    return std::make_unique<HumanOutputWriter>(out, request.output_mode, request.no_snippet);
+    if (request.output_format == core::OutputFormat::Binary) {
+        return std::make_unique<BinaryOutputWriter>(out, request.output_mode, request.pattern, request.no_snippet);
+    }
+    return std::make_unique<HumanOutputWriter>(out, request.output_mode, request.no_snippet, label_query ? request.pattern : std::string{});
 }
 
 } // namespace zenith::platform
@@ -7,6 +7,7 @@
 #include <iosfwd>
 #include <memory>
 #include <string>
+#include <utility>
 
 namespace zenith::platform {
 
@@ -21,8 +22,9 @@ private:
 
 class HumanOutputWriter final : public core::IOutputWriter {
 public:
-    HumanOutputWriter(std::ostream& out, core::OutputMode mode, bool no_snippet)
-        : out_(out), mode_(mode), no_snippet_(no_snippet) {}
+    // `label` (with --queries-from, the query's pattern) starts every line.
+    HumanOutputWriter(std::ostream& out, core::OutputMode mode, bool no_snippet, std::string label = {})
+        : out_(out), mode_(mode), no_snippet_(no_snippet), label_(std::move(label)) {}
     void write_match(const core::MatchRecord& record) override;
     void write_file_summary(const core::FileMatchSummary& summary) override;
 
@@ -30,22 +32,33 @@ private:
     std::ostream& out_;
     core::OutputMode mode_;
     bool no_snippet_;
+    std::string label_;
 };
 
 class JsonlOutputWriter final : public core::IOutputWriter {
 public:
     JsonlOutputWriter(std::ostream& out, core::OutputMode mode, const std::string& pattern, bool no_snippet)
-        : out_(out), mode_(mode), pattern_(pattern), no_snippet_(no_snippet) {}
+        : out_(out), mode_(mode), pattern_(core::json_escape(pattern)), no_snippet_(no_snippet) {}
     void write_match(const core::MatchRecord& record) override;
     void write_file_summary(const core::FileMatchSummary& summary) override;
 
 private:
     std::ostream& out_;
     core::OutputMode mode_;
-    std::string pattern_;
+    std::string pattern_; // escaped once
     bool no_snippet_;
+    std::string line_;
 };
 
-std::unique_ptr<core::IOutputWriter> make_output_writer(const core::SearchRequest& request, std::ostream& out);
+// Run summary for --stats, one `key: value` line per counter.
+void write_stats(const core::SearchStats& stats, std::ostream& out);
+
+// Trailing JSONL record of a run with --timeout: whether it timed out and how
+// many files and bytes its results cover.
+void write_jsonl_status(const core::SearchStats& stats, std::ostream& out);
+
+// With `label_query`, human output starts each line with the request's pattern
+// and a colon (JSON records always carry it).
+std::unique_ptr<core::IOutputWriter> make_output_writer(const core::SearchRequest& request, std::ostream& out, bool label_query = false);
 
 } // namespace zenith::platform
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core/Expected.hpp"
+#include "core/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace zenith::platform {
+
+// Sequential reader for --cache-policy drop and direct. Drop reads through the
+// page cache and evicts each range once it has been read. Direct bypasses the
+// cache (O_DIRECT, F_NOCACHE on macOS, FILE_FLAG_NO_BUFFERING on Windows); when
+// the file system refuses it, or a read is not aligned, the rest of the file is
+// read buffered and dropped as in Drop. Normal is a plain buffered read.
+class RawFile {
+public:
+    // Direct reads need the buffer address and length aligned to this.
+    static constexpr std::size_t kDirectAlignment = 4096;
+
+    static core::Expected<RawFile, core::Error> open(const std::string& path, core::CachePolicy policy);
+
+    RawFile(RawFile&& other) noexcept;
+    RawFile& operator=(RawFile&& other) noexcept;
+    RawFile(const RawFile&) = delete;
+    RawFile& operator=(const RawFile&) = delete;
+    ~RawFile();
+
+    // Size at open time.
+    std::uint64_t size() const { return size_; }
+    // Reads up to `n` bytes at the current position; 0 at the end of the file.
+    core::Expected<std::size_t, core::Error> read(std::byte* dst, std::size_t n);
+
+private:
+#ifdef _WIN32
+    using Handle = void*;
+#else
+    using Handle = int;
+#endif
+    RawFile(Handle handle, std::string path, core::CachePolicy policy, bool direct, std::uint64_t size)
+        : handle_(handle), path_(std::move(path)), policy_(policy), direct_(direct), size_(size) {}
+    // Leaves direct mode for the rest of the file.
+    bool go_buffered();
+    void drop_read_pages();
+    void close();
+
+    Handle handle_;
+    std::string path_;
+    core::CachePolicy policy_;
+    bool direct_;
+    std::uint64_t size_;
+    std::uint64_t offset_{0};
+    std::uint64_t dropped_{0}; // pages before this offset were evicted
+};
+
+} // namespace zenith::platform
@@ -0,0 +1,446 @@
+#include "ResultCache.hpp"
+
+#include "FileId.hpp"
+#include "FileLock.hpp"
+#include "MappedFileProvider.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace zenith::platform {
+namespace fs = std::filesystem;
+
+namespace {
+
+// Store layout: magic, version, then segments. A segment is its generation,
+// query count, record count and touch count; its queries as (u32 length,
+// bytes), numbered from 0 within the segment; its records as (device, inode,
+// size, mtime_ns, u32 query, u32 payload length, last_used generation,
+// payload); its touches as (device, inode, size, mtime_ns, u32 query), which
+// raise an earlier record's last_used to the segment's generation. A later
+// record for the same key replaces an earlier one.
+constexpr char kMagic[4] = {'Z', 'S', 'R', 'C'};
+constexpr std::uint32_t kVersion = 2;
+constexpr const char* kStoreName = "results.v1";
+constexpr const char* kLockName = "results.lock";
+constexpr std::size_t kHeaderBytes = sizeof(kMagic) + sizeof(kVersion);
+constexpr std::size_t kSegmentHeaderBytes = 3 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+constexpr std::size_t kRecordHeaderBytes = 4 * sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t);
+// A file modified this recently may be modified again without its mtime moving:
+// FAT keeps mtimes to 2 s, and Linux stamps them from a clock that ticks per
+// jiffy. Such files are not cached until they are older than this.
+constexpr std::int64_t kMtimeGranularityNs = 2'000'000'000;
+
+template <typename T>
+void put(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+struct Reader {
+    std::string_view in;
+    std::size_t pos{0};
+
+    template <typename T>
+    bool get(T& value) {
+        if (in.size() - pos < sizeof(value)) return false;
+        std::memcpy(&value, in.data() + pos, sizeof(value));
+        pos += sizeof(value);
+        return true;
+    }
+    bool take(std::size_t n, std::string_view& out) {
+        if (in.size() - pos < n) return false;
+        out = in.substr(pos, n);
+        pos += n;
+        return true;
+    }
+    bool get_varint(std::uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            const auto c = static_cast<unsigned char>(in[pos++]);
+            v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+            if ((c & 0x80) == 0) return true;
+        }
+        return false;
+    }
+};
+
+void put_varint(std::string& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// Payload: count, flags (1 = any match, 2 = binary), match count, then (offset, snippet) pairs.
+std::string encode(const core::FileResult& fr) {
+    std::string out;
+    put_varint(out, fr.count);
+    out.push_back(static_cast<char>((fr.any_match ? 1 : 0) | (fr.binary ? 2 : 0)));
+    put_varint(out, fr.matches.size());
+    for (const auto& m : fr.matches) {
+        put_varint(out, m.offset);
+        put_varint(out, m.snippet.size());
+        out += m.snippet;
+    }
+    return out;
+}
+
+std::optional<core::FileResult> decode(std::string_view payload) {
+    Reader r{payload};
+    core::FileResult fr;
+    std::uint64_t count = 0;
+    std::uint8_t flags = 0;
+    std::uint64_t n = 0;
+    if (!r.get_varint(count) || !r.get(flags) || !r.get_varint(n) || n > payload.size()) return std::nullopt;
+    fr.count = static_cast<std::size_t>(count);
+    fr.any_match = (flags & 1) != 0;
+    fr.binary = (flags & 2) != 0;
+    fr.matches.resize(static_cast<std::size_t>(n));
+    for (auto& m : fr.matches) {
+        std::uint64_t len = 0;
+        std::string_view snippet;
+        if (!r.get_varint(m.offset) || !r.get_varint(len) || !r.take(static_cast<std::size_t>(len), snippet)) return std::nullopt;
+        m.snippet = snippet;
+    }
+    return fr;
+}
+
+} // namespace
+
+std::size_t DiskResultCache::KeyHash::operator()(const Key& k) const {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (const std::uint64_t v : {k.stamp.id.device, k.stamp.id.inode, static_cast<std::uint64_t>(k.stamp.size),
+                                  static_cast<std::uint64_t>(k.stamp.mtime_ns), static_cast<std::uint64_t>(k.query)}) {
+        h = (h ^ v) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    return static_cast<std::size_t>(h);
+}
+
+core::Expected<std::unique_ptr<DiskResultCache>, core::Error> DiskResultCache::open(const fs::path& dir, std::uintmax_t max_bytes) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) return core::Error{"cannot create cache directory " + dir.string() + ": " + ec.message()};
+    std::unique_ptr<DiskResultCache> cache(new DiskResultCache(dir, max_bytes));
+    cache->load();
+    return cache;
+}
+
+void DiskResultCache::load() {
+    mapping_.reset();
+    records_.clear();
+    queries_.clear();
+    query_ids_.clear();
+    generation_ = 0;
+    newest_records_ = 0;
+    store_id_ = {};
+    store_bytes_ = 0;
+    const auto path = dir_ / kStoreName;
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return;
+    const auto id = query_file_id(path);
+    auto mapped = MappedFileProvider().open(path.string());
+    if (!id.has_value() || !mapped) return;
+    const auto bytes = mapped.value()->bytes();
+    const std::string_view all(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    Reader r{all};
+    std::string_view magic;
+    std::uint32_t version = 0;
+    if (!r.take(sizeof(kMagic), magic) || std::memcmp(magic.data(), kMagic, sizeof(kMagic)) != 0 || !r.get(version) ||
+        version != kVersion) {
+        return;
+    }
+    mapping_ = std::move(mapped.value());
+    store_id_ = *id;
+    store_bytes_ = kHeaderBytes + read_segments(all.substr(kHeaderBytes), true, generation_);
+    for (const auto& [key, record] : records_) {
+        if (record.last_used == generation_) ++newest_records_;
+    }
+}
+
+std::size_t DiskResultCache::read_segments(std::string_view bytes, bool index, std::uint64_t& generation) {
+    Reader r{bytes};
+    std::size_t valid = 0;
+    std::vector<std::uint32_t> ids;
+    std::vector<std::pair<Key, Record>> records;
+    std::vector<Key> touches;
+    while (r.pos < bytes.size()) {
+        std::uint64_t segment_generation = 0;
+        std::uint32_t query_count = 0;
+        std::uint64_t record_count = 0;
+        std::uint64_t touch_count = 0;
+        if (!r.get(segment_generation) || !r.get(query_count) || !r.get(record_count) || !r.get(touch_count)) break;
+        // Staged, so a segment that turns out damaged adds nothing.
+        std::vector<std::string_view> texts;
+        records.clear();
+        touches.clear();
+        bool ok = true;
+        for (std::uint32_t i = 0; ok && i < query_count; ++i) {
+            std::uint32_t len = 0;
+            std::string_view text;
+            ok = r.get(len) && r.take(len, text);
+            texts.push_back(text);
+        }
+        if (index) records.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(record_count, (bytes.size() - r.pos) / kRecordHeaderBytes)));
+        for (std::uint64_t i = 0; ok && i < record_count; ++i) {
+            Key key;
+            std::uint64_t size = 0;
+            std::uint32_t len = 0;
+            Record record;
+            ok = r.get(key.stamp.id.device) && r.get(key.stamp.id.inode) && r.get(size) && r.get(key.stamp.mtime_ns) && r.get(key.query) &&
+                 r.get(len) && r.get(record.last_used) && r.take(len, record.mapped) && key.query < texts.size();
+            key.stamp.size = static_cast<std::uintmax_t>(size);
+            if (ok && index) records.emplace_back(key, std::move(record));
+        }
+        for (std::uint64_t i = 0; ok && i < touch_count; ++i) {
+            Key key;
+            std::uint64_t size = 0;
+            ok = r.get(key.stamp.id.device) && r.get(key.stamp.id.inode) && r.get(size) && r.get(key.stamp.mtime_ns) && r.get(key.query) &&
+                 key.query < texts.size();
+            key.stamp.size = static_cast<std::uintmax_t>(size);
+            if (ok && index) touches.push_back(key);
+        }
+        if (!ok) break;
+        valid = r.pos;
+        generation = std::max(generation, segment_generation);
+        if (!index) continue;
+        ids.clear();
+        for (const auto text : texts) ids.push_back(intern_query(text));
+        for (auto& [key, record] : records) {
+            key.query = ids[key.query];
+            records_.insert_or_assign(key, std::move(record));
+        }
+        for (auto& key : touches) {
+            key.query = ids[key.query];
+            if (const auto it = records_.find(key); it != records_.end()) {
+                it->second.last_used = std::max(it->second.last_used, segment_generation);
+            }
+        }
+    }
+    return valid;
+}
+
+std::uint32_t DiskResultCache::intern_query(std::string_view query) {
+    auto [it, inserted] = query_ids_.try_emplace(std::string(query), static_cast<std::uint32_t>(queries_.size()));
+    if (inserted) queries_.emplace_back(query);
+    return it->second;
+}
+
+std::optional<core::FileStamp> DiskResultCache::stamp(const std::string& path) const {
+    auto stamp = query_file_stamp(path);
+    if (!stamp.has_value() || !stamp->id.known()) return std::nullopt;
+    if (stamp->mtime_ns > file_stamp_now_ns() - kMtimeGranularityNs) return std::nullopt;
+    return stamp;
+}
+
+std::optional<core::FileResult> DiskResultCache::lookup(const core::FileStamp& stamp, const std::string& query) {
+    std::scoped_lock lock(mutex_);
+    const auto q = query_ids_.find(query);
+    if (q == query_ids_.end()) return std::nullopt;
+    const auto it = records_.find({stamp, q->second});
+    if (it == records_.end()) return std::nullopt;
+    auto result = decode(it->second.payload());
+    if (!result.has_value()) {
+        records_.erase(it);
+        return std::nullopt;
+    }
+    it->second.used = true;
+    return result;
+}
+
+void DiskResultCache::store(const core::FileStamp& stamp, const std::string& query, const core::FileResult& result) {
+    auto payload = encode(result);
+    if (payload.size() > UINT32_MAX) return;
+    std::scoped_lock lock(mutex_);
+    auto& record = records_[{stamp, intern_query(query)}];
+    record.mapped = {};
+    record.owned = std::move(payload);
+    record.used = false;
+}
+
+std::size_t DiskResultCache::size() const {
+    std::scoped_lock lock(mutex_);
+    return records_.size();
+}
+
+void DiskResultCache::write_segment(std::ostream& out, std::uint64_t generation, const std::vector<Entry>& records,
+                                    const std::vector<Entry>& touches) {
+    std::unordered_map<std::string_view, std::uint32_t> local;
+    std::vector<std::string_view> texts;
+    auto id_of = [&](std::string_view text) {
+        auto [it, inserted] = local.try_emplace(text, static_cast<std::uint32_t>(texts.size()));
+        if (inserted) texts.push_back(text);
+        return it->second;
+    };
+    for (const auto& e : records) id_of(e.query);
+    for (const auto& e : touches) id_of(e.query);
+
+    put(out, generation);
+    put(out, static_cast<std::uint32_t>(texts.size()));
+    put(out, static_cast<std::uint64_t>(records.size()));
+    put(out, static_cast<std::uint64_t>(touches.size()));
+    for (const auto text : texts) {
+        put(out, static_cast<std::uint32_t>(text.size()));
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    auto put_key = [&](const Entry& e) {
+        put(out, e.stamp->id.device);
+        put(out, e.stamp->id.inode);
+        put(out, static_cast<std::uint64_t>(e.stamp->size));
+        put(out, e.stamp->mtime_ns);
+        put(out, local.at(e.query));
+    };
+    for (const auto& e : records) {
+        put_key(e);
+        put(out, static_cast<std::uint32_t>(e.payload.size()));
+        put(out, e.last_used);
+        out.write(e.payload.data(), static_cast<std::streamsize>(e.payload.size()));
+    }
+    for (const auto& e : touches) put_key(e);
+}
+
+core::Expected<void, core::Error> DiskResultCache::save() {
+    std::scoped_lock lock(mutex_);
+    std::vector<Pending> fresh;
+    std::vector<Pending> touched;
+    std::size_t newest_hits = 0;
+    bool older_hits = false;
+    for (const auto& [key, record] : records_) {
+        if (!record.owned.empty()) {
+            fresh.push_back({key.stamp, queries_[key.query], record.owned});
+        } else if (record.used) {
+            touched.push_back({key.stamp, queries_[key.query], {}});
+            if (record.last_used == generation_) {
+                ++newest_hits;
+            } else {
+                older_hits = true;
+            }
+        }
+    }
+    // Hitting exactly the newest generation again changes no recency.
+    if (fresh.empty() && (touched.empty() || (!older_hits && newest_hits == newest_records_))) return {};
+
+    auto file_lock = FileLock::acquire(dir_ / kLockName);
+    if (!file_lock) return file_lock.error();
+
+    // Other processes may have appended to the store, or replaced it, since it
+    // was loaded. Their complete segments are kept; a partial one, from a writer
+    // that died, is cut off before appending.
+    const auto store_path = dir_ / kStoreName;
+    std::error_code ec;
+    const auto current_id = query_file_id(store_path);
+    std::uintmax_t current_bytes = fs::file_size(store_path, ec);
+    std::uint64_t generation = generation_;
+    bool can_append = mapping_ != nullptr && !ec && current_id.has_value() && *current_id == store_id_ && current_bytes >= store_bytes_;
+    if (can_append && current_bytes > store_bytes_) {
+        std::string tail(static_cast<std::size_t>(current_bytes - store_bytes_), '\0');
+        std::ifstream in(store_path, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(store_bytes_));
+        in.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+        tail.resize(static_cast<std::size_t>(in.gcount()));
+        const auto valid = read_segments(tail, false, generation);
+        if (valid < current_bytes - store_bytes_) {
+            current_bytes = store_bytes_ + valid;
+            fs::resize_file(store_path, current_bytes, ec);
+            can_append = !ec;
+        }
+    }
+
+    ++generation;
+    if (can_append) {
+        std::vector<Entry> records;
+        std::vector<Entry> touches;
+        for (const auto& p : fresh) records.push_back({&p.stamp, p.query, p.payload, generation});
+        for (const auto& p : touched) touches.push_back({&p.stamp, p.query, {}, generation});
+        std::ostringstream segment;
+        write_segment(segment, generation, records, touches);
+        const auto bytes = std::move(segment).str();
+        if (current_bytes + bytes.size() <= max_bytes_) {
+            // Unmapped first, as Windows cannot extend a mapped file.
+            mapping_.reset();
+            bool ok = false;
+            {
+                std::ofstream out(store_path, std::ios::binary | std::ios::app);
+                ok = out && out.write(bytes.data(), static_cast<std::streamsize>(bytes.size())) && out.flush();
+            }
+            if (!ok) fs::resize_file(store_path, current_bytes, ec);
+            load();
+            if (!ok) return core::Error{"cannot append to result cache " + store_path.string()};
+            return {};
+        }
+    }
+
+    // Merged with the store as it is now, then compacted.
+    load();
+    generation = std::max(generation, generation_ + 1);
+    for (auto& p : fresh) {
+        auto& record = records_[{p.stamp, intern_query(p.query)}];
+        record.mapped = {};
+        record.owned = std::move(p.payload);
+        record.last_used = generation;
+    }
+    for (const auto& p : touched) {
+        const auto q = query_ids_.find(p.query);
+        if (q == query_ids_.end()) continue;
+        if (const auto it = records_.find({p.stamp, q->second}); it != records_.end()) it->second.last_used = generation;
+    }
+    return rewrite(generation);
+}
+
+core::Expected<void, core::Error> DiskResultCache::rewrite(std::uint64_t generation) {
+    // Most recently used first, until the cap; each kept query is written once.
+    std::vector<std::pair<const Key*, const Record*>> order;
+    order.reserve(records_.size());
+    for (const auto& [key, record] : records_) order.emplace_back(&key, &record);
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.second->last_used > b.second->last_used; });
+
+    std::vector<bool> counted(queries_.size(), false);
+    std::uintmax_t total = kHeaderBytes + kSegmentHeaderBytes;
+    std::vector<Entry> kept;
+    for (const auto& [key, record] : order) {
+        std::uintmax_t bytes = kRecordHeaderBytes + record->payload().size();
+        if (!counted[key->query]) bytes += sizeof(std::uint32_t) + queries_[key->query].size();
+        if (total + bytes > max_bytes_) continue; // a smaller, older record may still fit
+        total += bytes;
+        counted[key->query] = true;
+        kept.push_back({&key->stamp, queries_[key->query], record->payload(), record->last_used});
+    }
+
+    const auto store_path = dir_ / kStoreName;
+    const auto tmp_path = dir_ / (std::string(kStoreName) + ".tmp" + std::to_string(std::random_device{}()));
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return core::Error{"cannot write result cache " + tmp_path.string()};
+        out.write(kMagic, sizeof(kMagic));
+        put(out, kVersion);
+        write_segment(out, generation, kept, {});
+        if (!out.flush()) {
+            out.close();
+            std::error_code ec;
+            fs::remove(tmp_path, ec);
+            return core::Error{"cannot write result cache " + tmp_path.string()};
+        }
+    }
+
+    // The old store stays mapped until here (Windows cannot replace a mapped file).
+    kept.clear();
+    order.clear();
+    records_.clear();
+    mapping_.reset();
+    std::error_code ec;
+    fs::rename(tmp_path, store_path, ec);
+    if (ec) {
+        const auto message = ec.message();
+        fs::remove(tmp_path, ec);
+        load();
+        return core::Error{"cannot replace result cache " + store_path.string() + ": " + message};
+    }
+    load();
+    return {};
+}
+
+} // namespace zenith::platform
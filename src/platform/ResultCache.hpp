@@ -0,0 +1,98 @@
+#pragma once
+
+#include "core/Interfaces.hpp"
+
+#include <filesystem>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zenith::platform {
+
+// On-disk IResultCache (--cache DIR): a single store file made of segments. A
+// segment carries its own query table, records keyed by (file stamp, query), and
+// touches that mark earlier records as used, so it reads the same wherever it
+// ends up. The store is memory-mapped at open and payloads are decoded only on a
+// hit. save() appends one segment with the records stored and the records hit
+// during the run, under a lock file shared by every process using the
+// directory. When the segment would pass the size cap, the store is merged and
+// rewritten atomically instead, keeping the most recently used records. Each
+// segment is one step of the LRU clock; a run that stored nothing and hit
+// exactly the records of the newest step writes nothing. Records use native
+// byte order. A store whose header fails validation is discarded and rebuilt; a
+// damaged tail is ignored, and cut off by the next save.
+class DiskResultCache final : public core::IResultCache {
+public:
+    static constexpr std::uintmax_t kDefaultMaxBytes = 256U * 1024U * 1024U;
+
+    static core::Expected<std::unique_ptr<DiskResultCache>, core::Error> open(const std::filesystem::path& dir,
+                                                                              std::uintmax_t max_bytes = kDefaultMaxBytes);
+
+    std::optional<core::FileStamp> stamp(const std::string& path) const override;
+    std::optional<core::FileResult> lookup(const core::FileStamp& stamp, const std::string& query) override;
+    void store(const core::FileStamp& stamp, const std::string& query, const core::FileResult& result) override;
+
+    // Writes what this run stored and hit, if the store needs it, and reopens the
+    // store.
+    core::Expected<void, core::Error> save();
+
+    std::size_t size() const;
+
+private:
+    struct Key {
+        core::FileStamp stamp;
+        std::uint32_t query{0};
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& k) const;
+    };
+    struct Record {
+        std::string_view mapped; // payload inside the store mapping, or empty
+        std::string owned;       // payload stored during this run
+        std::uint64_t last_used{0};
+        bool used{false}; // hit during this run
+        std::string_view payload() const { return owned.empty() ? mapped : std::string_view(owned); }
+    };
+    // A record (with a payload) or a touch (without) to write, by query text, so
+    // it survives reloading the store.
+    struct Pending {
+        core::FileStamp stamp;
+        std::string query;
+        std::string payload;
+    };
+    struct Entry {
+        const core::FileStamp* stamp;
+        std::string_view query;
+        std::string_view payload;
+        std::uint64_t last_used;
+    };
+
+    DiskResultCache(std::filesystem::path dir, std::uintmax_t max_bytes) : dir_(std::move(dir)), max_bytes_(max_bytes) {}
+    // Maps and indexes the store file; a missing store, or one with an invalid
+    // header, leaves the cache empty.
+    void load();
+    // Reads the segments at the start of `bytes` and returns the length of the
+    // complete, valid ones; `index` adds their records to this cache.
+    std::size_t read_segments(std::string_view bytes, bool index, std::uint64_t& generation);
+    std::uint32_t intern_query(std::string_view query);
+    core::Expected<void, core::Error> rewrite(std::uint64_t generation);
+    static void write_segment(std::ostream& out, std::uint64_t generation, const std::vector<Entry>& records,
+                              const std::vector<Entry>& touches);
+
+    std::filesystem::path dir_;
+    std::uintmax_t max_bytes_;
+    std::unique_ptr<core::IMappedFile> mapping_;
+    mutable std::mutex mutex_;
+    std::uint64_t generation_{0}; // newest generation in the store
+    std::size_t newest_records_{0}; // records used in generation_
+    core::FileId store_id_; // the store file that was loaded
+    std::uintmax_t store_bytes_{0}; // its valid length
+    std::vector<std::string> queries_;
+    std::unordered_map<std::string, std::uint32_t> query_ids_;
+    std::unordered_map<Key, Record, KeyHash> records_;
+};
+
+} // namespace zenith::platform
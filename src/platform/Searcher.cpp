@@ -0,0 +1,19 @@
+#include "Searcher.hpp"
+
+namespace zenith::platform {
+
+Searcher::Searcher(core::IErrorWriter& errors, core::CachePolicy cache_policy)
+    : reader_(cache_policy),
+      mapped_provider_(cache_policy),
+      engine_(enumerator_, reader_, mapped_provider_, naive_algorithm_, bmh_algorithm_, boyer_moore_algorithm_, output_, errors) {
+    engine_.set_worker_pool(&pool_);
+}
+
+core::SearchStats Searcher::search(const core::SearchRequest& request,
+                                   std::span<const std::string> patterns,
+                                   const core::QueryResultCallback& on_result,
+                                   std::stop_token stop_token) const {
+    return engine_.run_batch(request, patterns, on_result, stop_token);
+}
+
+} // namespace zenith::platform
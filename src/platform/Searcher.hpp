@@ -0,0 +1,54 @@
+#pragma once
+
+#include "MappedFileProvider.hpp"
+#include "StdFileReader.hpp"
+#include "StdFilesystemEnumerator.hpp"
+#include "core/Interfaces.hpp"
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/SearchEngine.hpp"
+#include "core/Types.hpp"
+#include "core/WorkerPool.hpp"
+
+#include <span>
+#include <stop_token>
+#include <string>
+
+namespace zenith::platform {
+
+// Embedding entry point: the default enumerator, reader and kernels wired to one
+// engine whose worker threads persist across searches. Each search takes a batch
+// of patterns over the request's roots, reads every file once, and streams
+// results per file and query to the callback. One search runs at a time.
+// The reader's cache policy is fixed here; SearchRequest::cache_policy should match it.
+class Searcher {
+public:
+    explicit Searcher(core::IErrorWriter& errors, core::CachePolicy cache_policy = core::CachePolicy::Normal);
+
+    core::SearchStats search(const core::SearchRequest& request,
+                             std::span<const std::string> patterns,
+                             const core::QueryResultCallback& on_result,
+                             std::stop_token stop_token = {}) const;
+
+    // For optional components (result cache, trace, NUMA topology).
+    core::SearchEngine& engine() { return engine_; }
+
+private:
+    // run_batch reports through the callback; nothing reaches this writer.
+    class NullOutputWriter final : public core::IOutputWriter {
+    public:
+        void write_match(const core::MatchRecord&) override {}
+        void write_file_summary(const core::FileMatchSummary&) override {}
+    };
+
+    StdFilesystemEnumerator enumerator_;
+    StdFileReader reader_;
+    MappedFileProvider mapped_provider_;
+    core::NaiveSearchAlgorithm naive_algorithm_;
+    core::BmhSearchAlgorithm bmh_algorithm_;
+    core::BoyerMooreSearchAlgorithm boyer_moore_algorithm_;
+    NullOutputWriter output_;
+    core::WorkerPool pool_;
+    core::SearchEngine engine_;
+};
+
+} // namespace zenith::platform
@@ -1,11 +1,55 @@
 #include "StdFileReader.hpp"
 
+#include "FileAdvice.hpp"
+#include "RawFile.hpp"
+
+#include <algorithm>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <new>
 #include <vector>
 
 namespace zenith::platform {
+namespace {
+
+constexpr std::size_t kAlign = RawFile::kDirectAlignment;
+
+struct AlignedDelete {
+    void operator()(std::byte* p) const { ::operator delete[](p, std::align_val_t{kAlign}); }
+};
+using AlignedBuffer = std::unique_ptr<std::byte[], AlignedDelete>;
+
+// Buffer for direct reads: aligned, and at least `bytes` rounded up to the alignment.
+AlignedBuffer make_aligned(std::size_t& bytes) {
+    bytes = bytes == 0 ? kAlign : (bytes + kAlign - 1) / kAlign * kAlign;
+    return AlignedBuffer(static_cast<std::byte*>(::operator new[](bytes, std::align_val_t{kAlign})));
+}
+
+// Reads until `n` bytes or the end of the file.
+core::Expected<std::size_t, core::Error> fill(RawFile& file, std::byte* dst, std::size_t n) {
+    std::size_t length = 0;
+    while (length < n) {
+        auto got = file.read(dst + length, n - length);
+        if (!got) return got.error();
+        if (got.value() == 0) break;
+        length += got.value();
+    }
+    return length;
+}
+
+} // namespace
 
 core::Expected<std::string, core::Error> StdFileReader::read_prefix(const std::string& path, std::size_t max_bytes) const {
+    if (policy_ != core::CachePolicy::Normal) {
+        auto file = RawFile::open(path, policy_);
+        if (!file) return file.error();
+        std::size_t capacity = max_bytes;
+        const auto buf = make_aligned(capacity);
+        auto got = fill(file.value(), buf.get(), capacity);
+        if (!got) return got.error();
+        return std::string(reinterpret_cast<const char*>(buf.get()), std::min(got.value(), max_bytes));
+    }
     std::ifstream input(path, std::ios::binary);
     if (!input) {
         return core::Error{"unable to open file"};
@@ -21,6 +65,21 @@ core::Expected<void, core::Error> StdFileReader::read_chunks(
     std::size_t chunk_size,
     std::stop_token stop_token,
     const std::function<core::Expected<void, core::Error>(const std::string&)>& on_chunk) const {
+    if (policy_ != core::CachePolicy::Normal) {
+        auto file = RawFile::open(path, policy_);
+        if (!file) return file.error();
+        std::size_t capacity = chunk_size;
+        const auto buf = make_aligned(capacity);
+        while (!stop_token.stop_requested()) {
+            auto got = fill(file.value(), buf.get(), capacity);
+            if (!got) return got.error();
+            if (got.value() == 0) break;
+            auto result = on_chunk(std::string(reinterpret_cast<const char*>(buf.get()), got.value()));
+            if (!result) return result.error();
+            if (got.value() < capacity) break;
+        }
+        return {};
+    }
     std::ifstream input(path, std::ios::binary);
     if (!input) {
         return core::Error{"unable to open file"};
@@ -49,4 +108,26 @@ core::Expected<void, core::Error> StdFileReader::read_chunks(
     return {};
 }
 
+// One open, an fstat for the size and the reads: no stream object, and no extra
+// read past the end unless the file fills the buffer. A larger file is not read;
+// its size is returned instead.
+core::Expected<std::size_t, core::Error> StdFileReader::read_into(const std::string& path, std::span<std::byte> buffer) const {
+    auto file = RawFile::open(path, policy_);
+    if (!file) return file.error();
+    if (file.value().size() > buffer.size()) {
+        return static_cast<std::size_t>(std::min<std::uint64_t>(file.value().size(), std::numeric_limits<std::size_t>::max()));
+    }
+    auto length = fill(file.value(), buffer.data(), buffer.size());
+    if (!length || length.value() < buffer.size()) return length;
+    // The file may have grown since the fstat; one more byte tells.
+    std::byte probe{};
+    auto more = file.value().read(&probe, 1);
+    if (!more) return more.error();
+    return more.value() > 0 ? buffer.size() + 1 : buffer.size();
+}
+
+void StdFileReader::prefetch(const std::string& path) const {
+    if (policy_ == core::CachePolicy::Normal) advise_will_need(path);
+}
+
 } // namespace zenith::platform
@@ -4,13 +4,23 @@
 
 namespace zenith::platform {
 
+// Reads through std::ifstream, or through RawFile when a cache policy other than
+// Normal asks to keep the page cache out of it.
 class StdFileReader final : public core::IFileReader {
 public:
+    explicit StdFileReader(core::CachePolicy policy = core::CachePolicy::Normal) : policy_(policy) {}
+
     core::Expected<std::string, core::Error> read_prefix(const std::string& path, std::size_t max_bytes) const override;
     core::Expected<void, core::Error> read_chunks(const std::string& path,
                                                   std::size_t chunk_size,
                                                   std::stop_token stop_token,
                                                   const std::function<core::Expected<void, core::Error>(const std::string&)>& on_chunk) const override;
+    core::Expected<std::size_t, core::Error> read_into(const std::string& path, std::span<std::byte> buffer) const override;
+    // A read-ahead hint only under Normal: the other policies keep files out of the cache.
+    void prefetch(const std::string& path) const override;
+
+private:
+    core::CachePolicy policy_;
 };
 
 } // namespace zenith::platform
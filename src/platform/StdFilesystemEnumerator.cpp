@@ -1,11 +1,10 @@
 #include "StdFilesystemEnumerator.hpp"
 
+#include "EntryFilter.hpp"
+#include "FileId.hpp"
 #include "Glob.hpp"
 
-#include <algorithm>
-#include <cctype>
 #include <filesystem>
-#include <fstream>
 #include <set>
 #include <unordered_map>
 
@@ -14,68 +13,16 @@ namespace fs = std::filesystem;
 
 namespace {
 
-bool is_hidden_path(const fs::path& path) {
-    const auto filename = path.filename().string();
-    return !filename.empty() && filename[0] == '.';
-}
-
-std::string normalize_extension(const fs::path& path) {
-    std::string ext = path.extension().string();
-    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    return ext;
-}
-
 std::string normalize_path(const fs::path& path) { return normalize_for_match(path.lexically_normal().generic_string()); }
 
-bool basename_match(const std::string& name, const std::vector<std::string>& patterns) {
-#ifdef _WIN32
-    std::string lowered = name;
-    std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    for (auto p : patterns) {
-        std::transform(p.begin(), p.end(), p.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        if (p == lowered) {
-            return true;
-        }
-    }
-    return false;
-#else
-    return std::find(patterns.begin(), patterns.end(), name) != patterns.end();
-#endif
-}
-
-std::vector<std::string> load_ignore_patterns(const fs::path& dir) {
-    std::vector<std::string> patterns;
-    const auto ignore_file = dir / ".zenithignore";
-    std::ifstream in(ignore_file);
-    if (!in) {
-        return patterns;
-    }
-    std::string line;
-    while (std::getline(in, line)) {
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        patterns.push_back(normalize_for_match((dir / line).lexically_normal().generic_string()));
-    }
-    return patterns;
-}
-
-bool match_any(const std::vector<std::string>& globs, const std::string& normalized) {
-    for (const auto& g : globs) {
-        if (glob_match(g, normalized)) {
-            return true;
-        }
-    }
-    return false;
-}
-
 } // namespace
 
-std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::SearchRequest& request,
-                                                                std::stop_token stop_token,
-                                                                const ErrorCallback& on_error) const {
-    std::vector<core::FileItem> results;
+core::FileList StdFilesystemEnumerator::enumerate(const core::SearchRequest& request,
+                                                  std::stop_token stop_token,
+                                                  const ErrorCallback& on_error) const {
+    core::FileList results;
     std::set<std::string> visited_dirs;
+    const EntryFilter filter(request);
 
     for (const auto& raw_path : request.input_paths) {
         if (stop_token.stop_requested()) {
@@ -91,32 +38,7 @@ std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::Searc
         }
 
         auto should_include_file = [&](const fs::path& file, std::uintmax_t size) {
-            const auto normalized = normalize_path(file);
-            if (request.ignore_hidden && is_hidden_path(file)) {
-                return false;
-            }
-            if (!request.exclude_dirs.empty()) {
-                const auto base = file.parent_path().filename().string();
-                if (basename_match(base, request.exclude_dirs)) {
-                    return false;
-                }
-            }
-            if (!request.exclude_globs.empty() && match_any(request.exclude_globs, normalized)) {
-                return false;
-            }
-            if (!request.extensions.empty()) {
-                const auto ext = normalize_extension(file);
-                if (request.extensions.find(ext) == request.extensions.end()) {
-                    return false;
-                }
-            }
-            if (!request.include_globs.empty() && !match_any(request.include_globs, normalized)) {
-                return false;
-            }
-            if (request.max_bytes.has_value() && size > *request.max_bytes) {
-                return false;
-            }
-            return true;
+            return filter.include_file(file.filename().string(), file.parent_path().filename().string(), normalize_path(file), size);
         };
 
         if (fs::is_regular_file(status)) {
@@ -131,7 +53,8 @@ std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::Searc
                 continue;
             }
             if (should_include_file(root, size)) {
-                results.push_back({root.string(), normalized, size});
+                const auto file_id = request.dedup_files ? query_file_id(root).value_or(core::FileId{}) : core::FileId{};
+                results.files.push_back({results.paths.add_root(root.string(), normalized), size, file_id});
             }
             continue;
         }
@@ -153,6 +76,8 @@ std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::Searc
             on_error({root.string() + ": " + ec.message()});
             continue;
         }
+        // dirs[d] is the interned directory holding entries at depth d.
+        std::vector<core::PathId> dirs{results.paths.add_root(root.string(), normalize_path(root))};
 
         while (it != end) {
             if (stop_token.stop_requested()) {
@@ -162,6 +87,8 @@ std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::Searc
             const auto entry = *it;
             const auto current = entry.path();
             const auto current_norm = normalize_path(current);
+            const auto depth = static_cast<std::size_t>(it.depth());
+            dirs.resize(depth + 1);
 
             std::error_code link_ec;
             if (entry.is_directory(link_ec)) {
@@ -171,17 +98,7 @@ std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::Searc
                     continue;
                 }
 
-                if (request.ignore_hidden && is_hidden_path(current)) {
-                    it.disable_recursion_pending();
-                    ++it;
-                    continue;
-                }
-                if (!request.exclude_dirs.empty() && basename_match(current.filename().string(), request.exclude_dirs)) {
-                    it.disable_recursion_pending();
-                    ++it;
-                    continue;
-                }
-                if (!request.exclude_globs.empty() && match_any(request.exclude_globs, current_norm + "/x")) {
+                if (filter.prune_dir(current.filename().string(), current_norm)) {
                     it.disable_recursion_pending();
                     ++it;
                     continue;
@@ -222,6 +139,7 @@ std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::Searc
                     }
                 }
 
+                dirs.push_back(results.paths.add_child(dirs[depth], current.filename().string()));
                 ++it;
                 continue;
             }
@@ -266,12 +184,15 @@ std::vector<core::FileItem> StdFilesystemEnumerator::enumerate(const core::Searc
             }
 
             if (!ignored && should_include_file(current, size)) {
-                results.push_back({current.string(), current_norm, size});
+                const auto file_id = request.dedup_files ? query_file_id(current).value_or(core::FileId{}) : core::FileId{};
+                results.files.push_back({results.paths.add_child(dirs[depth], current.filename().string()), size, file_id});
             }
             ++it;
         }
     }
 
+    results.paths.shrink_to_fit();
+    results.files.shrink_to_fit();
     return results;
 }
 
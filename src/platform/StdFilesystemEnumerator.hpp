@@ -6,9 +6,7 @@ namespace zenith::platform {
 
 class StdFilesystemEnumerator final : public core::IFileEnumerator {
 public:
-    std::vector<core::FileItem> enumerate(const core::SearchRequest& request,
-                                          std::stop_token stop_token,
-                                          const ErrorCallback& on_error) const override;
+    core::FileList enumerate(const core::SearchRequest& request, std::stop_token stop_token, const ErrorCallback& on_error) const override;
 };
 
 } // namespace zenith::platform
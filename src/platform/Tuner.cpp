@@ -0,0 +1,244 @@
+#include "Tuner.hpp"
+
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/RareByteSearchAlgorithm.hpp"
+#include "core/ShortPatternSearchAlgorithm.hpp"
+#include "core/TuningProfile.hpp"
+#include "core/TwoWaySearchAlgorithm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace zenith::platform {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Candidate {
+    core::AlgorithmMode mode;
+    const core::ISearchAlgorithm* algorithm;
+};
+
+// Log-like text, the common case, with an occasional rare token.
+std::string make_text_corpus(std::size_t bytes) {
+    static const char* words[] = {"INFO", "request", "handled", "in", "ms", "user=", "id", "_ERROR", "E", "the", "and",
+                                  "status=200", "GET", "/api/v1/items", "latency", "cache", "miss", "hit", "worker"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> pick(0, std::size(words) - 1);
+    std::uniform_int_distribution<int> rare(0, 999);
+    std::string out;
+    out.reserve(bytes + 64);
+    while (out.size() < bytes) {
+        if (rare(rng) == 0) out += "E4711XQZ_TIMEOUT_CODE ";
+        out += words[pick(rng)];
+        out.push_back(rare(rng) < 60 ? '\n' : ' ');
+    }
+    out.resize(bytes);
+    return out;
+}
+
+template <typename Fn>
+double best_seconds(int reps, Fn&& fn) {
+    double best = 1e30;
+    for (int rep = 0; rep < reps; ++rep) {
+        const auto t0 = Clock::now();
+        fn();
+        const std::chrono::duration<double> dt = Clock::now() - t0;
+        best = std::min(best, dt.count());
+    }
+    return best;
+}
+
+// Text patterns are cut from the corpus so they hit both common and rare bytes;
+// the run-of-one-byte case keeps kernels with a quadratic worst case from winning.
+double time_kernel(const core::ISearchAlgorithm& algo, const std::string& text, const std::string& runs, std::size_t len) {
+    double total = 0;
+    for (const std::size_t offset : {std::size_t{0}, text.size() / 3, text.size() / 2 + 7}) {
+        const std::string pattern = text.substr(offset, len);
+        total += best_seconds(2, [&] { (void)algo.find_all(text, pattern); });
+    }
+    std::string adversarial(len, 'a');
+    adversarial.front() = 'b';
+    total += best_seconds(2, [&] { (void)algo.find_all(runs, adversarial); });
+    return total;
+}
+
+core::Expected<void, core::Error> write_file(const std::filesystem::path& path, std::string_view data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out) return core::Error{"unable to write scratch file: " + path.string()};
+    return {};
+}
+
+// Removes the scratch files however the tuner exits.
+struct ScratchFiles {
+    std::vector<std::filesystem::path> paths;
+    ~ScratchFiles() {
+        std::error_code ec;
+        for (const auto& p : paths) std::filesystem::remove(p, ec);
+    }
+};
+
+} // namespace
+
+core::Expected<core::TuningProfile, core::Error> Tuner::run(const TunerOptions& options, std::ostream& log) const {
+    const core::BmhSearchAlgorithm bmh;
+    const core::BoyerMooreSearchAlgorithm boyer_moore;
+    const core::ShortPatternSearchAlgorithm short_kernels;
+    const core::TwoWaySearchAlgorithm two_way;
+    const core::RareByteSearchAlgorithm rare_byte;
+    const std::vector<Candidate> long_candidates = {{core::AlgorithmMode::RareByte, &rare_byte},
+                                                    {core::AlgorithmMode::TwoWay, &two_way},
+                                                    {core::AlgorithmMode::Bmh, &bmh},
+                                                    {core::AlgorithmMode::BoyerMoore, &boyer_moore}};
+    auto short_candidates = long_candidates;
+    short_candidates.insert(short_candidates.begin(), {core::AlgorithmMode::Short, &short_kernels});
+
+    const auto text = make_text_corpus(options.corpus_bytes);
+    const std::string runs(options.corpus_bytes / 4, 'a');
+    core::TuningProfile profile;
+
+    // Kernels: every length the short kernels specialize, then one probe per longer
+    // range, recorded at the range's lower bound so Auto's table lookup covers it.
+    std::vector<std::pair<std::size_t, std::size_t>> probes; // (table index, probe length)
+    for (std::size_t len = 1; len <= core::ShortPatternSearchAlgorithm::kMaxPatternLength; ++len) probes.emplace_back(len, len);
+    probes.emplace_back(17, 24);
+    probes.emplace_back(33, 48);
+    probes.emplace_back(65, 128);
+    profile.auto_algorithm_by_length.assign(probes.back().first + 1, core::AlgorithmMode::Auto);
+    for (const auto& [index, len] : probes) {
+        const auto& candidates = len <= core::ShortPatternSearchAlgorithm::kMaxPatternLength ? short_candidates : long_candidates;
+        const Candidate* best = nullptr;
+        double best_time = 0;
+        for (const auto& c : candidates) {
+            const double t = time_kernel(*c.algorithm, text, runs, len);
+            if (best == nullptr || t < best_time) {
+                best = &c;
+                best_time = t;
+            }
+        }
+        profile.auto_algorithm_by_length[index] = best->mode;
+        log << "algo." << index << " (" << len << " bytes): " << core::algorithm_mode_name(best->mode) << '\n';
+    }
+
+    // I/O: whole-file mmap vs streamed reads of hot files, each scanned once.
+    std::error_code ec;
+    const auto dir = options.scratch_dir.empty() ? std::filesystem::temp_directory_path(ec) : options.scratch_dir;
+    if (ec) return core::Error{"unable to locate a temp directory: " + ec.message()};
+    ScratchFiles scratch;
+    const std::string pattern = "E4711XQZ_TIMEOUT_CODE";
+    const std::size_t default_chunk = core::SearchRequest{}.chunk_size;
+    std::string big;
+    while (big.size() < 8U * 1024U * 1024U) big += text;
+
+    const std::size_t sizes[] = {4U * 1024U, 16U * 1024U, 64U * 1024U, 256U * 1024U, 1024U * 1024U, 4U * 1024U * 1024U};
+    std::vector<bool> mmap_wins;
+    for (const auto size : sizes) {
+        const auto path = dir / ("zenithsearch-tune-" + std::to_string(size) + ".tmp");
+        scratch.paths.push_back(path);
+        if (auto w = write_file(path, std::string_view(big).substr(0, size)); !w) return w.error();
+        const std::string p = path.string();
+        const int reps = static_cast<int>(std::clamp<std::size_t>(big.size() / size, 4, 256));
+
+        bool failed = false;
+        const double mapped_time = best_seconds(3, [&] {
+            for (int i = 0; i < reps; ++i) {
+                auto m = mapped_.open(p);
+                if (!m) {
+                    failed = true;
+                    return;
+                }
+                const auto bytes = m.value()->bytes();
+                (void)rare_byte.find_all(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()), pattern);
+            }
+        });
+        const double stream_time = best_seconds(3, [&] {
+            for (int i = 0; i < reps; ++i) {
+                auto r = reader_.read_chunks(p, default_chunk, {}, [&](const std::string& chunk) -> core::Expected<void, core::Error> {
+                    (void)rare_byte.find_all(chunk, pattern);
+                    return {};
+                });
+                if (!r) failed = true;
+            }
+        });
+        if (failed) return core::Error{"unable to read scratch file: " + p};
+        mmap_wins.push_back(mapped_time < stream_time);
+        log << "file " << size << " bytes: mmap " << mapped_time * 1e6 / reps << " us, stream " << stream_time * 1e6 / reps << " us\n";
+    }
+    // Smallest size from which mmap wins at every larger size too; if it never does,
+    // only files beyond the largest probe are mapped.
+    std::size_t threshold = sizes[std::size(sizes) - 1] * 4;
+    for (std::size_t i = std::size(sizes); i > 0 && mmap_wins[i - 1]; --i) threshold = sizes[i - 1];
+    profile.mmap_threshold_bytes = threshold;
+    log << "mmap_threshold_bytes=" << threshold << '\n';
+
+    const auto big_path = dir / "zenithsearch-tune-chunks.tmp";
+    scratch.paths.push_back(big_path);
+    if (auto w = write_file(big_path, big); !w) return w.error();
+    std::size_t best_chunk = default_chunk;
+    double best_chunk_time = 0;
+    for (const std::size_t chunk : {64U * 1024U, 256U * 1024U, 1024U * 1024U, 4U * 1024U * 1024U}) {
+        bool failed = false;
+        const double t = best_seconds(3, [&] {
+            auto r = reader_.read_chunks(big_path.string(), chunk, {}, [&](const std::string& c) -> core::Expected<void, core::Error> {
+                (void)rare_byte.find_all(c, pattern);
+                return {};
+            });
+            if (!r) failed = true;
+        });
+        if (failed) return core::Error{"unable to read scratch file: " + big_path.string()};
+        if (best_chunk_time == 0 || t < best_chunk_time) {
+            best_chunk = chunk;
+            best_chunk_time = t;
+        }
+    }
+    profile.chunk_size = best_chunk;
+    log << "chunk_size=" << best_chunk << '\n';
+    return profile;
+}
+
+std::filesystem::path default_profile_path() {
+    if (const char* env = std::getenv("ZENITHSEARCH_PROFILE"); env != nullptr && *env != '\0') return env;
+#ifdef _WIN32
+    if (const char* appdata = std::getenv("APPDATA"); appdata != nullptr && *appdata != '\0') {
+        return std::filesystem::path(appdata) / "zenithsearch" / "profile";
+    }
+#else
+    if (const char* xdg = std::getenv("XDG_CONFIG_HOME"); xdg != nullptr && *xdg != '\0') {
+        return std::filesystem::path(xdg) / "zenithsearch" / "profile";
+    }
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+        return std::filesystem::path(home) / ".config" / "zenithsearch" / "profile";
+    }
+#endif
+    return {};
+}
+
+core::Expected<core::TuningProfile, core::Error> load_tuning_profile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return core::Error{"unable to open profile: " + path.string()};
+    auto profile = core::parse_tuning_profile(in);
+    if (!profile) return core::Error{path.string() + ": " + profile.error().message};
+    return profile;
+}
+
+core::Expected<void, core::Error> save_tuning_profile(const core::TuningProfile& profile, const std::filesystem::path& path) {
+    std::error_code ec;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec) return core::Error{"unable to create " + path.parent_path().string() + ": " + ec.message()};
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return core::Error{"unable to write profile: " + path.string()};
+    core::write_tuning_profile(profile, out);
+    out.flush();
+    if (!out) return core::Error{"unable to write profile: " + path.string()};
+    return {};
+}
+
+} // namespace zenith::platform
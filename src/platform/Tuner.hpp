@@ -0,0 +1,38 @@
+#pragma once
+
+#include "core/Expected.hpp"
+#include "core/Interfaces.hpp"
+#include "core/Types.hpp"
+
+#include <filesystem>
+#include <iosfwd>
+
+namespace zenith::platform {
+
+struct TunerOptions {
+    std::size_t corpus_bytes{2U * 1024U * 1024U};
+    std::filesystem::path scratch_dir; // empty = system temp directory
+};
+
+// Backs `zenithsearch tune`: times every literal kernel across pattern lengths and
+// mmap vs streamed reads across file sizes on this machine, then returns the profile
+// Auto mode should use. Scratch files are written to the page cache and removed.
+class Tuner {
+public:
+    Tuner(const core::IFileReader& reader, const core::IMappedFileProvider& mapped) : reader_(reader), mapped_(mapped) {}
+
+    core::Expected<core::TuningProfile, core::Error> run(const TunerOptions& options, std::ostream& log) const;
+
+private:
+    const core::IFileReader& reader_;
+    const core::IMappedFileProvider& mapped_;
+};
+
+// $ZENITHSEARCH_PROFILE, else <config dir>/zenithsearch/profile (XDG_CONFIG_HOME,
+// ~/.config, or %APPDATA% on Windows). Empty when no location can be determined.
+std::filesystem::path default_profile_path();
+
+core::Expected<core::TuningProfile, core::Error> load_tuning_profile(const std::filesystem::path& path);
+core::Expected<void, core::Error> save_tuning_profile(const core::TuningProfile& profile, const std::filesystem::path& path);
+
+} // namespace zenith::platform
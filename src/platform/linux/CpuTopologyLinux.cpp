@@ -0,0 +1,69 @@
+#include "platform/CpuTopology.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace zenith::platform {
+namespace {
+
+// Parses a sysfs CPU list such as "0-3,8-11".
+std::vector<unsigned> parse_cpu_list(const std::string& text) {
+    std::vector<unsigned> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        const auto dash = range.find('-');
+        try {
+            const unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            const unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+            for (unsigned c = first; c <= last; ++c) cpus.push_back(c);
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+} // namespace
+
+CpuTopology::CpuTopology() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::map<unsigned, std::vector<unsigned>> by_id;
+    for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+        const auto name = entry.path().filename().string();
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        std::ifstream in(entry.path() / "cpulist");
+        std::string line;
+        std::getline(in, line);
+        auto cpus = parse_cpu_list(line);
+        if (!cpus.empty()) by_id[static_cast<unsigned>(std::stoul(name.substr(4)))] = std::move(cpus);
+    }
+    for (auto& [id, cpus] : by_id) nodes_.push_back({0, std::move(cpus)});
+}
+
+bool CpuTopology::pin_current_thread(std::size_t node) const {
+    if (node >= nodes_.size()) return false;
+    const auto& cpus = nodes_[node].cpus;
+    const unsigned max_cpu = *std::max_element(cpus.begin(), cpus.end());
+    cpu_set_t* set = CPU_ALLOC(max_cpu + 1);
+    if (set == nullptr) return false;
+    const std::size_t bytes = CPU_ALLOC_SIZE(max_cpu + 1);
+    CPU_ZERO_S(bytes, set);
+    for (const auto c : cpus) CPU_SET_S(c, bytes, set);
+    const bool ok = pthread_setaffinity_np(pthread_self(), bytes, set) == 0;
+    CPU_FREE(set);
+    return ok;
+}
+
+} // namespace zenith::platform
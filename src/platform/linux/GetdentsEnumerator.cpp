@@ -0,0 +1,284 @@
+#include "platform/GetdentsEnumerator.hpp"
+
+#include "platform/EntryFilter.hpp"
+#include "platform/Glob.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <set>
+
+namespace zenith::platform {
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string normalize_path(const fs::path& path) { return normalize_for_match(path.lexically_normal().generic_string()); }
+
+// Same text as normalize_path(parent / name) for a lexically normal parent.
+std::string join_normalized(const std::string& parent, std::string_view name) {
+    std::string out;
+    if (parent != ".") {
+        out.reserve(parent.size() + name.size() + 1);
+        out = parent;
+        if (!out.empty() && out.back() != '/') out.push_back('/');
+    }
+    const auto start = out.size();
+    out += name;
+    for (auto i = start; i < out.size(); ++i) {
+        if (out[i] == '\\') out[i] = '/';
+    }
+    return out;
+}
+
+class Fd {
+public:
+    explicit Fd(int fd) : fd_(fd) {}
+    Fd(const Fd&) = delete;
+    Fd& operator=(const Fd&) = delete;
+    ~Fd() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+    int get() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+// One directory listing: entry names packed in a single buffer.
+struct Listing {
+    struct Entry {
+        std::uint32_t name_offset;
+        std::uint32_t name_length;
+        std::uint64_t ino;
+        unsigned char type;
+    };
+    std::vector<Entry> entries;
+    std::string names;
+    bool has_ignore_file{false};
+
+    std::string_view name(const Entry& e) const { return {names.data() + e.name_offset, e.name_length}; }
+};
+
+class Walker {
+public:
+    Walker(const core::SearchRequest& request, const EntryFilter& filter, core::FileList& results, std::stop_token stop_token,
+           const core::IFileEnumerator::ErrorCallback& on_error)
+        : request_(request), filter_(filter), results_(results), stop_token_(stop_token), on_error_(on_error), buffer_(64U * 1024U) {}
+
+    void walk_root(const fs::path& root, int fd) {
+        const auto id = results_.paths.add_root(root.string(), normalize_path(root));
+        walk(fd, id, normalize_path(root), (root / "x").parent_path().filename().string(), true);
+    }
+
+private:
+    bool follow() const { return request_.follow_symlinks == core::FollowSymlinksMode::On; }
+
+    void report(core::PathId dir, std::string_view name, int err) {
+        auto path = results_.paths.path(dir);
+        if (!name.empty()) path = (fs::path(path) / fs::path(name)).string();
+        on_error_({path + ": " + std::strerror(err)});
+    }
+
+    bool list(int fd, Listing& out) {
+        for (;;) {
+            const auto n = ::syscall(SYS_getdents64, fd, buffer_.data(), buffer_.size());
+            if (n < 0) return false;
+            if (n == 0) return true;
+            // struct linux_dirent64: u64 d_ino, s64 d_off, u16 d_reclen, u8 d_type, char d_name[].
+            for (long pos = 0; pos < n;) {
+                const char* rec = buffer_.data() + pos;
+                std::uint64_t ino = 0;
+                std::uint16_t reclen = 0;
+                std::memcpy(&ino, rec, sizeof(ino));
+                std::memcpy(&reclen, rec + 16, sizeof(reclen));
+                const auto type = static_cast<unsigned char>(rec[18]);
+                const std::string_view name(rec + 19);
+                pos += reclen;
+                if (name == "." || name == "..") continue;
+                if (name == ".zenithignore") out.has_ignore_file = true;
+                out.entries.push_back({static_cast<std::uint32_t>(out.names.size()), static_cast<std::uint32_t>(name.size()), ino, type});
+                out.names += name;
+            }
+        }
+    }
+
+    bool ignored_by_ancestors(const std::string& normalized) const {
+        for (auto it = ignore_stack_.rbegin(); it != ignore_stack_.rend(); ++it) {
+            for (const auto& p : **it) {
+                if (glob_match(p, normalized)) return true;
+            }
+        }
+        return false;
+    }
+
+    // `name` is what --exclude-dir sees as the parent of this directory's files.
+    void walk(int fd, core::PathId id, const std::string& normalized, const std::string& name, bool is_root) {
+        Listing listing;
+        if (!list(fd, listing)) {
+            report(id, {}, errno);
+            return;
+        }
+
+        std::vector<std::string> own_patterns;
+        if (!request_.no_ignore && listing.has_ignore_file) own_patterns = load_ignore_patterns(results_.paths.path(id));
+        if (!is_root) {
+            for (const auto& p : own_patterns) {
+                if (glob_match(p, normalized) || glob_match(p + "/**", normalized)) return;
+            }
+        }
+
+        struct stat dir_st {};
+        if ((request_.dedup_files || follow()) && ::fstat(fd, &dir_st) != 0) {
+            report(id, {}, errno);
+            return;
+        }
+        if (follow() && !visited_.insert({static_cast<std::uint64_t>(dir_st.st_dev), static_cast<std::uint64_t>(dir_st.st_ino)}).second) return;
+
+        ignore_stack_.push_back(&own_patterns);
+        for (const auto& entry : listing.entries) {
+            if (stop_token_.stop_requested()) break;
+            visit(fd, id, normalized, name, dir_st, listing.name(entry), entry);
+        }
+        ignore_stack_.pop_back();
+    }
+
+    void visit(int fd, core::PathId dir, const std::string& dir_normalized, const std::string& dir_name, const struct stat& dir_st,
+               std::string_view name, const Listing::Entry& entry) {
+        const std::string name_str(name);
+        unsigned char type = entry.type;
+        struct stat st {};
+        bool have_stat = false;
+        if (type == DT_UNKNOWN) {
+            if (::fstatat(fd, name_str.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                report(dir, name, errno);
+                return;
+            }
+            have_stat = true;
+            type = S_ISLNK(st.st_mode) ? DT_LNK : S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+        if (type == DT_LNK) {
+            // Links are classified by their target, like directory_entry::is_directory();
+            // a dangling link is reported and skipped.
+            if (::fstatat(fd, name_str.c_str(), &st, 0) != 0) {
+                report(dir, name, errno);
+                return;
+            }
+            have_stat = true;
+            if (S_ISDIR(st.st_mode) && !follow()) return;
+            type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+
+        const bool need_normalized = filter_.needs_normalized();
+        if (type == DT_DIR) {
+            const auto normalized = need_normalized ? join_normalized(dir_normalized, name) : std::string{};
+            if (filter_.prune_dir(name, normalized)) return;
+            const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (follow() ? 0 : O_NOFOLLOW);
+            Fd child(::openat(fd, name_str.c_str(), flags));
+            if (child.get() < 0) {
+                if (errno != EACCES && errno != EPERM) report(dir, name, errno);
+                return;
+            }
+            walk(child.get(), results_.paths.add_child(dir, name), normalized, name_str, false);
+            return;
+        }
+        if (type != DT_REG) return;
+
+        std::uintmax_t size = core::FileItem::kUnknownSize;
+        if (have_stat) {
+            size = static_cast<std::uintmax_t>(st.st_size);
+        } else if (filter_.needs_size()) {
+            struct statx stx {};
+            if (::statx(fd, name_str.c_str(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STATX_SIZE, &stx) != 0) {
+                report(dir, name, errno);
+                return;
+            }
+            size = stx.stx_size;
+        }
+
+        const auto normalized = need_normalized ? join_normalized(dir_normalized, name) : std::string{};
+        if (!request_.no_ignore && ignored_by_ancestors(normalized)) return;
+        if (!filter_.include_file(name, dir_name, normalized, size)) return;
+
+        core::FileId file_id{};
+        if (request_.dedup_files) {
+            file_id = have_stat ? core::FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)}
+                                : core::FileId{static_cast<std::uint64_t>(dir_st.st_dev), entry.ino};
+        }
+        results_.files.push_back({results_.paths.add_child(dir, name), size, file_id});
+    }
+
+    const core::SearchRequest& request_;
+    const EntryFilter& filter_;
+    core::FileList& results_;
+    std::stop_token stop_token_;
+    const core::IFileEnumerator::ErrorCallback& on_error_;
+    std::vector<char> buffer_;
+    std::vector<const std::vector<std::string>*> ignore_stack_;
+    std::set<core::FileId> visited_;
+};
+
+} // namespace
+
+core::FileList GetdentsEnumerator::enumerate(const core::SearchRequest& request, std::stop_token stop_token, const ErrorCallback& on_error) const {
+    core::FileList results;
+    const EntryFilter filter(request);
+    Walker walker(request, filter, results, stop_token, on_error);
+
+    for (const auto& raw_path : request.input_paths) {
+        if (stop_token.stop_requested()) {
+            break;
+        }
+
+        const fs::path root(raw_path);
+        std::error_code ec;
+        const auto status = request.follow_symlinks == core::FollowSymlinksMode::On ? fs::status(root, ec) : fs::symlink_status(root, ec);
+        if (ec) {
+            on_error({root.string() + ": " + ec.message()});
+            continue;
+        }
+
+        if (fs::is_regular_file(status)) {
+            const auto normalized = normalize_path(root);
+            if (!request.exclude_globs.empty() && match_any(request.exclude_globs, normalized)) {
+                continue;
+            }
+            struct stat st {};
+            if (::stat(root.c_str(), &st) != 0) {
+                on_error({root.string() + ": " + std::strerror(errno)});
+                continue;
+            }
+            const auto size = static_cast<std::uintmax_t>(st.st_size);
+            if (filter.include_file(root.filename().string(), root.parent_path().filename().string(), normalized, size)) {
+                const auto file_id = request.dedup_files ? core::FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)}
+                                                         : core::FileId{};
+                results.files.push_back({results.paths.add_root(root.string(), normalized), size, file_id});
+            }
+            continue;
+        }
+
+        if (!fs::is_directory(status)) {
+            on_error({root.string() + ": unsupported path type"});
+            continue;
+        }
+
+        Fd fd(::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (fd.get() < 0) {
+            on_error({root.string() + ": " + std::strerror(errno)});
+            continue;
+        }
+        walker.walk_root(root, fd.get());
+    }
+
+    results.paths.shrink_to_fit();
+    results.files.shrink_to_fit();
+    return results;
+}
+
+} // namespace zenith::platform
@@ -0,0 +1,13 @@
+#if !defined(_WIN32) && !defined(__linux__)
+
+#include "platform/CpuTopology.hpp"
+
+namespace zenith::platform {
+
+CpuTopology::CpuTopology() = default;
+
+bool CpuTopology::pin_current_thread(std::size_t /*node*/) const { return false; }
+
+} // namespace zenith::platform
+
+#endif
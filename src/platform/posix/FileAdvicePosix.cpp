@@ -0,0 +1,31 @@
+#ifndef _WIN32
+
+#include "platform/FileAdvice.hpp"
+
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace zenith::platform {
+
+void advise_will_need(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+#ifdef __APPLE__
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        radvisory advice{};
+        advice.ra_offset = 0;
+        advice.ra_count = st.st_size > INT_MAX ? INT_MAX : static_cast<int>(st.st_size);
+        ::fcntl(fd, F_RDADVISE, &advice);
+    }
+#else
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    ::close(fd);
+}
+
+} // namespace zenith::platform
+
+#endif
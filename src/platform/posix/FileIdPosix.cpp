@@ -0,0 +1,37 @@
+#ifndef _WIN32
+
+#include "platform/FileId.hpp"
+
+#include <sys/stat.h>
+#include <time.h>
+
+namespace zenith::platform {
+
+std::optional<core::FileId> query_file_id(const std::filesystem::path& path) {
+    struct stat st {};
+    if (::stat(path.c_str(), &st) != 0) return std::nullopt;
+    return core::FileId{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)};
+}
+
+std::optional<core::FileStamp> query_file_stamp(const std::filesystem::path& path) {
+    struct stat st {};
+    if (::stat(path.c_str(), &st) != 0) return std::nullopt;
+#ifdef __APPLE__
+    const auto& mtime = st.st_mtimespec;
+#else
+    const auto& mtime = st.st_mtim;
+#endif
+    return core::FileStamp{{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)},
+                           static_cast<std::uintmax_t>(st.st_size),
+                           static_cast<std::int64_t>(mtime.tv_sec) * 1000000000 + static_cast<std::int64_t>(mtime.tv_nsec)};
+}
+
+std::int64_t file_stamp_now_ns() {
+    struct timespec now {};
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + static_cast<std::int64_t>(now.tv_nsec);
+}
+
+} // namespace zenith::platform
+
+#endif
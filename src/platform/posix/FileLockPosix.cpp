@@ -0,0 +1,47 @@
+#ifndef _WIN32
+
+#include "platform/FileLock.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <utility>
+
+namespace zenith::platform {
+
+core::Expected<FileLock, core::Error> FileLock::acquire(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return core::Error{"cannot open lock file " + path.string() + ": " + std::strerror(errno)};
+    while (::flock(fd, LOCK_EX) != 0) {
+        if (errno == EINTR) continue;
+        const int err = errno;
+        ::close(fd);
+        return core::Error{"cannot lock " + path.string() + ": " + std::strerror(err)};
+    }
+    return FileLock(fd);
+}
+
+FileLock::FileLock(FileLock&& other) noexcept : handle_(std::exchange(other.handle_, -1)) {}
+
+FileLock& FileLock::operator=(FileLock&& other) noexcept {
+    if (this != &other) {
+        release();
+        handle_ = std::exchange(other.handle_, -1);
+    }
+    return *this;
+}
+
+FileLock::~FileLock() { release(); }
+
+void FileLock::release() {
+    if (handle_ < 0) return;
+    ::flock(handle_, LOCK_UN);
+    ::close(handle_);
+    handle_ = -1;
+}
+
+} // namespace zenith::platform
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "platform/MappedFileProvider.hpp"
 
+#include <algorithm>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -12,14 +13,17 @@ namespace {
 
 class PosixMappedFile final : public core::IMappedFile {
 public:
-    PosixMappedFile(std::string p, int fd, std::byte* data, std::size_t size)
-        : path_(std::move(p)), fd_(fd), data_(data), size_(size) {}
+    PosixMappedFile(std::string p, int fd, std::byte* data, std::size_t size, bool drop)
+        : path_(std::move(p)), fd_(fd), data_(data), size_(size), drop_(drop) {}
 
     ~PosixMappedFile() override {
         if (data_ != nullptr && size_ > 0) {
             munmap(data_, size_);
         }
         if (fd_ >= 0) {
+#ifdef POSIX_FADV_DONTNEED
+            if (drop_) ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
             close(fd_);
         }
     }
@@ -33,12 +37,69 @@ private:
     int fd_;
     std::byte* data_;
     std::size_t size_;
+    bool drop_;
+};
+
+// Maps one window at a time. mmap offsets must be page aligned, so a window
+// starts on the page holding its first byte.
+class PosixWindowedFile final : public core::IMappedFile {
+public:
+    PosixWindowedFile(std::string p, int fd, std::uint64_t size, bool drop)
+        : path_(std::move(p)), fd_(fd), size_(size), drop_(drop) {}
+
+    ~PosixWindowedFile() override {
+        unmap();
+        close(fd_);
+    }
+
+    std::span<const std::byte> bytes() const override { return view_; }
+    std::uint64_t size() const override { return size_; }
+    const std::string& path() const override { return path_; }
+
+    core::Expected<std::span<const std::byte>, core::Error> map_window(std::uint64_t offset, std::size_t length) override {
+        unmap();
+        if (offset >= size_ || length == 0) return view_;
+        length = static_cast<std::size_t>(std::min<std::uint64_t>(length, size_ - offset));
+        static const auto page = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+        const std::uint64_t start = offset - offset % page;
+        const auto lead = static_cast<std::size_t>(offset - start);
+        void* mapped = mmap(nullptr, lead + length, PROT_READ, MAP_PRIVATE, fd_, static_cast<off_t>(start));
+        if (mapped == MAP_FAILED) {
+            return core::Error{"mmap failed"};
+        }
+        madvise(mapped, lead + length, MADV_SEQUENTIAL);
+        base_ = static_cast<std::byte*>(mapped);
+        base_offset_ = start;
+        mapped_ = lead + length;
+        view_ = {base_ + lead, length};
+        return view_;
+    }
+
+private:
+    void unmap() {
+        if (base_ == nullptr) return;
+        munmap(base_, mapped_);
+#ifdef POSIX_FADV_DONTNEED
+        if (drop_) ::posix_fadvise(fd_, static_cast<off_t>(base_offset_), static_cast<off_t>(mapped_), POSIX_FADV_DONTNEED);
+#endif
+        base_ = nullptr;
+        view_ = {};
+    }
+
+    std::string path_;
+    int fd_;
+    std::uint64_t size_;
+    bool drop_;
+    std::byte* base_{nullptr};
+    std::uint64_t base_offset_{0};
+    std::size_t mapped_{0};
+    std::span<const std::byte> view_;
 };
 
 } // namespace
 
 core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> MappedFileProvider::open(const std::string& path) const {
-    const int fd = ::open(path.c_str(), O_RDONLY);
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
     if (fd < 0) {
         return core::Error{"open failed"};
     }
@@ -51,7 +112,7 @@ core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> MappedFileProvid
 
     const auto size = static_cast<std::size_t>(st.st_size);
     if (size == 0) {
-        return std::unique_ptr<core::IMappedFile>(new PosixMappedFile(path, fd, nullptr, 0));
+        return std::unique_ptr<core::IMappedFile>(new PosixMappedFile(path, fd, nullptr, 0, false));
     }
 
     void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
@@ -60,7 +121,23 @@ core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> MappedFileProvid
         return core::Error{"mmap failed"};
     }
 
-    return std::unique_ptr<core::IMappedFile>(new PosixMappedFile(path, fd, static_cast<std::byte*>(mapped), size));
+    return std::unique_ptr<core::IMappedFile>(new PosixMappedFile(path, fd, static_cast<std::byte*>(mapped), size, policy_ == core::CachePolicy::Drop));
+}
+
+core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> MappedFileProvider::open_windowed(const std::string& path) const {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return core::Error{"open failed"};
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return core::Error{"fstat failed"};
+    }
+
+    return std::unique_ptr<core::IMappedFile>(
+        new PosixWindowedFile(path, fd, static_cast<std::uint64_t>(st.st_size), policy_ == core::CachePolicy::Drop));
 }
 
 } // namespace zenith::platform
@@ -0,0 +1,121 @@
+#ifndef _WIN32
+
+#include "platform/RawFile.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace zenith::platform {
+namespace {
+
+#ifdef O_DIRECT
+constexpr int kDirectFlag = O_DIRECT;
+#else
+constexpr int kDirectFlag = 0;
+#endif
+
+bool aligned(std::uint64_t value) { return value % RawFile::kDirectAlignment == 0; }
+
+} // namespace
+
+core::Expected<RawFile, core::Error> RawFile::open(const std::string& path, core::CachePolicy policy) {
+    bool direct = policy == core::CachePolicy::Direct && kDirectFlag != 0;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (direct ? kDirectFlag : 0));
+    if (fd < 0 && direct && errno == EINVAL) {
+        // The file system does not support O_DIRECT (tmpfs, some FUSE mounts).
+        direct = false;
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        return core::Error{"unable to open file"};
+    }
+#ifdef F_NOCACHE
+    if (policy == core::CachePolicy::Direct) ::fcntl(fd, F_NOCACHE, 1);
+#endif
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return core::Error{"fstat failed"};
+    }
+    return RawFile(fd, path, policy, direct, static_cast<std::uint64_t>(st.st_size));
+}
+
+RawFile::RawFile(RawFile&& other) noexcept
+    : handle_(other.handle_),
+      path_(std::move(other.path_)),
+      policy_(other.policy_),
+      direct_(other.direct_),
+      size_(other.size_),
+      offset_(other.offset_),
+      dropped_(other.dropped_) {
+    other.handle_ = -1;
+}
+
+RawFile& RawFile::operator=(RawFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        handle_ = other.handle_;
+        path_ = std::move(other.path_);
+        policy_ = other.policy_;
+        direct_ = other.direct_;
+        size_ = other.size_;
+        offset_ = other.offset_;
+        dropped_ = other.dropped_;
+        other.handle_ = -1;
+    }
+    return *this;
+}
+
+RawFile::~RawFile() { close(); }
+
+core::Expected<std::size_t, core::Error> RawFile::read(std::byte* dst, std::size_t n) {
+    // O_DIRECT needs an aligned buffer, length and offset; the tail of a file
+    // usually breaks the last two, so it is read buffered.
+    if (direct_ && !(aligned(reinterpret_cast<std::uintptr_t>(dst)) && aligned(n) && aligned(offset_))) {
+        if (!go_buffered()) return core::Error{"i/o error while reading"};
+    }
+    ssize_t got = 0;
+    while (true) {
+        got = ::read(handle_, dst, n);
+        if (got >= 0) break;
+        if (errno == EINTR) continue;
+        if (errno == EINVAL && direct_ && go_buffered()) continue;
+        return core::Error{"i/o error while reading"};
+    }
+    offset_ += static_cast<std::uint64_t>(got);
+    if (!direct_) drop_read_pages();
+    return static_cast<std::size_t>(got);
+}
+
+bool RawFile::go_buffered() {
+    direct_ = false;
+    const int flags = ::fcntl(handle_, F_GETFL);
+    return flags >= 0 && ::fcntl(handle_, F_SETFL, flags & ~kDirectFlag) == 0;
+}
+
+void RawFile::drop_read_pages() {
+#ifdef POSIX_FADV_DONTNEED
+    if (policy_ == core::CachePolicy::Normal) return;
+    // Only whole pages are evicted; the page holding offset_ is retried next time.
+    const std::uint64_t end = offset_ - offset_ % kDirectAlignment;
+    if (end > dropped_) {
+        ::posix_fadvise(handle_, static_cast<off_t>(dropped_), static_cast<off_t>(end - dropped_), POSIX_FADV_DONTNEED);
+        dropped_ = end;
+    }
+#endif
+}
+
+void RawFile::close() {
+    if (handle_ < 0) return;
+#ifdef POSIX_FADV_DONTNEED
+    if (policy_ != core::CachePolicy::Normal) ::posix_fadvise(handle_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    ::close(handle_);
+    handle_ = -1;
+}
+
+} // namespace zenith::platform
+
+#endif
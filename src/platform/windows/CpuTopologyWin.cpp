@@ -0,0 +1,35 @@
+#ifdef _WIN32
+
+#include "platform/CpuTopology.hpp"
+
+#define NOMINMAX
+#include <windows.h>
+
+namespace zenith::platform {
+
+CpuTopology::CpuTopology() {
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) return;
+    for (USHORT n = 0; n <= highest; ++n) {
+        GROUP_AFFINITY affinity{};
+        if (!GetNumaNodeProcessorMaskEx(n, &affinity) || affinity.Mask == 0) continue;
+        Node node;
+        node.group = affinity.Group;
+        for (unsigned bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit) {
+            if ((affinity.Mask >> bit) & 1U) node.cpus.push_back(bit);
+        }
+        nodes_.push_back(std::move(node));
+    }
+}
+
+bool CpuTopology::pin_current_thread(std::size_t node) const {
+    if (node >= nodes_.size()) return false;
+    GROUP_AFFINITY affinity{};
+    affinity.Group = nodes_[node].group;
+    for (const auto bit : nodes_[node].cpus) affinity.Mask |= static_cast<KAFFINITY>(1) << bit;
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+}
+
+} // namespace zenith::platform
+
+#endif
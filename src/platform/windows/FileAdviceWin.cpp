@@ -0,0 +1,13 @@
+#ifdef _WIN32
+
+#include "platform/FileAdvice.hpp"
+
+namespace zenith::platform {
+
+// Windows has no read-ahead hint for a file that is not mapped yet; the cache
+// manager's own read-ahead covers the sequential reads that follow.
+void advise_will_need(const std::filesystem::path&) {}
+
+} // namespace zenith::platform
+
+#endif
@@ -0,0 +1,49 @@
+#ifdef _WIN32
+
+#include "platform/FileId.hpp"
+
+#define NOMINMAX
+#include <windows.h>
+
+namespace zenith::platform {
+namespace {
+
+std::optional<BY_HANDLE_FILE_INFORMATION> query_info(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return std::nullopt;
+    BY_HANDLE_FILE_INFORMATION info{};
+    const BOOL ok = GetFileInformationByHandle(file, &info);
+    CloseHandle(file);
+    if (!ok) return std::nullopt;
+    return info;
+}
+
+std::uint64_t join(DWORD high, DWORD low) { return (static_cast<std::uint64_t>(high) << 32) | low; }
+
+} // namespace
+
+std::optional<core::FileId> query_file_id(const std::filesystem::path& path) {
+    const auto info = query_info(path);
+    if (!info) return std::nullopt;
+    return core::FileId{info->dwVolumeSerialNumber, join(info->nFileIndexHigh, info->nFileIndexLow)};
+}
+
+std::optional<core::FileStamp> query_file_stamp(const std::filesystem::path& path) {
+    const auto info = query_info(path);
+    if (!info) return std::nullopt;
+    // FILETIME counts 100 ns ticks.
+    const auto ticks = join(info->ftLastWriteTime.dwHighDateTime, info->ftLastWriteTime.dwLowDateTime);
+    return core::FileStamp{{info->dwVolumeSerialNumber, join(info->nFileIndexHigh, info->nFileIndexLow)},
+                           join(info->nFileSizeHigh, info->nFileSizeLow), static_cast<std::int64_t>(ticks) * 100};
+}
+
+std::int64_t file_stamp_now_ns() {
+    FILETIME now{};
+    GetSystemTimePreciseAsFileTime(&now);
+    return static_cast<std::int64_t>(join(now.dwHighDateTime, now.dwLowDateTime)) * 100;
+}
+
+} // namespace zenith::platform
+
+#endif
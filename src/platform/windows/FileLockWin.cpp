@@ -0,0 +1,50 @@
+#ifdef _WIN32
+
+#include "platform/FileLock.hpp"
+
+#define NOMINMAX
+#include <windows.h>
+
+#include <string>
+#include <utility>
+
+namespace zenith::platform {
+
+core::Expected<FileLock, core::Error> FileLock::acquire(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return core::Error{"cannot open lock file " + path.string() + ": error " + std::to_string(GetLastError())};
+    }
+    OVERLAPPED at{};
+    if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &at)) {
+        const auto err = GetLastError();
+        CloseHandle(file);
+        return core::Error{"cannot lock " + path.string() + ": error " + std::to_string(err)};
+    }
+    return FileLock(file);
+}
+
+FileLock::FileLock(FileLock&& other) noexcept : handle_(std::exchange(other.handle_, INVALID_HANDLE_VALUE)) {}
+
+FileLock& FileLock::operator=(FileLock&& other) noexcept {
+    if (this != &other) {
+        release();
+        handle_ = std::exchange(other.handle_, INVALID_HANDLE_VALUE);
+    }
+    return *this;
+}
+
+FileLock::~FileLock() { release(); }
+
+void FileLock::release() {
+    if (handle_ == INVALID_HANDLE_VALUE) return;
+    OVERLAPPED at{};
+    UnlockFileEx(handle_, 0, MAXDWORD, MAXDWORD, &at);
+    CloseHandle(handle_);
+    handle_ = INVALID_HANDLE_VALUE;
+}
+
+} // namespace zenith::platform
+
+#endif
@@ -5,6 +5,8 @@
 #define NOMINMAX
 #include <windows.h>
 
+#include <algorithm>
+
 namespace zenith::platform {
 namespace {
 
@@ -46,9 +48,62 @@ private:
     std::size_t size_;
 };
 
+// Maps one view at a time. View offsets must be multiples of the allocation
+// granularity, so a window starts on the granule holding its first byte.
+class WinWindowedFile final : public core::IMappedFile {
+public:
+    WinWindowedFile(std::string p, HANDLE file, HANDLE mapping, std::uint64_t size)
+        : path_(std::move(p)), file_(file), mapping_(mapping), size_(size) {}
+
+    ~WinWindowedFile() override {
+        unmap();
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+        }
+        CloseHandle(file_);
+    }
+
+    std::span<const std::byte> bytes() const override { return view_; }
+    std::uint64_t size() const override { return size_; }
+    const std::string& path() const override { return path_; }
+
+    core::Expected<std::span<const std::byte>, core::Error> map_window(std::uint64_t offset, std::size_t length) override {
+        unmap();
+        if (offset >= size_ || length == 0) return view_;
+        length = static_cast<std::size_t>(std::min<std::uint64_t>(length, size_ - offset));
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        const std::uint64_t start = offset - offset % info.dwAllocationGranularity;
+        const auto lead = static_cast<std::size_t>(offset - start);
+        void* view = MapViewOfFile(mapping_, FILE_MAP_READ, static_cast<DWORD>(start >> 32), static_cast<DWORD>(start & 0xFFFFFFFFU), lead + length);
+        if (view == nullptr) {
+            return core::Error{"MapViewOfFile failed"};
+        }
+        base_ = static_cast<std::byte*>(view);
+        view_ = {base_ + lead, length};
+        return view_;
+    }
+
+private:
+    void unmap() {
+        if (base_ == nullptr) return;
+        UnmapViewOfFile(base_);
+        base_ = nullptr;
+        view_ = {};
+    }
+
+    std::string path_;
+    HANDLE file_;
+    HANDLE mapping_;
+    std::uint64_t size_;
+    std::byte* base_{nullptr};
+    std::span<const std::byte> view_;
+};
+
 } // namespace
 
 core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> MappedFileProvider::open(const std::string& path) const {
+    static_cast<void>(policy_); // no per-file eviction hint on Windows
     const auto wide = to_wide(path);
     HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
     if (file == INVALID_HANDLE_VALUE) {
@@ -82,6 +137,31 @@ core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> MappedFileProvid
     return std::unique_ptr<core::IMappedFile>(new WinMappedFile(path, file, mapping, static_cast<std::byte*>(view), size));
 }
 
+core::Expected<std::unique_ptr<core::IMappedFile>, core::Error> MappedFileProvider::open_windowed(const std::string& path) const {
+    const auto wide = to_wide(path);
+    HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return core::Error{"CreateFileW failed"};
+    }
+
+    LARGE_INTEGER size_li{};
+    if (!GetFileSizeEx(file, &size_li)) {
+        CloseHandle(file);
+        return core::Error{"GetFileSizeEx failed"};
+    }
+
+    const auto size = static_cast<std::uint64_t>(size_li.QuadPart);
+    HANDLE mapping = nullptr;
+    if (size > 0) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            CloseHandle(file);
+            return core::Error{"CreateFileMappingW failed"};
+        }
+    }
+    return std::unique_ptr<core::IMappedFile>(new WinWindowedFile(path, file, mapping, size));
+}
+
 } // namespace zenith::platform
 
 #endif
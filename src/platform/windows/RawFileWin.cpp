@@ -0,0 +1,116 @@
+#ifdef _WIN32
+
+#include "platform/RawFile.hpp"
+
+#define NOMINMAX
+#include <windows.h>
+
+namespace zenith::platform {
+namespace {
+
+std::wstring to_wide(const std::string& s) {
+    const int size = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
+    std::wstring out(size > 0 ? static_cast<std::size_t>(size - 1) : 0, L'\0');
+    if (size > 1) {
+        MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, out.data(), size);
+    }
+    return out;
+}
+
+HANDLE open_handle(const std::string& path, bool direct) {
+    const DWORD flags = FILE_FLAG_SEQUENTIAL_SCAN | (direct ? FILE_FLAG_NO_BUFFERING : 0);
+    return CreateFileW(to_wide(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                       OPEN_EXISTING, flags, nullptr);
+}
+
+bool aligned(std::uint64_t value) { return value % RawFile::kDirectAlignment == 0; }
+
+} // namespace
+
+// Windows has no per-file eviction hint, so Drop reads like Normal; Direct uses
+// FILE_FLAG_NO_BUFFERING and reopens the file buffered for an unaligned tail.
+core::Expected<RawFile, core::Error> RawFile::open(const std::string& path, core::CachePolicy policy) {
+    bool direct = policy == core::CachePolicy::Direct;
+    HANDLE handle = open_handle(path, direct);
+    if (handle == INVALID_HANDLE_VALUE && direct) {
+        direct = false;
+        handle = open_handle(path, false);
+    }
+    if (handle == INVALID_HANDLE_VALUE) {
+        return core::Error{"unable to open file"};
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(handle, &size)) {
+        CloseHandle(handle);
+        return core::Error{"GetFileSizeEx failed"};
+    }
+    return RawFile(handle, path, policy, direct, static_cast<std::uint64_t>(size.QuadPart));
+}
+
+RawFile::RawFile(RawFile&& other) noexcept
+    : handle_(other.handle_),
+      path_(std::move(other.path_)),
+      policy_(other.policy_),
+      direct_(other.direct_),
+      size_(other.size_),
+      offset_(other.offset_),
+      dropped_(other.dropped_) {
+    other.handle_ = INVALID_HANDLE_VALUE;
+}
+
+RawFile& RawFile::operator=(RawFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        handle_ = other.handle_;
+        path_ = std::move(other.path_);
+        policy_ = other.policy_;
+        direct_ = other.direct_;
+        size_ = other.size_;
+        offset_ = other.offset_;
+        dropped_ = other.dropped_;
+        other.handle_ = INVALID_HANDLE_VALUE;
+    }
+    return *this;
+}
+
+RawFile::~RawFile() { close(); }
+
+core::Expected<std::size_t, core::Error> RawFile::read(std::byte* dst, std::size_t n) {
+    if (direct_ && !(aligned(reinterpret_cast<std::uintptr_t>(dst)) && aligned(n) && aligned(offset_))) {
+        if (!go_buffered()) return core::Error{"i/o error while reading"};
+    }
+    const DWORD want = n > 0x40000000 ? 0x40000000 : static_cast<DWORD>(n);
+    DWORD got = 0;
+    if (!ReadFile(handle_, dst, want, &got, nullptr)) {
+        return core::Error{"i/o error while reading"};
+    }
+    offset_ += got;
+    return static_cast<std::size_t>(got);
+}
+
+bool RawFile::go_buffered() {
+    direct_ = false;
+    HANDLE buffered = open_handle(path_, false);
+    if (buffered == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER pos{};
+    pos.QuadPart = static_cast<LONGLONG>(offset_);
+    if (!SetFilePointerEx(buffered, pos, nullptr, FILE_BEGIN)) {
+        CloseHandle(buffered);
+        return false;
+    }
+    CloseHandle(handle_);
+    handle_ = buffered;
+    return true;
+}
+
+void RawFile::drop_read_pages() {}
+
+void RawFile::close() {
+    if (handle_ == INVALID_HANDLE_VALUE) return;
+    CloseHandle(handle_);
+    handle_ = INVALID_HANDLE_VALUE;
+}
+
+} // namespace zenith::platform
+
+#endif
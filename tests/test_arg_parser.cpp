@@ -22,3 +22,157 @@ TEST_CASE("ArgParser rejects conflicts") {
     auto parsed = parser.parse({"--count", "--files-with-matches", "pat", "."});
     REQUIRE_FALSE(parsed.has_value());
 }
+
+TEST_CASE("ArgParser parses size suffixes") {
+    zenith::cli::ArgParser parser;
+    auto parsed = parser.parse({"--max-memory", "512M", "pat", "."});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().request.max_memory_bytes.value() == 512U * 1024U * 1024U);
+    CHECK_FALSE(parser.parse({"--max-memory", "12X", "pat", "."}).has_value());
+    // The suffix must not overflow the byte count.
+    auto huge = parser.parse({"--max-memory", "99999999999G", "pat", "."});
+    REQUIRE_FALSE(huge.has_value());
+    CHECK(huge.error().message == "--max-memory value is too large");
+    CHECK_FALSE(parser.parse({"--cache-max", "17179869184G", "pat", "."}).has_value());
+    CHECK(parser.parse({"--cache-max", "17179869183G", "pat", "."}).has_value());
+}
+
+TEST_CASE("ArgParser keeps large thread counts and parses --numa") {
+    zenith::cli::ArgParser parser;
+    auto parsed = parser.parse({"--threads", "128", "--numa", "--dedup-content", "pat", "."});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().request.threads == 128);
+    CHECK(parsed.value().request.numa);
+    CHECK(parsed.value().request.dedup_content);
+}
+
+TEST_CASE("ArgParser parses --io-threads independently of --threads") {
+    zenith::cli::ArgParser parser;
+    auto defaults = parser.parse({"pat", "."});
+    REQUIRE(defaults.has_value());
+    CHECK_FALSE(defaults.value().request.io_threads.has_value());
+    auto parsed = parser.parse({"--threads", "16", "--io-threads", "0", "pat", "."});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().request.threads == 16);
+    REQUIRE(parsed.value().request.io_threads.has_value());
+    CHECK(*parsed.value().request.io_threads == 0);
+    CHECK_FALSE(parser.parse({"--io-threads", "many", "pat", "."}).has_value());
+}
+
+TEST_CASE("ArgParser parses --encoding") {
+    zenith::cli::ArgParser parser;
+    auto defaults = parser.parse({"pat", "."});
+    REQUIRE(defaults.has_value());
+    CHECK(defaults.value().request.encoding == zenith::core::EncodingMode::Auto);
+    auto parsed = parser.parse({"--encoding", "none", "pat", "."});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().request.encoding == zenith::core::EncodingMode::None);
+    CHECK_FALSE(parser.parse({"--encoding", "utf16", "pat", "."}).has_value());
+}
+
+TEST_CASE("ArgParser parses --fuzzy") {
+    zenith::cli::ArgParser parser;
+    auto defaults = parser.parse({"pat", "."});
+    REQUIRE(defaults.has_value());
+    CHECK(defaults.value().request.fuzzy_edits == 0);
+    auto parsed = parser.parse({"--fuzzy", "2", "pattern", "."});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().request.fuzzy_edits == 2);
+    // Three edits could turn any text into a three-byte pattern.
+    CHECK_FALSE(parser.parse({"--fuzzy", "3", "pat", "."}).has_value());
+    CHECK_FALSE(parser.parse({"--fuzzy", "-1", "pat", "."}).has_value());
+}
+
+TEST_CASE("ArgParser takes every positional as a path with --queries-from") {
+    zenith::cli::ArgParser parser;
+    auto parsed = parser.parse({"src", "--queries-from", "q.txt", "tests"});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().queries_path == "q.txt");
+    CHECK(parsed.value().request.pattern.empty());
+    CHECK((parsed.value().request.input_paths == std::vector<std::string>{"src", "tests"}));
+    CHECK_FALSE(parser.parse({"--queries-from", "q.txt"}).has_value());
+    CHECK_FALSE(parser.parse({"--queries-from", "q.txt", "--fuzzy", "1", "."}).has_value());
+}
+
+TEST_CASE("ArgParser parses --format and the decode subcommand") {
+    zenith::cli::ArgParser parser;
+    auto binary = parser.parse({"--format", "binary", "pat", "."});
+    REQUIRE(binary.has_value());
+    CHECK(binary.value().request.output_format == zenith::core::OutputFormat::Binary);
+    auto json = parser.parse({"--json", "pat", "."});
+    REQUIRE(json.has_value());
+    CHECK(json.value().request.output_format == zenith::core::OutputFormat::Jsonl);
+    CHECK_FALSE(parser.parse({"--format", "xml", "pat", "."}).has_value());
+    CHECK_FALSE(parser.parse({"--format", "binary", "--queries-from", "q", "."}).has_value());
+
+    auto decode = parser.parse({"decode", "--json", "out.bin"});
+    REQUIRE(decode.has_value());
+    CHECK(decode.value().run_decode);
+    CHECK(decode.value().decode_input == "out.bin");
+    CHECK(decode.value().request.output_format == zenith::core::OutputFormat::Jsonl);
+    auto search = parser.parse({"decode", "a", "b"});
+    REQUIRE(search.has_value());
+    CHECK_FALSE(search.value().run_decode);
+    CHECK(search.value().request.pattern == "decode");
+    CHECK((search.value().request.input_paths == std::vector<std::string>{"a", "b"}));
+    auto escaped = parser.parse({"--", "decode", "out.bin"});
+    REQUIRE(escaped.has_value());
+    CHECK_FALSE(escaped.value().run_decode);
+    CHECK(escaped.value().request.pattern == "decode");
+}
+
+TEST_CASE("ArgParser parses --cache-policy") {
+    zenith::cli::ArgParser parser;
+    auto defaults = parser.parse({"pat", "."});
+    REQUIRE(defaults.has_value());
+    CHECK(defaults.value().request.cache_policy == zenith::core::CachePolicy::Normal);
+    auto direct = parser.parse({"--cache-policy", "direct", "pat", "."});
+    REQUIRE(direct.has_value());
+    CHECK(direct.value().request.cache_policy == zenith::core::CachePolicy::Direct);
+    CHECK_FALSE(parser.parse({"--cache-policy", "none", "pat", "."}).has_value());
+}
+
+TEST_CASE("ArgParser parses --mmap-window sizes") {
+    zenith::cli::ArgParser parser;
+    auto parsed = parser.parse({"--mmap-window", "64M", "pat", "."});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().request.mmap_window_bytes == 64U * 1024U * 1024U);
+    CHECK_FALSE(parser.parse({"--mmap-window", "big", "pat", "."}).has_value());
+}
+
+TEST_CASE("ArgParser parses --timeout durations and --small-files-first") {
+    zenith::cli::ArgParser parser;
+    auto parsed = parser.parse({"--timeout", "250ms", "--small-files-first", "pat", "."});
+    REQUIRE(parsed.has_value());
+    REQUIRE(parsed.value().request.timeout.has_value());
+    CHECK(parsed.value().request.timeout->count() == 250);
+    CHECK(parsed.value().request.small_files_first);
+    CHECK(parser.parse({"--timeout", "2", "pat", "."}).value().request.timeout->count() == 2000);
+    CHECK(parser.parse({"--timeout", "1m", "pat", "."}).value().request.timeout->count() == 60000);
+    CHECK_FALSE(parser.parse({"--timeout", "0s", "pat", "."}).has_value());
+    CHECK_FALSE(parser.parse({"--timeout", "fast", "pat", "."}).has_value());
+    auto huge = parser.parse({"--timeout", "99999999999999999m", "pat", "."});
+    REQUIRE_FALSE(huge.has_value());
+    CHECK(huge.error().message == "--timeout value is too large");
+}
+
+TEST_CASE("ArgParser searches for the tune word when paths follow it, and after --") {
+    zenith::cli::ArgParser parser;
+    auto tune = parser.parse({"tune", "--output", "p.json"});
+    REQUIRE(tune.has_value());
+    CHECK(tune.value().run_tune);
+    CHECK(tune.value().tune_output == "p.json");
+
+    auto search = parser.parse({"tune", "file.txt"});
+    REQUIRE(search.has_value());
+    CHECK_FALSE(search.value().run_tune);
+    CHECK(search.value().request.pattern == "tune");
+    CHECK(search.value().request.input_paths == std::vector<std::string>{"file.txt"});
+
+    auto escaped = parser.parse({"--count", "--", "--output", "-", "b"});
+    REQUIRE(escaped.has_value());
+    CHECK(escaped.value().request.output_mode == zenith::core::OutputMode::Count);
+    CHECK(escaped.value().request.pattern == "--output");
+    CHECK((escaped.value().request.input_paths == std::vector<std::string>{"-", "b"}));
+    CHECK(parser.parse({"--", "tune"}).error().message == "at least one path is required");
+}
@@ -1,11 +1,43 @@
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/SearchEngine.hpp"
+#include "core/TextEncoding.hpp"
+#include "platform/MappedFileProvider.hpp"
+#include "platform/StdFileReader.hpp"
 #include "platform/StdFilesystemEnumerator.hpp"
+#ifdef __linux__
+#include "platform/GetdentsEnumerator.hpp"
+#endif
 
 #include "doctest.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <stop_token>
 
+namespace {
+class CountOut final : public zenith::core::IOutputWriter {
+public:
+    std::vector<std::string> paths;
+    void write_match(const zenith::core::MatchRecord&) override {}
+    void write_file_summary(const zenith::core::FileMatchSummary& summary) override { paths.push_back(summary.path); }
+};
+
+class MatchOut final : public zenith::core::IOutputWriter {
+public:
+    std::vector<std::string> lines;
+    void write_match(const zenith::core::MatchRecord& r) override {
+        lines.push_back(r.path + ":" + std::to_string(r.offset) + ":" + r.snippet);
+    }
+    void write_file_summary(const zenith::core::FileMatchSummary&) override {}
+};
+
+class NullErr final : public zenith::core::IErrorWriter {
+public:
+    void write_error(const zenith::core::Error&) override {}
+};
+} // namespace
+
 TEST_CASE("Filesystem filtering pipeline works with excludes and ignore files") {
     namespace fs = std::filesystem;
     const auto root = fs::temp_directory_path() / "zenith_fs_filter";
@@ -27,8 +59,355 @@ TEST_CASE("Filesystem filtering pipeline works with excludes and ignore files")
     const auto files = en.enumerate(req, std::stop_token{}, [&](const zenith::core::Error& e) { errors.push_back(e.message); });
 
     CHECK(errors.empty());
-    REQUIRE(files.size() == 1);
-    CHECK(files[0].normalized_path.find("a.cpp") != std::string::npos);
+    REQUIRE(files.files.size() == 1);
+    CHECK(files.paths.normalized(files.files[0].path).find("a.cpp") != std::string::npos);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("hardlinks and overlapping roots are scanned once under the smallest path") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_fs_dedup";
+    fs::remove_all(root);
+    fs::create_directories(root / "app");
+    std::ofstream(root / "app" / "b.log") << "needle";
+    std::ofstream(root / "c.log") << "needle";
+    std::error_code link_ec;
+    fs::create_hard_link(root / "app" / "b.log", root / "z.log", link_ec);
+
+    zenith::platform::StdFilesystemEnumerator enumerator;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullErr err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {root.string(), (root / "app").string(), (root / "c.log").string()};
+    req.output_mode = zenith::core::OutputMode::FilesWithMatches;
+    {
+        CountOut out;
+        zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+        const auto stats = engine.run(req);
+        const std::size_t links = link_ec ? 0 : 1;
+        CHECK(out.paths.size() == 2);
+        CHECK(stats.files_scanned == 2);
+        CHECK(stats.duplicates_skipped == 2 + links);
+        CHECK(stats.duplicate_bytes_skipped == 6 * (2 + links));
+        REQUIRE_FALSE(out.paths.empty());
+        CHECK(fs::path(out.paths[0]).filename() == "b.log");
+    }
+
+    req.dedup_files = false;
+    CountOut out;
+    zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+    const auto stats = engine.run(req);
+    CHECK(stats.duplicates_skipped == 0);
+    CHECK(out.paths.size() >= 4);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("identical files are scanned once and their matches replayed per path") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_fs_content";
+    fs::remove_all(root);
+    fs::create_directories(root / "vendor" / "a");
+    fs::create_directories(root / "vendor" / "b");
+    // Above the size below which files are not worth hashing.
+    const std::string body = "config needle\n" + std::string(5000, '#') + "\nother needle line\n";
+    std::ofstream(root / "vendor" / "a" / "cfg.txt") << body;
+    std::ofstream(root / "vendor" / "b" / "cfg.txt") << body;
+    std::ofstream(root / "copy.txt") << body;
+    std::string twin = body;
+    twin[0] = 'C'; // same size, different bytes
+    std::ofstream(root / "twin.txt") << twin;
+    std::ofstream(root / "unique.txt") << "needle";
+    // Tiny twins are scanned on their own.
+    std::ofstream(root / "tiny1.txt") << "needle\n";
+    std::ofstream(root / "tiny2.txt") << "needle\n";
+
+    zenith::platform::StdFilesystemEnumerator enumerator;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullErr err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {root.string()};
+    req.threads = 1;
+    auto run = [&](zenith::core::SearchStats& stats) {
+        MatchOut out;
+        zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+        stats = engine.run(req);
+        return out.lines;
+    };
+
+    zenith::core::SearchStats plain;
+    const auto expected = run(plain);
+    req.dedup_content = true;
+    zenith::core::SearchStats deduped;
+    const auto lines = run(deduped);
+    CHECK(deduped.content_duplicates == 2);
+    CHECK(deduped.files_scanned == 5);
+    CHECK(deduped.matches == plain.matches);
+    CHECK(lines == expected);
+    CHECK(lines.size() == 11);
+
+    // Hashed from the buffer the file was read into, by the I/O stage or by the
+    // worker itself, and from a mapping.
+    for (const auto mode : {zenith::core::MmapMode::Off, zenith::core::MmapMode::On}) {
+        for (const std::size_t io : {0U, 1U}) {
+            req.mmap_mode = mode;
+            req.io_threads = io;
+            zenith::core::SearchStats stats;
+            CHECK(run(stats) == expected);
+            CHECK(stats.content_duplicates == 2);
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("utf-16 files are searched with the pattern transcoded") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_fs_utf16";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    const auto le = *zenith::core::encode_utf16("h\xC3\xA9llo needle\nnext needle", zenith::core::TextEncoding::Utf16Le);
+    std::ofstream(root / "le.txt", std::ios::binary) << "\xFF\xFE" << le;
+    std::ofstream(root / "be.txt", std::ios::binary) << *zenith::core::encode_utf16("a needle", zenith::core::TextEncoding::Utf16Be);
+    // "needle" in LE bytes, but one byte off the code unit grid.
+    std::ofstream(root / "odd.txt", std::ios::binary) << "\xFF\xFEx" << *zenith::core::encode_utf16("needle", zenith::core::TextEncoding::Utf16Le) << '\0';
+    std::ofstream(root / "plain.txt") << "needle";
+
+    zenith::platform::StdFilesystemEnumerator enumerator;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullErr err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {root.string()};
+    req.threads = 1;
+    zenith::core::SearchStats stats;
+    auto run = [&] {
+        MatchOut out;
+        zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+        stats = engine.run(req);
+        return out.lines;
+    };
+
+    // Offsets count UTF-8 bytes of the text after the BOM ("h\xC3\xA9llo " is 7).
+    const auto lines = run();
+    REQUIRE(lines.size() == 4);
+    CHECK(lines[0] == (root / "be.txt").string() + ":2:a needle");
+    CHECK(lines[1].rfind((root / "le.txt").string() + ":7:", 0) == 0);
+    CHECK(lines[1].find("needle\\nnext needle") != std::string::npos);
+    CHECK(lines[2].rfind((root / "le.txt").string() + ":19:", 0) == 0);
+    CHECK(lines[3] == (root / "plain.txt").string() + ":0:needle");
+    CHECK(stats.utf16_files == 3);
+
+    // Streamed and mapped reads agree with the read-ahead buffers.
+    req.io_threads = 0;
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    CHECK(run() == lines);
+    req.mmap_mode = zenith::core::MmapMode::On;
+    CHECK(run() == lines);
+
+    req.output_mode = zenith::core::OutputMode::Count;
+    run();
+    CHECK(stats.matches == 4);
+
+    req.encoding = zenith::core::EncodingMode::None;
+    run();
+    CHECK(stats.matches == 1);
+    CHECK(stats.utf16_files == 0);
+    fs::remove_all(root);
+}
+
+TEST_CASE("utf-16 streams are searched chunk by chunk") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_fs_utf16_chunks";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    // Surrogate pairs (U+1F600) and two-byte characters fall on every chunk
+    // boundary, and the file is larger than the read-ahead buffers.
+    std::string text;
+    for (int i = 0; text.size() < 12000; ++i) text += i % 3 == 0 ? "\xF0\x9F\x98\x80 needle\n" : i % 3 == 1 ? "h\xC3\xA9 needle " : "x";
+    std::ofstream(root / "a.txt", std::ios::binary) << "\xFF\xFE" << *zenith::core::encode_utf16(text, zenith::core::TextEncoding::Utf16Le);
+    std::vector<std::string> expected;
+    for (auto p = text.find("needle"); p != std::string::npos; p = text.find("needle", p + 1)) {
+        expected.push_back((root / "a.txt").string() + ":" + std::to_string(p) + ":");
+    }
+
+    zenith::platform::StdFilesystemEnumerator enumerator;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullErr err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {root.string()};
+    req.no_snippet = true;
+    req.io_threads = 0;
+    req.mmap_threshold_bytes = 4096;
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    zenith::core::SearchStats stats;
+    auto run = [&] {
+        MatchOut out;
+        zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+        stats = engine.run(req);
+        return out.lines;
+    };
+
+    for (const std::size_t chunk : {std::size_t{1}, std::size_t{7}, std::size_t{64}, std::size_t{1001}}) {
+        req.chunk_size = chunk;
+        req.output_mode = zenith::core::OutputMode::Matches;
+        CHECK(run() == expected);
+        CHECK(stats.utf16_files == 1);
+        CHECK(stats.bytes_scanned == fs::file_size(root / "a.txt"));
+        req.output_mode = zenith::core::OutputMode::Count;
+        run();
+        CHECK(stats.matches == expected.size());
+    }
+    fs::remove_all(root);
+}
+
+TEST_CASE("fuzzy matches agree across chunk boundaries and read paths") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_fs_fuzzy";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::string text;
+    for (const char* word : {"conection_timeout", "connection_timeout", "connection_tiemout", "connection-timeot", "cnonection_tmieout",
+                             "connection", "timeout"}) {
+        text += "warn ";
+        text += word;
+        text += " retrying\n";
+    }
+    std::ofstream(root / "a.log") << text;
+
+    zenith::platform::StdFilesystemEnumerator enumerator;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullErr err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "connection_timeout";
+    req.fuzzy_edits = 2;
+    req.input_paths = {root.string()};
+    req.threads = 1;
+    zenith::core::SearchStats stats;
+    auto run = [&] {
+        MatchOut out;
+        zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+        stats = engine.run(req);
+        return out.lines;
+    };
+
+    // One edit, none, two, two; the rest are three or more edits away.
+    const auto lines = run();
+    REQUIRE(lines.size() == 4);
+    CHECK(lines[0].rfind((root / "a.log").string() + ":5:warn conection_timeout retrying\\n", 0) == 0);
+    CHECK(lines[1].rfind((root / "a.log").string() + ":37:", 0) == 0);
+    CHECK(lines[2].rfind((root / "a.log").string() + ":70:", 0) == 0);
+    CHECK(lines[3].rfind((root / "a.log").string() + ":103:", 0) == 0);
+
+    // Chunks shorter than the pattern cut every match; the stream must still
+    // report each once, as the mapped and read-ahead paths do. Streamed snippets
+    // only see the chunk and its carry, so offsets are compared.
+    req.no_snippet = true;
+    const auto offsets = run();
+    REQUIRE(offsets.size() == 4);
+    req.io_threads = 0;
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    for (std::size_t chunk : {std::size_t{5}, std::size_t{7}, std::size_t{19}, std::size_t{64}}) {
+        req.chunk_size = chunk;
+        CHECK(run() == offsets);
+    }
+    req.mmap_mode = zenith::core::MmapMode::On;
+    CHECK(run() == offsets);
+
+    req.output_mode = zenith::core::OutputMode::Count;
+    run();
+    CHECK(stats.matches == 4);
+    req.fuzzy_edits = 0;
+    run();
+    CHECK(stats.matches == 1);
+    fs::remove_all(root);
+}
+
+#ifdef __linux__
+TEST_CASE("getdents enumerator lists the same files as the std::filesystem one") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_fs_getdents";
+    fs::remove_all(root);
+    fs::create_directories(root / "src" / "deep");
+    fs::create_directories(root / "build");
+    fs::create_directories(root / ".git");
+    fs::create_directories(root / "docs");
+    std::ofstream(root / "src" / "main.cpp") << "int main() {}";
+    std::ofstream(root / "src" / "deep" / "util.HPP") << "#pragma once";
+    std::ofstream(root / "src" / "deep" / "big.cpp") << std::string(4096, 'x');
+    std::ofstream(root / "build" / "out.cpp") << "x";
+    std::ofstream(root / ".git" / "config") << "x";
+    std::ofstream(root / ".hidden.cpp") << "x";
+    std::ofstream(root / "docs" / ".zenithignore") << "draft.md\n";
+    std::ofstream(root / "docs" / "draft.md") << "x";
+    std::ofstream(root / "docs" / "final.md") << "x";
+    std::ofstream(root / "notes.txt") << "x";
+    std::error_code link_ec;
+    fs::create_symlink(root / "src", root / "src_link", link_ec);
+    fs::create_symlink(root / "missing", root / "dangling", link_ec);
+
+    auto listing = [](const zenith::core::IFileEnumerator& en, const zenith::core::SearchRequest& req) {
+        std::vector<std::string> errors;
+        const auto list = en.enumerate(req, std::stop_token{}, [&](const zenith::core::Error& e) { errors.push_back(e.message); });
+        std::vector<std::string> out;
+        for (const auto& f : list.files) out.push_back(list.paths.normalized(f.path));
+        std::sort(out.begin(), out.end());
+        out.push_back("errors: " + std::to_string(errors.size()));
+        return out;
+    };
+
+    const zenith::platform::StdFilesystemEnumerator std_en;
+    const zenith::platform::GetdentsEnumerator getdents_en;
+    std::vector<zenith::core::SearchRequest> requests(6);
+    for (auto& r : requests) r.input_paths = {root.string()};
+    requests[1].ignore_hidden = true;
+    requests[1].exclude_dirs = {"build"};
+    requests[2].extensions = {".hpp", ".md"};
+    requests[3].max_bytes = 100;
+    requests[3].no_ignore = true;
+    requests[4].exclude_globs = {"**/deep/**"};
+    requests[4].follow_symlinks = zenith::core::FollowSymlinksMode::On;
+    requests[5].input_paths = {(root / "src").string() + "/", (root / "notes.txt").string()};
+    for (const auto& r : requests) {
+        const auto expected = listing(std_en, r);
+        CHECK(expected.size() > 1);
+        CHECK(listing(getdents_en, r) == expected);
+    }
+
+    // Sizes are only looked up when a filter needs them.
+    const auto list = getdents_en.enumerate(requests[0], std::stop_token{}, [](const zenith::core::Error&) {});
+    REQUIRE_FALSE(list.files.empty());
+    CHECK_FALSE(list.files[0].size_known());
 
     fs::remove_all(root);
 }
+#endif
@@ -6,9 +6,15 @@
 
 #include "doctest.h"
 
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
 
 namespace {
 class CaptureWriter final : public zenith::core::IOutputWriter {
@@ -24,6 +30,40 @@ public:
     std::vector<std::string> errors;
     void write_error(const zenith::core::Error& error) override { errors.push_back(error.message); }
 };
+
+// Windowed mappings that record the length of every window they map.
+class RecordingProvider final : public zenith::core::IMappedFileProvider {
+public:
+    mutable std::vector<std::size_t> windows;
+
+    zenith::core::Expected<std::unique_ptr<zenith::core::IMappedFile>, zenith::core::Error> open(const std::string& path) const override {
+        return inner_.open(path);
+    }
+    zenith::core::Expected<std::unique_ptr<zenith::core::IMappedFile>, zenith::core::Error> open_windowed(const std::string& path) const override {
+        auto file = inner_.open_windowed(path);
+        if (!file) return file.error();
+        return std::unique_ptr<zenith::core::IMappedFile>(std::make_unique<File>(std::move(file.value()), windows));
+    }
+
+private:
+    class File final : public zenith::core::IMappedFile {
+    public:
+        File(std::unique_ptr<zenith::core::IMappedFile> inner, std::vector<std::size_t>& windows) : inner_(std::move(inner)), windows_(windows) {}
+        std::span<const std::byte> bytes() const override { return inner_->bytes(); }
+        std::uint64_t size() const override { return inner_->size(); }
+        const std::string& path() const override { return inner_->path(); }
+        zenith::core::Expected<std::span<const std::byte>, zenith::core::Error> map_window(std::uint64_t offset, std::size_t length) override {
+            windows_.push_back(length);
+            return inner_->map_window(offset, length);
+        }
+
+    private:
+        std::unique_ptr<zenith::core::IMappedFile> inner_;
+        std::vector<std::size_t>& windows_;
+    };
+
+    zenith::platform::MappedFileProvider inner_;
+};
 } // namespace
 
 TEST_CASE("Mapped file reads bytes and handles empty file") {
@@ -88,3 +128,195 @@ TEST_CASE("mmap and streaming count outputs are equivalent") {
 
     fs::remove_all(root);
 }
+
+TEST_CASE("Every cache policy reads the same bytes and counts") {
+    namespace fs = std::filesystem;
+    using zenith::core::CachePolicy;
+    const auto root = fs::temp_directory_path() / "zenith_cache_policy";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    const auto file = root / "a.txt";
+    // An unaligned length, so direct reads end with a buffered tail.
+    std::string body(3 * 4096 + 123, 'x');
+    for (std::size_t i = 0; i + 6 <= body.size(); i += 1000) body.replace(i, 6, "needle");
+    std::ofstream(file, std::ios::binary) << body;
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    for (const auto policy : {CachePolicy::Normal, CachePolicy::Drop, CachePolicy::Direct}) {
+        zenith::platform::StdFileReader reader(policy);
+        zenith::platform::MappedFileProvider mapped(policy);
+
+        std::vector<std::byte> whole(body.size());
+        auto read = reader.read_into(file.string(), whole);
+        REQUIRE(read.has_value());
+        CHECK(read.value() == body.size());
+        CHECK(std::memcmp(whole.data(), body.data(), body.size()) == 0);
+        std::vector<std::byte> small(100);
+        auto overflow = reader.read_into(file.string(), small);
+        REQUIRE(overflow.has_value());
+        CHECK(overflow.value() == body.size()); // the size from the open, with nothing read
+
+        std::string chunked;
+        auto chunks = reader.read_chunks(file.string(), 4096, {}, [&](const std::string& chunk) -> zenith::core::Expected<void, zenith::core::Error> {
+            chunked += chunk;
+            return {};
+        });
+        CHECK(chunks.has_value());
+        CHECK(chunked == body);
+        auto prefix = reader.read_prefix(file.string(), 10);
+        REQUIRE(prefix.has_value());
+        CHECK(prefix.value() == body.substr(0, 10));
+
+        CaptureWriter out;
+        CaptureError err;
+        zenith::core::SearchEngine eng(en, reader, mapped, naive, bmh, bm, out, err);
+        zenith::core::SearchRequest req;
+        req.pattern = "needle";
+        req.input_paths = {root.string()};
+        req.output_mode = zenith::core::OutputMode::Count;
+        req.mmap_mode = zenith::core::MmapMode::On;
+        req.cache_policy = policy;
+        CHECK(eng.run(req).any_match);
+        REQUIRE(out.summaries.size() == 1);
+        CHECK(out.summaries[0].count == 13);
+        CHECK(err.errors.empty());
+    }
+
+    fs::remove_all(root);
+}
+
+#ifdef __linux__
+TEST_CASE("A file that grows past the buffer after its open does not fit") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_read_into_grows";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    // A FIFO has size 0 at the open, and its writer then adds 200 bytes.
+    const auto fifo = root / "grows";
+    REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+    std::thread writer([&] { std::ofstream(fifo, std::ios::binary) << std::string(200, 'x'); });
+    zenith::platform::StdFileReader reader;
+    std::vector<std::byte> buffer(100);
+    auto read = reader.read_into(fifo.string(), buffer);
+    writer.join();
+    REQUIRE(read.has_value());
+    CHECK(read.value() == buffer.size() + 1);
+
+    fs::remove_all(root);
+}
+#endif
+
+TEST_CASE("Windowed mapping reports what a whole-file mapping does") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_mmap_windows";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    // Matches every 997 bytes, so they fall on every position relative to the
+    // window and page boundaries; one file is UTF-16LE.
+    std::string body;
+    for (int i = 0; body.size() < 60000; ++i) body += std::string(991, static_cast<char>('a' + i % 20)) + "needle";
+    std::ofstream(root / "a.txt", std::ios::binary) << body;
+    std::string utf16 = "\xFF\xFE";
+    for (const char c : body.substr(0, 20000)) utf16 += std::string{c, '\0'};
+    std::ofstream(root / "b.txt", std::ios::binary) << utf16;
+
+    zenith::platform::MappedFileProvider provider;
+    auto windowed = provider.open_windowed((root / "a.txt").string());
+    REQUIRE(windowed.has_value());
+    CHECK(windowed.value()->size() == body.size());
+    auto window = windowed.value()->map_window(5000, 100);
+    REQUIRE(window.has_value());
+    CHECK(std::string(reinterpret_cast<const char*>(window.value().data()), window.value().size()) == body.substr(5000, 100));
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    auto run = [&](zenith::core::SearchRequest req, std::size_t window_bytes) {
+        req.input_paths = {root.string()};
+        req.mmap_mode = zenith::core::MmapMode::On;
+        req.mmap_window_bytes = window_bytes;
+        CaptureWriter out;
+        CaptureError err;
+        zenith::core::SearchEngine eng(en, reader, provider, naive, bmh, bm, out, err);
+        eng.run(req);
+        CHECK(err.errors.empty());
+        std::vector<std::string> lines;
+        for (const auto& m : out.matches) lines.push_back(m.path + ":" + std::to_string(m.offset) + ":" + m.snippet);
+        for (const auto& s : out.summaries) lines.push_back(s.path + ":" + std::to_string(s.count));
+        return lines;
+    };
+
+    zenith::core::SearchRequest matches;
+    matches.pattern = "needle";
+    zenith::core::SearchRequest capped = matches;
+    capped.max_matches_per_file = 7;
+    zenith::core::SearchRequest counts = matches;
+    counts.output_mode = zenith::core::OutputMode::Count;
+    // Fuzzy matching takes the windows as stream chunks, whose snippets stop at
+    // chunk edges, so only offsets are compared.
+    zenith::core::SearchRequest fuzzy = matches;
+    fuzzy.pattern = "neexle";
+    fuzzy.fuzzy_edits = 1;
+    fuzzy.no_snippet = true;
+    for (const auto& req : {matches, capped, counts, fuzzy}) {
+        const auto whole = run(req, 0);
+        CHECK_FALSE(whole.empty());
+        for (const std::size_t window_bytes : {std::size_t{4096}, std::size_t{5000}, std::size_t{70000}}) {
+            CHECK(run(req, window_bytes) == whole);
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("UTF-16 files are scanned one window at a time") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_mmap_utf16_windows";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::string utf16 = "\xFF\xFE";
+    std::size_t needles = 0;
+    for (int i = 0; utf16.size() < 40000; ++i, ++needles) {
+        for (const char c : std::string(991, static_cast<char>('a' + i % 20)) + "needle") utf16 += std::string{c, '\0'};
+    }
+    std::ofstream(root / "a.txt", std::ios::binary) << utf16;
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    RecordingProvider provider;
+    CaptureWriter out;
+    CaptureError err;
+    zenith::core::SearchEngine eng(en, reader, provider, naive, bmh, bm, out, err);
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {root.string()};
+    req.mmap_mode = zenith::core::MmapMode::On;
+    req.mmap_window_bytes = 5000;
+
+    // The first window holds a match, so a quiet run maps no other.
+    req.quiet = true;
+    CHECK(eng.run(req).any_match);
+    CHECK(provider.windows.size() == 1);
+
+    // A window too small for the snippet context still owns a page, and the
+    // file is searched whole.
+    req.quiet = false;
+    req.mmap_window_bytes = 1;
+    provider.windows.clear();
+    out.matches.clear();
+    CHECK(eng.run(req).utf16_files == 1);
+    CHECK(out.matches.size() == needles);
+    CHECK(provider.windows.size() == (utf16.size() + 4095) / 4096);
+    for (const auto length : provider.windows) CHECK(length <= 4096 + 120 + 120 + 11);
+    CHECK(err.errors.empty());
+
+    fs::remove_all(root);
+}
@@ -1,8 +1,11 @@
+#include "platform/BinaryResults.hpp"
+#include "core/TextUtils.hpp"
 #include "platform/OutputWriters.hpp"
 
 #include "doctest.h"
 
 #include <sstream>
+#include <vector>
 
 TEST_CASE("Human output supports no snippet") {
     std::ostringstream os;
@@ -19,3 +22,117 @@ TEST_CASE("JSON output contract includes mode and pattern") {
     CHECK(line.find("\"mode\":\"match\"") != std::string::npos);
     CHECK(line.find("\"pattern\":\"pat\"") != std::string::npos);
 }
+
+TEST_CASE("Stats output lists counters and pattern anchors") {
+    zenith::core::SearchStats stats;
+    stats.files_scanned = 3;
+    stats.matches = 7;
+    stats.anchors = {{2, 'R'}, {0, '\0'}};
+    std::ostringstream os;
+    zenith::platform::write_stats(stats, os);
+    const auto text = os.str();
+    CHECK(text.find("files_scanned: 3\n") != std::string::npos);
+    CHECK(text.find("matches: 7\n") != std::string::npos);
+    CHECK(text.find("duplicates_skipped: 0\n") != std::string::npos);
+    CHECK(text.find("anchors: 'R'@2 0x00@0\n") != std::string::npos);
+}
+
+TEST_CASE("Binary output round-trips through the reader") {
+    std::ostringstream os;
+    zenith::platform::BinaryOutputWriter writer(os, zenith::core::OutputMode::Matches, "pat", false);
+    const std::vector<zenith::core::MatchRecord> records{
+        {"a", 300, "x", false}, {"a", 5000000000, "", false}, {"b", 7, "y\nz", true}, {"a", 2, "again", false}};
+    for (const auto& r : records) writer.write_match(r);
+    const auto bytes = os.str();
+    CHECK(bytes.compare(0, 4, "ZSRB") == 0);
+
+    std::istringstream is(bytes);
+    zenith::platform::BinaryResultsReader reader(is);
+    auto header = reader.read_header();
+    REQUIRE(header.has_value());
+    CHECK(header.value().pattern == "pat");
+    CHECK(header.value().mode == zenith::core::OutputMode::Matches);
+    CHECK(header.value().snippets);
+    for (const auto& r : records) {
+        auto next = reader.next();
+        REQUIRE(next.has_value());
+        REQUIRE(next.value().has_value());
+        const auto& m = next.value()->match;
+        CHECK(m.path == r.path);
+        CHECK(m.offset == r.offset);
+        CHECK(m.snippet == r.snippet);
+        CHECK(m.binary == r.binary);
+    }
+    auto end = reader.next();
+    REQUIRE(end.has_value());
+    CHECK_FALSE(end.value().has_value());
+
+    // A truncated stream is an error, not a short one.
+    std::istringstream cut(bytes.substr(0, bytes.size() - 2));
+    zenith::platform::BinaryResultsReader cut_reader(cut);
+    REQUIRE(cut_reader.read_header().has_value());
+    bool failed = false;
+    for (int i = 0; i < 8 && !failed; ++i) {
+        auto next = cut_reader.next();
+        failed = !next.has_value();
+        if (next.has_value() && !next.value().has_value()) break;
+    }
+    CHECK(failed);
+}
+
+TEST_CASE("Binary count output carries summaries and skips unknown records") {
+    std::ostringstream os;
+    zenith::platform::BinaryOutputWriter writer(os, zenith::core::OutputMode::Count, "pat", false);
+    writer.write_file_summary({"a", 3, false});
+    auto bytes = os.str();
+    bytes += std::string("\x7f\x02zz", 4); // a record type from a later version
+    std::istringstream is(bytes);
+    zenith::platform::BinaryResultsReader reader(is);
+    auto header = reader.read_header();
+    REQUIRE(header.has_value());
+    CHECK(header.value().mode == zenith::core::OutputMode::Count);
+    CHECK_FALSE(header.value().snippets);
+    auto next = reader.next();
+    REQUIRE(next.has_value());
+    REQUIRE(next.value().has_value());
+    CHECK(next.value()->type == zenith::platform::BinaryRecordType::Summary);
+    CHECK(next.value()->summary.path == "a");
+    CHECK(next.value()->summary.count == 3);
+    auto end = reader.next();
+    REQUIRE(end.has_value());
+    CHECK_FALSE(end.value().has_value());
+}
+
+TEST_CASE("Escaping fast paths agree with the byte-by-byte rules") {
+    auto reference = [](const std::string& in, bool json) {
+        std::string out;
+        for (const unsigned char c : in) {
+            if (c == '\n') out += "\\n";
+            else if (c == '\r') out += "\\r";
+            else if (c == '\t') out += "\\t";
+            else if (json && c == '"') out += "\\\"";
+            else if (json && c == '\\') out += "\\\\";
+            else if (c < 0x20 || (!json && c >= 0x7F)) out += "..";
+            else out.push_back(static_cast<char>(c));
+        }
+        return out;
+    };
+    std::string all;
+    for (int c = 0; c < 256; ++c) all.push_back(static_cast<char>(c));
+    CHECK(zenith::core::sanitize_snippet(all) == reference(all, false));
+    CHECK(zenith::core::json_escape(all) == reference(all, true));
+
+    // One special byte at every position of runs longer than a vector.
+    for (const char special : {'\n', '"', '\\', '\x01', '\x7f', '\x80', '\xff'}) {
+        for (std::size_t len = 0; len < 40; ++len) {
+            for (std::size_t at = 0; at <= len; ++at) {
+                std::string in(len, 'a');
+                if (at < len) in[at] = special;
+                std::string out = "prefix";
+                zenith::core::append_json_escaped(out, in);
+                CHECK(out == "prefix" + reference(in, true));
+                CHECK(zenith::core::sanitize_snippet(in) == reference(in, false));
+            }
+        }
+    }
+}
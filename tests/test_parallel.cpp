@@ -1,15 +1,24 @@
+#include "core/BufferPool.hpp"
 #include "core/NaiveSearchAlgorithm.hpp"
+#include "core/ResultSpool.hpp"
 #include "core/SearchEngine.hpp"
 #include "platform/MappedFileProvider.hpp"
+#include "platform/Searcher.hpp"
 #include "platform/StdFileReader.hpp"
 #include "platform/StdFilesystemEnumerator.hpp"
+#ifdef __linux__
+#include "platform/GetdentsEnumerator.hpp"
+#endif
 
 #include "doctest.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <mutex>
+#include <thread>
 
 namespace {
 class CaptureWriter final : public zenith::core::IOutputWriter {
@@ -29,6 +38,47 @@ class CaptureError final : public zenith::core::IErrorWriter {
 public:
     void write_error(const zenith::core::Error&) override {}
 };
+// Counts which reads the engine asks for.
+class CountingReader final : public zenith::core::IFileReader {
+public:
+    zenith::platform::StdFileReader inner;
+    mutable std::atomic<int> prefixes{0};
+    mutable std::atomic<int> streams{0};
+    mutable std::atomic<int> whole{0};
+    zenith::core::Expected<std::string, zenith::core::Error> read_prefix(const std::string& path, std::size_t max_bytes) const override {
+        ++prefixes;
+        return inner.read_prefix(path, max_bytes);
+    }
+    zenith::core::Expected<void, zenith::core::Error> read_chunks(
+        const std::string& path, std::size_t chunk_size, std::stop_token stop_token,
+        const std::function<zenith::core::Expected<void, zenith::core::Error>(const std::string&)>& on_chunk) const override {
+        ++streams;
+        return inner.read_chunks(path, chunk_size, stop_token, on_chunk);
+    }
+    zenith::core::Expected<std::size_t, zenith::core::Error> read_into(const std::string& path, std::span<std::byte> buffer) const override {
+        ++whole;
+        return inner.read_into(path, buffer);
+    }
+};
+// Counts the files the engine maps.
+class CountingMapped final : public zenith::core::IMappedFileProvider {
+public:
+    zenith::platform::MappedFileProvider inner;
+    mutable std::atomic<int> opens{0};
+    zenith::core::Expected<std::unique_ptr<zenith::core::IMappedFile>, zenith::core::Error> open(const std::string& path) const override {
+        ++opens;
+        return inner.open(path);
+    }
+};
+class FakeTopology final : public zenith::core::ICpuTopology {
+public:
+    mutable std::atomic<int> pins[3]{};
+    std::size_t node_count() const override { return 3; }
+    bool pin_current_thread(std::size_t node) const override {
+        ++pins[node];
+        return true;
+    }
+};
 } // namespace
 
 TEST_CASE("stable output deterministic between thread counts") {
@@ -108,3 +158,383 @@ TEST_CASE("test cancel hook triggers cancellation") {
     CHECK(stats.cancelled);
     fs::remove_all(root);
 }
+
+// Naive search that stalls on text containing "slow".
+class SlowAlgorithm final : public zenith::core::ISearchAlgorithm {
+public:
+    std::vector<std::size_t> find_all(std::string_view buffer, std::string_view pattern) const override {
+        if (buffer.find("slow") != std::string_view::npos) std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return naive.find_all(buffer, pattern);
+    }
+    zenith::core::NaiveSearchAlgorithm naive;
+};
+
+TEST_CASE("timeout reports the files completed before it, in order, and is not a cancellation") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_timeout";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "a.txt") << "token";
+    std::ofstream(root / "b.txt") << "slow token";
+    std::ofstream(root / "c.txt") << "token";
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    SlowAlgorithm slow;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureWriter out;
+    CaptureError err;
+    zenith::core::SearchEngine engine(en, reader, mapped, slow, bmh, bm, out, err);
+
+    zenith::core::SearchRequest req;
+    req.pattern = "token";
+    req.input_paths = {root.string()};
+    req.algorithm_mode = zenith::core::AlgorithmMode::Naive;
+    req.output_mode = zenith::core::OutputMode::Count;
+    req.threads = 1;
+    req.io_threads = 0;
+    req.timeout = std::chrono::milliseconds(50);
+    // b.txt is still being scanned when the timer fires; c.txt is never claimed.
+    const auto stats = engine.run(req);
+    CHECK(stats.timed_out);
+    CHECK_FALSE(stats.cancelled);
+    CHECK(stats.files_enumerated == 3);
+    CHECK(stats.files_completed == 2);
+    CHECK(stats.bytes_completed == 15);
+    REQUIRE(out.lines.size() == 2);
+    CHECK(out.lines[0] == (root / "a.txt").string() + ":1");
+    CHECK(out.lines[1] == (root / "b.txt").string() + ":1");
+
+    // Claimed smallest first, a.txt and c.txt finish before b.txt stalls. b.txt
+    // then finishes after the timer fires, so nothing was cut short and the run
+    // did not time out.
+    req.small_files_first = true;
+    CaptureWriter small_first;
+    zenith::core::SearchEngine engine2(en, reader, mapped, slow, bmh, bm, small_first, err);
+    const auto stats2 = engine2.run(req);
+    CHECK_FALSE(stats2.timed_out);
+    CHECK_FALSE(stats2.cancelled);
+    CHECK(stats2.files_completed == 3);
+    CHECK(small_first.lines.size() == 3);
+    fs::remove_all(root);
+}
+
+TEST_CASE("max-memory spill keeps stable output identical") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_parallel_spill";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    for (int i = 0; i < 40; ++i) {
+        std::ofstream(root / ("f" + std::to_string(i) + ".txt")) << "x pattern y pattern z " << i;
+    }
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "pattern";
+    req.input_paths = {root.string()};
+    req.threads = 4;
+
+    CaptureWriter in_memory;
+    zenith::core::SearchEngine e1(en, reader, mapped, naive, bmh, bm, in_memory, err);
+    const auto s1 = e1.run(req);
+    CHECK(s1.spilled_results == 0);
+
+    CaptureWriter spilled;
+    zenith::core::SearchEngine e2(en, reader, mapped, naive, bmh, bm, spilled, err);
+    req.max_memory_bytes = 1;
+    const auto s2 = e2.run(req);
+    CHECK(s2.spilled_results == 40);
+
+    CHECK(in_memory.lines.size() == 80);
+    CHECK(in_memory.lines == spilled.lines);
+    fs::remove_all(root);
+}
+
+TEST_CASE("result spool spills to one file and reads results back by job") {
+    // One spill per put: more spills than a process may have open files.
+    constexpr std::size_t kJobs = 3000;
+    zenith::core::ResultSpool spool(kJobs, 1);
+    for (std::size_t i = 0; i < kJobs; ++i) {
+        const std::size_t job = i * 7919 % kJobs;
+        zenith::core::FileResult fr;
+        fr.path = "f" + std::to_string(job);
+        fr.any_match = true;
+        fr.count = job + 1;
+        fr.matches.push_back({job, "snippet " + std::to_string(job), 0});
+        REQUIRE(spool.put(job, std::move(fr)).has_value());
+    }
+    CHECK(spool.spilled_results() == kJobs);
+    // The index of spilled offsets is held in memory and counts toward the peak.
+    CHECK(spool.peak_bytes() >= kJobs * 2 * sizeof(std::uint64_t));
+    for (std::size_t job = 0; job < kJobs; ++job) {
+        auto taken = spool.take(job);
+        REQUIRE(taken.has_value());
+        REQUIRE(taken.value().has_value());
+        CHECK(taken.value()->path == "f" + std::to_string(job));
+        CHECK(taken.value()->count == job + 1);
+        CHECK(taken.value()->matches.at(0).snippet == "snippet " + std::to_string(job));
+    }
+    CHECK_FALSE(spool.take(kJobs - 1).value().has_value());
+}
+
+TEST_CASE("numa mode pins every worker, lifts the 32-thread cap and keeps stable output") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_parallel_numa";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    for (int i = 0; i < 300; ++i) {
+        std::ofstream(root / ("f" + std::to_string(i) + ".txt")) << "x pattern " << i;
+    }
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+    FakeTopology topology;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "pattern";
+    req.input_paths = {root.string()};
+    req.threads = 1;
+    CaptureWriter single;
+    zenith::core::SearchEngine e1(en, reader, mapped, naive, bmh, bm, single, err);
+    e1.set_cpu_topology(&topology);
+    e1.run(req);
+    CHECK(topology.pins[0].load() == 0);
+
+    req.threads = 48;
+    req.io_threads = 3;
+    req.numa = true;
+    CaptureWriter numa;
+    zenith::core::SearchEngine e2(en, reader, mapped, naive, bmh, bm, numa, err);
+    e2.set_cpu_topology(&topology);
+    const auto stats = e2.run(req);
+    CHECK(stats.files_scanned == 300);
+    // 48 scan workers and 3 I/O threads, dealt round-robin over the 3 nodes.
+    CHECK(topology.pins[0].load() + topology.pins[1].load() + topology.pins[2].load() == 51);
+    CHECK(topology.pins[2].load() == 17);
+    CHECK(single.lines.size() == 300);
+    CHECK(numa.lines == single.lines);
+    fs::remove_all(root);
+}
+
+TEST_CASE("buffer pool lends a fixed number of aligned buffers") {
+    zenith::core::BufferPool pool(2, 8192);
+    auto a = pool.try_acquire();
+    auto b = pool.try_acquire();
+    REQUIRE(a);
+    REQUIRE(b);
+    CHECK(a.bytes().size() == 8192);
+    CHECK(reinterpret_cast<std::uintptr_t>(a.bytes().data()) % zenith::core::BufferPool::kAlignment == 0);
+    CHECK_FALSE(pool.try_acquire());
+    const auto* first = a.bytes().data();
+    a.reset();
+    auto c = pool.try_acquire();
+    REQUIRE(c);
+    CHECK(c.bytes().data() == first);
+    CHECK(pool.allocated() == 2);
+}
+
+TEST_CASE("io stage reads ahead without changing results") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_parallel_io";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    for (int i = 0; i < 200; ++i) {
+        std::ofstream(root / ("f" + std::to_string(i) + ".txt")) << "x pattern " << i << " pattern";
+    }
+    std::ofstream(root / "large.txt") << std::string(200000, 'y') << "pattern";
+    std::ofstream(root / "bin.dat", std::ios::binary) << std::string("pattern\0", 8);
+    std::ofstream(root / "empty.txt") << "";
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "pattern";
+    req.input_paths = {root.string()};
+    req.threads = 3;
+    req.io_threads = 0;
+    CaptureWriter direct;
+    zenith::core::SearchEngine e1(en, reader, mapped, naive, bmh, bm, direct, err);
+    const auto s1 = e1.run(req);
+    CHECK(s1.read_ahead_files == 0);
+    CHECK(s1.peak_io_threads == 0);
+
+    req.io_threads = 4;
+    CaptureWriter staged;
+    zenith::core::SearchEngine e2(en, reader, mapped, naive, bmh, bm, staged, err);
+    const auto s2 = e2.run(req);
+    CHECK(s2.read_ahead_files == 202); // every small file, including bin.dat and empty.txt
+    CHECK(s2.peak_io_threads >= 1);
+    CHECK(s2.peak_io_threads <= 4);
+    CHECK(s2.files_scanned == s1.files_scanned);
+    CHECK(s2.bytes_scanned == s1.bytes_scanned);
+    CHECK(direct.lines.size() == 401);
+    CHECK(staged.lines == direct.lines);
+
+#ifdef __linux__
+    // The CLI's enumerator leaves sizes unknown; the stage learns them on open.
+    zenith::platform::GetdentsEnumerator getdents;
+    CaptureWriter unsized;
+    zenith::core::SearchEngine e3(getdents, reader, mapped, naive, bmh, bm, unsized, err);
+    const auto s3 = e3.run(req);
+    CHECK(s3.read_ahead_files == 202);
+    CHECK(s3.bytes_scanned == s1.bytes_scanned);
+    CHECK(unsized.lines == direct.lines);
+#endif
+    fs::remove_all(root);
+}
+
+TEST_CASE("scan workers read small files with one read when nothing reads ahead") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_parallel_small";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream(root / ("f" + std::to_string(i) + ".txt")) << "x pattern " << i;
+    }
+    std::ofstream(root / "bin.dat", std::ios::binary) << std::string("pattern\0", 8);
+    std::ofstream(root / "large.txt") << std::string(300000, 'y') << "pattern";
+
+    zenith::platform::StdFilesystemEnumerator en;
+    CountingReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+    CaptureWriter out;
+    zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, out, err);
+    zenith::core::SearchRequest req;
+    req.pattern = "pattern";
+    req.input_paths = {root.string()};
+    req.threads = 2;
+    req.io_threads = 0;
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    const auto stats = engine.run(req);
+    // Only the file above the buffer size is streamed, with one open.
+    CHECK(reader.whole.load() == 21);
+    CHECK(reader.prefixes.load() == 0);
+    CHECK(reader.streams.load() == 1);
+    CHECK(stats.files_scanned == 21); // bin.dat is skipped as binary
+    CHECK(out.lines.size() == 21);
+    fs::remove_all(root);
+}
+
+#ifdef __linux__
+TEST_CASE("files the enumerator did not size are read whole when small and mapped when large") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_parallel_unsized";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream(root / ("f" + std::to_string(i) + ".txt")) << "x pattern " << i;
+    }
+    std::ofstream(root / "large.txt") << std::string(300000, 'y') << "pattern";
+
+    // getdents leaves every size unknown without --max-bytes and the like.
+    zenith::platform::GetdentsEnumerator en;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+    zenith::core::SearchRequest req;
+    req.pattern = "pattern";
+    req.input_paths = {root.string()};
+    req.threads = 2;
+    req.io_threads = 0;
+
+    CountingReader reader;
+    CountingMapped mapped;
+    CaptureWriter out;
+    zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, out, err);
+    auto stats = engine.run(req);
+    // large.txt does not fit: its read learns the size and it is mapped.
+    CHECK(reader.whole.load() == 21);
+    CHECK(mapped.opens.load() == 1);
+    CHECK(reader.prefixes.load() == 0);
+    CHECK(reader.streams.load() == 0);
+    CHECK(stats.files_scanned == 21);
+    CHECK(out.lines.size() == 21);
+
+    CountingReader off_reader;
+    CountingMapped off_mapped;
+    CaptureWriter off_out;
+    zenith::core::SearchEngine off_engine(en, off_reader, off_mapped, naive, bmh, bm, off_out, err);
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    stats = off_engine.run(req);
+    CHECK(off_reader.whole.load() == 21);
+    CHECK(off_mapped.opens.load() == 0);
+    CHECK(off_reader.prefixes.load() == 0);
+    CHECK(off_reader.streams.load() == 1);
+    CHECK(stats.files_scanned == 21);
+    fs::remove_all(root);
+}
+#endif
+
+TEST_CASE("worker pool threads are reused across runs and batch searches") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_parallel_pool";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    for (int i = 0; i < 40; ++i) {
+        std::ofstream(root / ("f" + std::to_string(i) + ".txt")) << "alpha " << i << " beta alpha";
+    }
+
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "alpha";
+    req.input_paths = {root.string()};
+    req.threads = 3;
+    req.io_threads = 2;
+    CaptureWriter fresh;
+    zenith::core::SearchEngine e1(en, reader, mapped, naive, bmh, bm, fresh, err);
+    e1.run(req);
+
+    zenith::core::WorkerPool pool;
+    CaptureWriter pooled;
+    zenith::core::SearchEngine e2(en, reader, mapped, naive, bmh, bm, pooled, err);
+    e2.set_worker_pool(&pool);
+    e2.run(req);
+    CHECK(pool.size() == 5);
+    pooled.lines.clear();
+    e2.run(req);
+    CHECK(pool.size() == 5);
+    CHECK(pooled.lines.size() == 80);
+    CHECK(pooled.lines == fresh.lines);
+
+    zenith::platform::Searcher searcher(err);
+    const std::vector<std::string> queries{"alpha", "beta"};
+    std::vector<std::size_t> counts(2, 0);
+    for (int round = 0; round < 2; ++round) {
+        searcher.search(req, queries, [&](const zenith::core::QueryResult& result) { counts[result.query] += result.matches.size(); });
+    }
+    CHECK(counts[0] == 160);
+    CHECK(counts[1] == 80);
+    fs::remove_all(root);
+}
@@ -0,0 +1,38 @@
+#include "core/PathTable.hpp"
+
+#include "doctest.h"
+
+#include <algorithm>
+#include <numeric>
+
+TEST_CASE("PathTable derives paths and orders like the normalized strings") {
+    zenith::core::PathTable table;
+    const auto root = table.add_root("logs", "logs");
+    const auto dot = table.add_root(".", ".");
+    const auto a = table.add_child(root, "a");
+    const auto ab = table.add_child(root, "a-b");
+    std::vector<zenith::core::PathId> ids = {
+        table.add_child(a, "x.log"),   table.add_child(root, "a-b.log"), table.add_child(ab, "y.log"),
+        table.add_child(root, "A.log"), table.add_child(dot, "z.log"),    table.add_child(table.add_root("logs/a", "logs/a"), "w.log"),
+    };
+    CHECK(table.normalized(ids[0]) == "logs/a/x.log");
+    CHECK(table.normalized(ids[4]) == "z.log");
+    CHECK(table.path(ids[4]) == "./z.log");
+
+    std::vector<std::string> expected;
+    for (auto id : ids) expected.push_back(table.normalized(id));
+    std::sort(expected.begin(), expected.end());
+    std::sort(ids.begin(), ids.end(), [&](auto l, auto r) { return table.normalized_less(l, r); });
+    std::vector<std::string> got;
+    for (auto id : ids) got.push_back(table.normalized(id));
+    CHECK(got == expected);
+}
+
+TEST_CASE("PathTable treats the same file under overlapping roots as equal") {
+    zenith::core::PathTable table;
+    const auto outer = table.add_child(table.add_child(table.add_root("logs/", "logs/"), "app"), "b.log");
+    const auto inner = table.add_child(table.add_root("logs/app", "logs/app"), "b.log");
+    CHECK(table.normalized(outer) == "logs/app/b.log");
+    CHECK(table.normalized_equal(outer, inner));
+    CHECK(table.path(outer) == table.path(inner));
+}
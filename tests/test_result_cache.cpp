@@ -0,0 +1,319 @@
+#include "cli/ArgParser.hpp"
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/SearchEngine.hpp"
+#include "platform/FileId.hpp"
+#include "platform/MappedFileProvider.hpp"
+#include "platform/ResultCache.hpp"
+#include "platform/StdFileReader.hpp"
+#include "platform/StdFilesystemEnumerator.hpp"
+
+#include "doctest.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+class CollectOut final : public zenith::core::IOutputWriter {
+public:
+    std::vector<std::string> lines;
+    void write_match(const zenith::core::MatchRecord& r) override {
+        lines.push_back(r.path + ":" + std::to_string(r.offset) + ":" + r.snippet);
+    }
+    void write_file_summary(const zenith::core::FileMatchSummary& s) override { lines.push_back(s.path + ":" + std::to_string(s.count)); }
+};
+
+class NullErr final : public zenith::core::IErrorWriter {
+public:
+    void write_error(const zenith::core::Error&) override {}
+};
+
+// Ages a file past the mtime granularity the cache waits out.
+void backdate(const std::filesystem::path& path) {
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+}
+
+std::filesystem::path fresh_dir(const char* name) {
+    const auto dir = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(dir);
+    return dir;
+}
+
+zenith::core::FileStamp stamp_of(std::uint64_t inode) { return {{1, inode}, 100, 12345}; }
+} // namespace
+
+TEST_CASE("result cache round-trips records through its store file") {
+    const auto dir = fresh_dir("zenith_cache_roundtrip");
+    zenith::core::FileResult fr;
+    fr.count = 2;
+    fr.any_match = true;
+    fr.matches = {{3, "a needle"}, {40, ""}};
+    {
+        auto cache = zenith::platform::DiskResultCache::open(dir);
+        REQUIRE(cache.has_value());
+        cache.value()->store(stamp_of(1), "q", fr);
+        cache.value()->store(stamp_of(2), "q", zenith::core::FileResult{});
+        REQUIRE(cache.value()->save().has_value());
+    }
+    auto cache = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(cache.has_value());
+    CHECK(cache.value()->size() == 2);
+    auto hit = cache.value()->lookup(stamp_of(1), "q");
+    REQUIRE(hit.has_value());
+    CHECK(hit->count == 2);
+    CHECK(hit->any_match);
+    REQUIRE(hit->matches.size() == 2);
+    CHECK(hit->matches[0].snippet == "a needle");
+    CHECK(hit->matches[1].offset == 40);
+    auto miss = cache.value()->lookup(stamp_of(2), "q");
+    REQUIRE(miss.has_value());
+    CHECK_FALSE(miss->any_match);
+
+    CHECK_FALSE(cache.value()->lookup(stamp_of(1), "other").has_value());
+    auto touched = stamp_of(1);
+    touched.mtime_ns += 1;
+    CHECK_FALSE(cache.value()->lookup(touched, "q").has_value());
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("result cache evicts least recently used records beyond its cap") {
+    const auto dir = fresh_dir("zenith_cache_lru");
+    zenith::core::FileResult fr;
+    fr.count = 1;
+    fr.any_match = true;
+    fr.matches = {{0, std::string(100, 'x')}};
+    {
+        auto cache = zenith::platform::DiskResultCache::open(dir);
+        REQUIRE(cache.has_value());
+        cache.value()->store(stamp_of(1), "q", fr);
+        cache.value()->store(stamp_of(2), "q", fr);
+        REQUIRE(cache.value()->save().has_value());
+    }
+    {
+        // Header plus room for two ~150-byte records.
+        auto cache = zenith::platform::DiskResultCache::open(dir, 400);
+        REQUIRE(cache.has_value());
+        CHECK(cache.value()->lookup(stamp_of(2), "q").has_value());
+        cache.value()->store(stamp_of(3), "q", fr);
+        REQUIRE(cache.value()->save().has_value());
+        CHECK(cache.value()->size() == 2);
+    }
+    auto cache = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(cache.has_value());
+    CHECK_FALSE(cache.value()->lookup(stamp_of(1), "q").has_value());
+    CHECK(cache.value()->lookup(stamp_of(2), "q").has_value());
+    CHECK(cache.value()->lookup(stamp_of(3), "q").has_value());
+
+    // A damaged tail is ignored, and cut off by the next save.
+    const auto store = dir / "results.v1";
+    const auto intact = std::filesystem::file_size(store);
+    std::ofstream(store, std::ios::binary | std::ios::app) << "junk";
+    {
+        auto reopened = zenith::platform::DiskResultCache::open(dir);
+        REQUIRE(reopened.has_value());
+        CHECK(reopened.value()->size() == 2);
+        reopened.value()->store(stamp_of(4), "q", zenith::core::FileResult{});
+        REQUIRE(reopened.value()->save().has_value());
+        CHECK(reopened.value()->size() == 3);
+    }
+    auto reopened = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(reopened.has_value());
+    CHECK(reopened.value()->size() == 3);
+    CHECK(std::filesystem::file_size(store) > intact);
+
+    // A damaged header is discarded rather than trusted.
+    std::ofstream(store, std::ios::binary | std::ios::trunc) << "junk";
+    auto discarded = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(discarded.has_value());
+    CHECK(discarded.value()->size() == 0);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("result cache keeps the recency of hits across runs") {
+    const auto dir = fresh_dir("zenith_cache_recency");
+    const auto store = dir / "results.v1";
+    zenith::core::FileResult fr;
+    fr.count = 1;
+    fr.any_match = true;
+    fr.matches = {{0, std::string(100, 'x')}};
+    {
+        auto cache = zenith::platform::DiskResultCache::open(dir);
+        REQUIRE(cache.has_value());
+        for (std::uint64_t i = 1; i <= 3; ++i) cache.value()->store(stamp_of(i), "q", fr);
+        REQUIRE(cache.value()->save().has_value());
+    }
+    // A run that only hits stamp 1 records that, though it stores nothing.
+    const auto before = std::filesystem::file_size(store);
+    {
+        auto cache = zenith::platform::DiskResultCache::open(dir);
+        REQUIRE(cache.has_value());
+        CHECK(cache.value()->lookup(stamp_of(1), "q").has_value());
+        REQUIRE(cache.value()->save().has_value());
+    }
+    const auto touched = std::filesystem::file_size(store);
+    CHECK(touched > before);
+    // Hitting the same records again writes nothing.
+    {
+        auto cache = zenith::platform::DiskResultCache::open(dir);
+        REQUIRE(cache.has_value());
+        CHECK(cache.value()->lookup(stamp_of(1), "q").has_value());
+        REQUIRE(cache.value()->save().has_value());
+    }
+    CHECK(std::filesystem::file_size(store) == touched);
+    {
+        // Room for two records: the one stored now, and the one hit last.
+        auto cache = zenith::platform::DiskResultCache::open(dir, 400);
+        REQUIRE(cache.has_value());
+        cache.value()->store(stamp_of(4), "q", fr);
+        REQUIRE(cache.value()->save().has_value());
+    }
+    auto cache = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(cache.has_value());
+    CHECK(cache.value()->size() == 2);
+    CHECK(cache.value()->lookup(stamp_of(1), "q").has_value());
+    CHECK(cache.value()->lookup(stamp_of(4), "q").has_value());
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("result caches sharing a directory append their own queries") {
+    const auto dir = fresh_dir("zenith_cache_shared");
+    auto result_with = [](std::size_t count) {
+        zenith::core::FileResult fr;
+        fr.count = count;
+        fr.any_match = true;
+        return fr;
+    };
+    {
+        auto cache = zenith::platform::DiskResultCache::open(dir);
+        REQUIRE(cache.has_value());
+        cache.value()->store(stamp_of(1), "base", result_with(1));
+        REQUIRE(cache.value()->save().has_value());
+    }
+    // Both load the same store, and each adds a query the other does not know.
+    auto first = zenith::platform::DiskResultCache::open(dir);
+    auto second = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(first.has_value());
+    REQUIRE(second.has_value());
+    first.value()->store(stamp_of(1), "alpha", result_with(2));
+    second.value()->store(stamp_of(1), "beta", result_with(3));
+    REQUIRE(first.value()->save().has_value());
+    REQUIRE(second.value()->save().has_value());
+    CHECK(second.value()->size() == 3);
+
+    auto cache = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(cache.has_value());
+    CHECK(cache.value()->size() == 3);
+    CHECK(cache.value()->lookup(stamp_of(1), "base")->count == 1);
+    CHECK(cache.value()->lookup(stamp_of(1), "alpha")->count == 2);
+    CHECK(cache.value()->lookup(stamp_of(1), "beta")->count == 3);
+
+    // One that loaded before another compacted the store merges with the new one.
+    const auto store = dir / "results.v1";
+    auto stale = zenith::platform::DiskResultCache::open(dir);
+    // Too small for another segment, large enough for the store as one segment.
+    auto compacting = zenith::platform::DiskResultCache::open(dir, std::filesystem::file_size(store) + 20);
+    REQUIRE(stale.has_value());
+    REQUIRE(compacting.has_value());
+    const auto id = zenith::platform::query_file_id(store);
+    compacting.value()->store(stamp_of(2), "gamma", result_with(4));
+    REQUIRE(compacting.value()->save().has_value());
+    CHECK(compacting.value()->size() == 4);
+    CHECK_FALSE(zenith::platform::query_file_id(store) == id);
+    stale.value()->store(stamp_of(3), "delta", result_with(5));
+    REQUIRE(stale.value()->save().has_value());
+    auto merged = zenith::platform::DiskResultCache::open(dir);
+    REQUIRE(merged.has_value());
+    CHECK(merged.value()->size() == 5);
+    CHECK(merged.value()->lookup(stamp_of(1), "beta")->count == 3);
+    CHECK(merged.value()->lookup(stamp_of(2), "gamma")->count == 4);
+    CHECK(merged.value()->lookup(stamp_of(3), "delta")->count == 5);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("engine answers unchanged files from the result cache") {
+    namespace fs = std::filesystem;
+    const auto root = fresh_dir("zenith_cache_engine");
+    fs::create_directories(root / "logs");
+    std::ofstream(root / "logs" / "a.log") << "needle one\nneedle two\n";
+    std::ofstream(root / "logs" / "b.log") << "nothing here\n";
+    backdate(root / "logs" / "a.log");
+    backdate(root / "logs" / "b.log");
+    const auto cache_dir = root / "cache";
+    const auto store = cache_dir / "results.v1";
+
+    zenith::platform::StdFilesystemEnumerator enumerator;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullErr err;
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {(root / "logs").string()};
+
+    auto run = [&](zenith::core::SearchStats& stats) {
+        CollectOut out;
+        zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+        auto cache = zenith::platform::DiskResultCache::open(cache_dir);
+        REQUIRE(cache.has_value());
+        engine.set_result_cache(cache.value().get());
+        stats = engine.run(req);
+        REQUIRE(cache.value()->save().has_value());
+        return out.lines;
+    };
+
+    zenith::core::SearchStats first;
+    const auto cold = run(first);
+    CHECK(first.cache_hits == 0);
+    CHECK(first.files_scanned == 2);
+    // A run that only hits leaves the store alone.
+    const auto store_bytes = fs::file_size(store);
+    const auto store_written = fs::last_write_time(store);
+    zenith::core::SearchStats second;
+    const auto warm = run(second);
+    CHECK(second.cache_hits == 2);
+    CHECK(second.files_scanned == 0);
+    CHECK(second.matches == 2);
+    CHECK(warm == cold);
+    CHECK(fs::file_size(store) == store_bytes);
+    CHECK(fs::last_write_time(store) == store_written);
+
+    // A different query is scanned again, and its records are appended in place.
+    const auto store_id = zenith::platform::query_file_id(store);
+    req.output_mode = zenith::core::OutputMode::Count;
+    zenith::core::SearchStats counted;
+    run(counted);
+    CHECK(counted.cache_hits == 0);
+    CHECK(fs::file_size(store) > store_bytes);
+    CHECK(zenith::platform::query_file_id(store) == store_id);
+
+    // A file just rewritten is scanned, and not cached while its mtime is that recent.
+    std::ofstream(root / "logs" / "b.log") << "needle appended\n";
+    req.output_mode = zenith::core::OutputMode::Matches;
+    zenith::core::SearchStats rewritten;
+    run(rewritten);
+    CHECK(rewritten.cache_hits == 1);
+    CHECK(rewritten.matches == 3);
+    zenith::core::SearchStats again;
+    run(again);
+    CHECK(again.cache_hits == 1);
+    CHECK(again.files_scanned == 1);
+    backdate(root / "logs" / "b.log");
+    zenith::core::SearchStats aged;
+    run(aged);
+    zenith::core::SearchStats settled;
+    run(settled);
+    CHECK(settled.cache_hits == 2);
+    CHECK(settled.matches == 3);
+    fs::remove_all(root);
+}
+
+TEST_CASE("ArgParser parses --cache and --cache-max") {
+    zenith::cli::ArgParser parser;
+    auto parsed = parser.parse({"--cache", "/tmp/zc", "--cache-max", "64M", "pat", "."});
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().cache_dir == "/tmp/zc");
+    CHECK(parsed.value().cache_max_bytes.value() == 64U * 1024U * 1024U);
+    CHECK_FALSE(parser.parse({"--cache-max", "lots", "pat", "."}).has_value());
+}
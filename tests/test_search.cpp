@@ -1,18 +1,35 @@
+#include "core/ContentHash.hpp"
+#include "core/FuzzySearch.hpp"
+#include "core/MultiPatternSearch.hpp"
 #include "core/NaiveSearchAlgorithm.hpp"
+#include "core/RareByteSearchAlgorithm.hpp"
 #include "core/SearchEngine.hpp"
+#include "core/ShortPatternSearchAlgorithm.hpp"
+#include "core/TextEncoding.hpp"
+#include "core/TwoWaySearchAlgorithm.hpp"
 
 #include "doctest.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <memory>
+#include <tuple>
 #include <stop_token>
 #include <unordered_map>
 
 namespace {
 class FakeEnumerator final : public zenith::core::IFileEnumerator {
 public:
-    std::vector<zenith::core::FileItem> files;
-    std::vector<zenith::core::FileItem> enumerate(const zenith::core::SearchRequest&, std::stop_token, const ErrorCallback&) const override {
-        return files;
+    struct Entry {
+        std::string path;
+        std::uintmax_t size;
+    };
+    std::vector<Entry> files;
+    zenith::core::FileList enumerate(const zenith::core::SearchRequest&, std::stop_token, const ErrorCallback&) const override {
+        zenith::core::FileList list;
+        for (const auto& f : files) list.files.push_back({list.paths.add_root(f.path, f.path), f.size});
+        return list;
     }
 };
 
@@ -76,7 +93,7 @@ public:
 
 TEST_CASE("Search finds chunk boundary matches and max-matches cap") {
     FakeEnumerator en;
-    en.files = {{"f", "f", 12}};
+    en.files = {{"f", 12}};
     FakeReader reader;
     reader.contents = {{"f", "xxab" "cxxabc"}};
     FakeMappedProvider mapped;
@@ -102,7 +119,7 @@ TEST_CASE("Search finds chunk boundary matches and max-matches cap") {
 
 TEST_CASE("Count mode counts all even with max-matches") {
     FakeEnumerator en;
-    en.files = {{"f", "f", 6}};
+    en.files = {{"f", 6}};
     FakeReader reader;
     reader.contents = {{"f", "aaaaaa"}};
     FakeMappedProvider mapped;
@@ -134,3 +151,496 @@ TEST_CASE("Algorithms overlap equivalence") {
     CHECK(n == bmh.find_all("aaaaaa", "aaa"));
     CHECK(n == bm.find_all("aaaaaa", "aaa"));
 }
+
+TEST_CASE("max-total-matches keeps the first N in path order and stops early") {
+    FakeEnumerator en;
+    FakeReader reader;
+    FakeMappedProvider mapped;
+    for (int i = 0; i < 20; ++i) {
+        const auto name = "f" + std::string(i < 10 ? "0" : "") + std::to_string(i);
+        en.files.push_back({name, 8});
+        reader.contents[name] = "ab ab ab";
+    }
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureWriter out;
+    CaptureError err;
+    zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, out, err);
+
+    zenith::core::SearchRequest req;
+    req.pattern = "ab";
+    req.input_paths = {"."};
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    req.threads = 4;
+    req.max_total_matches = 4;
+
+    auto stats = engine.run(req);
+    CHECK(stats.any_match);
+    CHECK_FALSE(stats.cancelled);
+    REQUIRE(out.matches.size() == 4);
+    CHECK(out.matches[0].path == "f00");
+    CHECK(out.matches[2].path == "f00");
+    CHECK(out.matches[3].path == "f01");
+    CHECK(out.matches[3].offset == 0);
+
+    // Counts are printed whole, up to the file that reaches the limit; files
+    // with matches use one of it each.
+    req.output_mode = zenith::core::OutputMode::Count;
+    CaptureWriter counts;
+    zenith::core::SearchEngine count_engine(en, reader, mapped, naive, bmh, bm, counts, err);
+    stats = count_engine.run(req);
+    CHECK_FALSE(stats.cancelled);
+    REQUIRE(counts.summaries.size() == 2);
+    CHECK(counts.summaries[0].count == 3);
+    CHECK(counts.summaries[1].path == "f01");
+    CHECK(counts.summaries[1].count == 3);
+
+    req.output_mode = zenith::core::OutputMode::FilesWithMatches;
+    CaptureWriter listed;
+    zenith::core::SearchEngine list_engine(en, reader, mapped, naive, bmh, bm, listed, err);
+    stats = list_engine.run(req);
+    REQUIRE(listed.summaries.size() == 4);
+    CHECK(listed.summaries[3].path == "f03");
+}
+
+TEST_CASE("quiet mode writes nothing and is not a cancellation") {
+    FakeEnumerator en;
+    en.files = {{"a", 6}, {"b", 6}};
+    FakeReader reader;
+    reader.contents = {{"a", "zzzzzz"}, {"b", "zzabzz"}};
+    FakeMappedProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureWriter out;
+    CaptureError err;
+    zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, out, err);
+
+    zenith::core::SearchRequest req;
+    req.pattern = "ab";
+    req.input_paths = {"."};
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    req.quiet = true;
+
+    auto stats = engine.run(req);
+    CHECK(stats.any_match);
+    CHECK_FALSE(stats.cancelled);
+    CHECK(out.matches.empty());
+    CHECK(out.summaries.empty());
+}
+
+TEST_CASE("Short pattern kernels agree with naive for every length and tail") {
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::ShortPatternSearchAlgorithm short_kernels;
+    std::string hay;
+    for (int i = 0; i < 300; ++i) hay += static_cast<char>("abcab\0ca"[i % 8] + (i % 37 == 0 ? 1 : 0));
+    hay += "abcabcabcabcabcabca";
+    for (std::size_t len = 1; len <= 17; ++len) {
+        for (std::size_t start : {std::size_t{0}, std::size_t{3}, hay.size() - len}) {
+            const auto pat = hay.substr(start, len);
+            for (std::size_t cut : {hay.size(), hay.size() - 1, std::size_t{40}}) {
+                std::string_view view(hay.data(), cut);
+                CHECK(short_kernels.find_all(view, pat) == naive.find_all(view, pat));
+                CHECK(short_kernels.count_all(view, pat) == naive.find_all(view, pat).size());
+            }
+        }
+    }
+}
+
+TEST_CASE("Two-Way agrees with naive on periodic and random inputs") {
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::TwoWaySearchAlgorithm two_way;
+    const std::string runs(200, 'a');
+    for (const std::string pat : {"a", "aa", "ab", "aaaaaaaaab", "baaaaaaaaa", "aaaaaaaaaaaaaaaaaaaa", "abaabaab", "abcabcabd"}) {
+        CHECK(two_way.find_all(runs, pat) == naive.find_all(runs, pat));
+        CHECK(two_way.find_all("abaabaabaabaabcabcabcabdaab" + runs + "b", pat) ==
+              naive.find_all("abaabaabaabaabcabcabcabdaab" + runs + "b", pat));
+    }
+    std::uint32_t seed = 7;
+    auto next = [&] { return seed = seed * 1103515245U + 12345U; };
+    for (int round = 0; round < 200; ++round) {
+        std::string hay;
+        for (int i = 0; i < 300; ++i) hay += static_cast<char>('a' + (next() >> 16) % 3);
+        const auto len = 1 + (next() >> 16) % 24;
+        const auto start = (next() >> 16) % (hay.size() - len);
+        const auto pat = hay.substr(start, len);
+        CHECK(two_way.find_all(hay, pat) == naive.find_all(hay, pat));
+        CHECK(two_way.find_all(hay, pat + "c") == naive.find_all(hay, pat + "c"));
+        CHECK(two_way.count_all(hay, pat) == naive.find_all(hay, pat).size());
+    }
+}
+
+TEST_CASE("Rare-byte kernel agrees with naive and survives repetitive input") {
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::RareByteSearchAlgorithm rare;
+    std::string logs;
+    for (int i = 0; i < 400; ++i) logs += (i % 7 == 0) ? "E_ERROR_X " : "E_E_E_ ";
+    for (const std::string pat : {"_ERROR_X E_E_E_ E_E_", "E_E_E_ E_E_E_ E_E_E_ E", "Q_ERROR_X E_E_E_ E_E"}) {
+        CHECK(rare.find_all(logs, pat) == naive.find_all(logs, pat));
+    }
+    const std::string runs(20000, 'a');
+    const std::string all_a(40, 'a');
+    CHECK(rare.find_all(runs, all_a) == naive.find_all(runs, all_a));
+    CHECK(rare.count_all(runs, all_a) == runs.size() - all_a.size() + 1);
+    CHECK(rare.find_all(runs + "b", all_a + "b") == std::vector<std::size_t>{runs.size() - all_a.size()});
+}
+
+TEST_CASE("Counting kernels agree with find_all on frequent tokens") {
+    zenith::core::ShortPatternSearchAlgorithm short_kernels;
+    zenith::core::RareByteSearchAlgorithm rare;
+    // Long enough for the lane counters to wrap batches several times.
+    std::string hay;
+    for (int i = 0; i < 20000; ++i) hay += (i % 3 == 0) ? "ab" : "a";
+    for (const std::string pat : {"a", "b", "aa", "ab", "ba", "aab", "abaab", "aabaabaabaabaab", "aabaabaabaabaabaa"}) {
+        for (std::size_t cut : {hay.size(), hay.size() - 1, std::size_t{4097}, std::size_t{15}}) {
+            std::string_view view(hay.data(), cut);
+            const auto expected = short_kernels.find_all(view, pat).size();
+            CHECK(short_kernels.count_all(view, pat) == expected);
+            CHECK(rare.count_all(view, pat) == expected);
+        }
+    }
+}
+
+TEST_CASE("Count mode takes the counting path for mapped and streamed files") {
+    FakeEnumerator en;
+    std::string big;
+    for (int i = 0; i < 5000; ++i) big += "xx needle ";
+    en.files = {{"a", big.size()}, {"b", 6}};
+    FakeReader reader;
+    reader.contents = {{"a", big}, {"b", "needle"}};
+    FakeMappedProvider mapped;
+    mapped.contents = reader.contents;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+
+    for (auto mmap : {zenith::core::MmapMode::On, zenith::core::MmapMode::Off}) {
+        CaptureWriter out;
+        zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, out, err);
+        zenith::core::SearchRequest req;
+        req.pattern = "needle";
+        req.input_paths = {"."};
+        req.output_mode = zenith::core::OutputMode::Count;
+        req.mmap_mode = mmap;
+        req.chunk_size = 7; // forces matches across chunk boundaries
+        auto stats = engine.run(req);
+        CHECK(stats.matches == 5001);
+        REQUIRE(out.summaries.size() == 2);
+        CHECK(out.summaries[0].count == 5000);
+        CHECK(out.summaries[1].count == 1);
+    }
+}
+
+TEST_CASE("Auto mode reports rare-byte anchors in stats") {
+    FakeEnumerator en;
+    en.files = {{"f", 12}};
+    FakeReader reader;
+    reader.contents = {{"f", "x_ERROR_ERROR"}};
+    FakeMappedProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureWriter out;
+    CaptureError err;
+    zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, out, err);
+
+    zenith::core::SearchRequest req;
+    req.pattern = "_ERROR";
+    req.input_paths = {"f"};
+    req.mmap_mode = zenith::core::MmapMode::Off;
+    auto stats = engine.run(req);
+    CHECK(stats.matches == 2);
+    CHECK(stats.files_scanned == 1);
+    CHECK(stats.bytes_scanned == 13);
+    REQUIRE(stats.anchors.size() == 2);
+    CHECK(stats.anchors[0].byte != '_');
+    CHECK(stats.anchors[1].byte != '_');
+}
+
+TEST_CASE("Content hash matches reference XXH64 with seeds 0 and 1") {
+    auto hash = [](const std::string& s) { return zenith::core::hash_content(std::as_bytes(std::span(s.data(), s.size()))); };
+    CHECK(hash("").lo == 0xef46db3751d8e999ULL);
+    CHECK(hash("").hi == 0xd5afba1336a3be4bULL);
+    CHECK(hash("abc").lo == 0x44bc2cf5ad770999ULL);
+    CHECK(hash("abc").hi == 0xbea9ca8199328908ULL);
+    std::string long_input;
+    for (int i = 0; i < 10; ++i) long_input += "0123456789";
+    CHECK(hash(long_input).lo == 0xf80e7b96315afffaULL);
+    CHECK(hash(long_input).hi == 0xa50a84f168bdc5afULL);
+    CHECK(hash(long_input) != hash(long_input.substr(1)));
+}
+
+TEST_CASE("default read_into reads whole files and reports ones that do not fit") {
+    FakeReader reader;
+    reader.contents["/a"] = "hello";
+    reader.contents["/e"] = "";
+    std::array<std::byte, 5> buffer{};
+    auto fit = reader.read_into("/a", buffer);
+    REQUIRE(fit);
+    CHECK(fit.value() == 5);
+    CHECK(std::memcmp(buffer.data(), "hello", 5) == 0);
+    auto empty = reader.read_into("/e", buffer);
+    REQUIRE(empty);
+    CHECK(empty.value() == 0);
+    auto small = reader.read_into("/a", std::span<std::byte>(buffer).first(4));
+    REQUIRE(small);
+    CHECK(small.value() > 4);
+    CHECK_FALSE(reader.read_into("/missing", buffer));
+}
+
+TEST_CASE("UTF-16 detection and pattern transcoding") {
+    using zenith::core::TextEncoding;
+    auto bytes = [](std::string_view s) { return std::as_bytes(std::span(s.data(), s.size())); };
+    CHECK(zenith::core::detect_encoding(bytes("\xFF\xFEh")) == TextEncoding::Utf16Le);
+    CHECK(zenith::core::detect_encoding(bytes("\xFE\xFF")) == TextEncoding::Utf16Be);
+    CHECK(zenith::core::detect_encoding(bytes(std::string_view("h\0i\0!\0", 6))) == TextEncoding::Utf16Le);
+    CHECK(zenith::core::detect_encoding(bytes(std::string_view("\0h\0i\0!", 6))) == TextEncoding::Utf16Be);
+    CHECK(zenith::core::detect_encoding(bytes("plain ascii text")) == TextEncoding::Bytes);
+    CHECK(zenith::core::detect_encoding(bytes(std::string_view("h\0\0\0i\0", 6))) == TextEncoding::Bytes);
+    CHECK(zenith::core::detect_encoding(bytes(std::string_view("h\0", 2))) == TextEncoding::Bytes);
+
+    // "é", a CJK character and U+1F600 (a surrogate pair).
+    const std::string text = "\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80";
+    const auto le = zenith::core::encode_utf16(text, TextEncoding::Utf16Le);
+    REQUIRE(le.has_value());
+    CHECK(*le == std::string("\xE9\x00\x2D\x4E\x3D\xD8\x00\xDE", 8));
+    const auto be = zenith::core::encode_utf16(text, TextEncoding::Utf16Be);
+    REQUIRE(be.has_value());
+    CHECK(*be == std::string("\x00\xE9\x4E\x2D\xD8\x3D\xDE\x00", 8));
+    CHECK(zenith::core::decode_utf16(*le, TextEncoding::Utf16Le) == text);
+    CHECK(zenith::core::decode_utf16(*be, TextEncoding::Utf16Be) == text);
+    CHECK(zenith::core::utf8_size(*le, TextEncoding::Utf16Le) == text.size());
+    // A lone surrogate decodes to U+FFFD.
+    CHECK(zenith::core::decode_utf16(std::string("\x3D\xD8", 2), TextEncoding::Utf16Le) == "\xEF\xBF\xBD");
+
+    CHECK_FALSE(zenith::core::encode_utf16("\xC3", TextEncoding::Utf16Le).has_value());
+    CHECK_FALSE(zenith::core::encode_utf16("\xC0\xAF", TextEncoding::Utf16Le).has_value()); // overlong '/'
+    CHECK_FALSE(zenith::core::encode_utf16("\xED\xA0\x80", TextEncoding::Utf16Le).has_value()); // surrogate
+}
+
+namespace {
+// Textbook edit distance between `a` and `b`.
+std::size_t edit_distance(std::string_view a, std::string_view b) {
+    std::vector<std::size_t> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+    for (std::size_t i = 1; i <= a.size(); ++i) {
+        std::size_t diag = row[0];
+        row[0] = i;
+        for (std::size_t j = 1; j <= b.size(); ++j) {
+            const std::size_t up = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diag + (a[i - 1] == b[j - 1] ? 0U : 1U)});
+            diag = up;
+        }
+    }
+    return row[b.size()];
+}
+
+// Runs of end positions within k edits by the textbook column-wise dynamic
+// program, each taken at its closest end and the start closest to the pattern
+// length; of overlapping matches the closest to the pattern is kept.
+std::vector<std::tuple<std::size_t, std::size_t, std::size_t>> reference_fuzzy(std::string_view text, std::string_view pat, std::size_t k) {
+    std::vector<std::pair<std::size_t, std::size_t>> runs; // (end, distance)
+    std::vector<std::size_t> col(pat.size() + 1);
+    for (std::size_t i = 0; i <= pat.size(); ++i) col[i] = i;
+    bool in_run = false;
+    for (std::size_t j = 0; j < text.size(); ++j) {
+        std::size_t diag = 0; // row 0 stays 0: a match may start anywhere
+        for (std::size_t i = 1; i <= pat.size(); ++i) {
+            const std::size_t left = col[i];
+            col[i] = std::min({col[i] + 1, col[i - 1] + 1, diag + (pat[i - 1] == text[j] ? 0U : 1U)});
+            diag = left;
+        }
+        const std::size_t d = col[pat.size()];
+        if (d <= k) {
+            if (!in_run) runs.emplace_back(j + 1, d);
+            else if (d < runs.back().second) runs.back() = {j + 1, d};
+            in_run = true;
+        } else {
+            in_run = false;
+        }
+    }
+    auto gap = [&](std::size_t len) { return len > pat.size() ? len - pat.size() : pat.size() - len; };
+    std::vector<std::tuple<std::size_t, std::size_t, std::size_t>> out;
+    for (const auto& [end, d] : runs) {
+        std::size_t start = end;
+        for (std::size_t len = 1; len <= std::min(end, pat.size() + k); ++len) {
+            if (edit_distance(pat, text.substr(end - len, len)) == d && (start == end || gap(len) < gap(end - start))) start = end - len;
+        }
+        if (!out.empty() && start < std::get<1>(out.back())) {
+            auto& [s0, e0, d0] = out.back();
+            if (d < d0 || (d == d0 && gap(end - start) < gap(e0 - s0))) out.back() = {start, end, d};
+            continue;
+        }
+        out.emplace_back(start, end, d);
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("Fuzzy search agrees with the textbook edit distance") {
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::RareByteSearchAlgorithm rare;
+
+    const std::string log = "we recieve data, then receive more; reciever and RECEIVE differ";
+    zenith::core::FuzzySearcher typo("receive", 2, rare);
+    const auto found = typo.find(log).matches;
+    REQUIRE(found.size() == 3);
+    CHECK(log.substr(found[0].start, found[0].end - found[0].start) == "recieve");
+    CHECK(found[0].distance == 2);
+    CHECK(log.substr(found[1].start, found[1].end - found[1].start) == "receive");
+    CHECK(found[1].distance == 0);
+    CHECK(log.substr(found[2].start, found[2].end - found[2].start) == "recieve");
+
+    std::uint32_t seed = 11;
+    auto next = [&] { return (seed = seed * 1103515245U + 12345U) >> 16; };
+    for (int round = 0; round < 60; ++round) {
+        std::string text;
+        for (int i = 0; i < 400; ++i) text += static_cast<char>('a' + next() % 4);
+        // Lengths past 64 take the blocked automaton.
+        const std::size_t len = 4 + next() % 100;
+        std::string pat;
+        for (std::size_t i = 0; i < len; ++i) pat += static_cast<char>('a' + next() % 4);
+        const std::size_t k = 1 + next() % 3;
+        const std::size_t at = next() % (text.size() - len / 2);
+        text.replace(at, std::min(len, text.size() - at), pat.substr(0, std::min(len, text.size() - at)));
+        if (next() % 2 == 0) text[at + next() % std::min(len, text.size() - at)] = 'x';
+
+        const auto expected = reference_fuzzy(text, pat, k);
+        for (const zenith::core::ISearchAlgorithm* literal : {static_cast<const zenith::core::ISearchAlgorithm*>(&naive),
+                                                              static_cast<const zenith::core::ISearchAlgorithm*>(&rare)}) {
+            zenith::core::FuzzySearcher searcher(pat, k, *literal);
+            const auto scan = searcher.find(text);
+            CHECK_FALSE(scan.open_end.has_value());
+            std::vector<std::tuple<std::size_t, std::size_t, std::size_t>> found_matches;
+            for (const auto& m : scan.matches) found_matches.emplace_back(m.start, m.end, m.distance);
+            CHECK(found_matches == expected);
+
+            // A partial scan holds back only a match reaching the end of the text.
+            const std::size_t cut = text.size() / 2;
+            const auto head = searcher.find(std::string_view(text).substr(0, cut), true);
+            for (const auto& m : head.matches) {
+                CHECK(std::find(expected.begin(), expected.end(), std::tuple{m.start, m.end, m.distance}) != expected.end());
+            }
+        }
+    }
+}
+
+TEST_CASE("Multi-pattern search agrees with naive for small and large batches") {
+    zenith::core::NaiveSearchAlgorithm naive;
+    std::uint32_t seed = 7;
+    auto next = [&] {
+        seed = seed * 1664525U + 1013904223U;
+        return seed >> 8;
+    };
+    std::string text;
+    for (int i = 0; i < 3000; ++i) text.push_back("abcab\n"[next() % 6]);
+    for (const std::size_t batch : {3U, 40U, 300U}) {
+        std::vector<std::string> patterns{"", "a"};
+        while (patterns.size() < batch) {
+            std::string p;
+            for (std::size_t n = 1 + next() % 6; n > 0; --n) p.push_back("abc"[next() % 3]);
+            patterns.push_back(p);
+        }
+        patterns.push_back(patterns.back()); // a repeated query reports separately
+        const std::vector<const zenith::core::ISearchAlgorithm*> kernels(patterns.size(), &naive);
+        const zenith::core::MultiPatternSearch search(patterns, kernels);
+        std::vector<std::pair<std::size_t, std::size_t>> got;
+        search.find(text, [&](std::size_t q, std::size_t pos) { got.emplace_back(q, pos); });
+        std::vector<std::pair<std::size_t, std::size_t>> expected;
+        for (std::size_t q = 1; q < patterns.size(); ++q) {
+            for (const auto pos : naive.find_all(text, patterns[q])) expected.emplace_back(q, pos);
+        }
+        std::sort(got.begin(), got.end());
+        CHECK(got == expected);
+    }
+}
+
+TEST_CASE("Batch queries match one run per pattern on every read path") {
+    FakeEnumerator en;
+    FakeReader reader;
+    FakeMappedProvider mapped;
+    std::uint32_t seed = 11;
+    for (const std::string name : {"a", "b", "c"}) {
+        std::string text;
+        for (int i = 0; i < 700; ++i) {
+            seed = seed * 1664525U + 1013904223U;
+            text.push_back("xyz-\n"[(seed >> 8) % 5]);
+        }
+        en.files.push_back({name, text.size()});
+        reader.contents[name] = text;
+        mapped.contents[name] = text;
+    }
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+    std::vector<std::string> patterns{"xyz", "z-", "y", "zzz", "-x-", "yy", "x\nx", "zy", "xz", "z-y", "x-", "--", "absent"};
+
+    zenith::core::SearchRequest req;
+    req.input_paths = {"a", "b", "c"};
+    req.max_matches_per_file = 40;
+    for (const auto& [mmap, chunk] : {std::pair{zenith::core::MmapMode::Off, std::size_t{5}}, std::pair{zenith::core::MmapMode::Off, std::size_t{64}},
+                                      std::pair{zenith::core::MmapMode::On, std::size_t{64}}}) {
+        req.mmap_mode = mmap;
+        req.chunk_size = chunk;
+        for (const std::size_t n : {std::size_t{3}, patterns.size()}) {
+            const std::span<const std::string> batch(patterns.data(), n);
+            CaptureWriter unused;
+            zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, unused, err);
+            std::vector<std::vector<std::string>> got(n);
+            const auto stats = engine.run_batch(req, batch, [&](const zenith::core::QueryResult& result) {
+                for (const auto& m : result.matches) got[result.query].push_back(std::string(result.path) + ":" + std::to_string(m.offset) + ":" + m.snippet);
+            });
+            CHECK(stats.files_scanned == 3);
+            for (std::size_t q = 0; q < n; ++q) {
+                CaptureWriter out;
+                zenith::core::SearchEngine single(en, reader, mapped, naive, bmh, bm, out, err);
+                req.pattern = patterns[q];
+                single.run(req);
+                std::vector<std::string> expected;
+                for (const auto& m : out.matches) expected.push_back(m.path + ":" + std::to_string(m.offset) + ":" + m.snippet);
+                CHECK(got[q] == expected);
+            }
+            req.pattern.clear();
+        }
+    }
+}
+
+TEST_CASE("max-matches keeps the first matches and still counts the rest across slices") {
+    // One match straddles the 16 MiB slice boundary of mapped scans.
+    std::string text(16U * 1024U * 1024U - 4U, 'x');
+    text.insert(2, "abc");
+    text += "abcabc" + std::string(100, 'y') + "abc";
+    FakeEnumerator en;
+    en.files = {{"f", text.size()}};
+    FakeReader reader;
+    reader.contents = {{"f", text}};
+    FakeMappedProvider mapped;
+    mapped.contents = reader.contents;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    CaptureError err;
+
+    zenith::core::SearchRequest req;
+    req.pattern = "abc";
+    req.input_paths = {"f"};
+    for (const auto mode : {zenith::core::MmapMode::On, zenith::core::MmapMode::Off}) {
+        for (const std::size_t cap : {1U, 2U, 10U}) {
+            req.mmap_mode = mode;
+            req.max_matches_per_file = cap;
+            CaptureWriter out;
+            zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, out, err);
+            const auto stats = engine.run(req);
+            CHECK(stats.matches == 4);
+            const std::vector<std::uintmax_t> all{2, text.size() - 109, text.size() - 106, text.size() - 3};
+            REQUIRE(out.matches.size() == std::min<std::size_t>(cap, 4));
+            for (std::size_t i = 0; i < out.matches.size(); ++i) {
+                CHECK(out.matches[i].offset == all[i]);
+                CHECK(out.matches[i].snippet.find("abc") != std::string::npos);
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/SearchEngine.hpp"
+#include "platform/MappedFileProvider.hpp"
+#include "platform/OutputWriters.hpp"
+#include "platform/StdFileReader.hpp"
+#include "platform/StdFilesystemEnumerator.hpp"
+
+#include "doctest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+class NullErr final : public zenith::core::IErrorWriter {
+public:
+    void write_error(const zenith::core::Error&) override {}
+};
+} // namespace
+
+TEST_CASE("trace records per-thread spans as chrome trace json") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_trace";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "a.txt") << "needle";
+    std::ofstream(root / "b.txt") << "hay needle";
+
+    zenith::core::SearchRequest req;
+    req.pattern = "needle";
+    req.input_paths = {root.string()};
+    req.threads = 2;
+    req.io_threads = 1;
+
+    std::ostringstream os;
+    auto writer = zenith::platform::make_output_writer(req, os);
+    NullErr err;
+    zenith::platform::StdFilesystemEnumerator en;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    zenith::core::BmhSearchAlgorithm bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    zenith::core::SearchEngine engine(en, reader, mapped, naive, bmh, bm, *writer, err);
+    zenith::core::TraceRecorder trace;
+    engine.set_trace_recorder(&trace);
+    CHECK(engine.run(req).any_match);
+
+    // enumerator + 2 workers + 1 I/O thread + emitter
+    REQUIRE(trace.tracks().size() == 5);
+    CHECK(trace.tracks().front()->name() == "enumerator");
+    CHECK(trace.tracks()[3]->name() == "io 0");
+    CHECK(trace.tracks().back()->name() == "emitter");
+    CHECK(trace.tracks().back()->events().size() == 2);
+
+    std::ostringstream json;
+    trace.write_chrome_json(json);
+    const auto out = json.str();
+    CHECK(out.find("\"traceEvents\"") != std::string::npos);
+    CHECK(out.find("\"name\":\"enumerate\"") != std::string::npos);
+    CHECK(out.find("\"name\":\"scan\"") != std::string::npos);
+    CHECK(out.find("\"name\":\"read\"") != std::string::npos);
+    CHECK(out.find("\"name\":\"emit\"") != std::string::npos);
+    CHECK(out.find("\"name\":\"worker 1\"") != std::string::npos);
+    CHECK(out.find("a.txt") != std::string::npos);
+
+    fs::remove_all(root);
+}
@@ -0,0 +1,137 @@
+#include "cli/ArgParser.hpp"
+#include "core/NaiveSearchAlgorithm.hpp"
+#include "core/SearchEngine.hpp"
+#include "core/TuningProfile.hpp"
+#include "platform/MappedFileProvider.hpp"
+#include "platform/StdFileReader.hpp"
+#include "platform/StdFilesystemEnumerator.hpp"
+#include "platform/Tuner.hpp"
+
+#include "doctest.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+class NullOut final : public zenith::core::IOutputWriter {
+public:
+    void write_match(const zenith::core::MatchRecord&) override {}
+    void write_file_summary(const zenith::core::FileMatchSummary&) override {}
+};
+
+class NullErr final : public zenith::core::IErrorWriter {
+public:
+    void write_error(const zenith::core::Error&) override {}
+};
+
+class CountingBmh final : public zenith::core::ISearchAlgorithm {
+public:
+    mutable std::atomic<int> calls{0};
+    std::vector<std::size_t> find_all(std::string_view buffer, std::string_view pattern) const override {
+        ++calls;
+        return inner.find_all(buffer, pattern);
+    }
+
+private:
+    zenith::core::BmhSearchAlgorithm inner;
+};
+} // namespace
+
+TEST_CASE("tuning profile round-trips through its text format") {
+    zenith::core::TuningProfile profile;
+    profile.mmap_threshold_bytes = 256U * 1024U;
+    profile.chunk_size = 4U * 1024U * 1024U;
+    profile.auto_algorithm_by_length = {zenith::core::AlgorithmMode::Auto, zenith::core::AlgorithmMode::Short,
+                                        zenith::core::AlgorithmMode::Auto, zenith::core::AlgorithmMode::Bmh,
+                                        zenith::core::AlgorithmMode::RareByte};
+    std::stringstream text;
+    zenith::core::write_tuning_profile(profile, text);
+
+    auto parsed = zenith::core::parse_tuning_profile(text);
+    REQUIRE(parsed.has_value());
+    CHECK(parsed.value().mmap_threshold_bytes.value() == profile.mmap_threshold_bytes.value());
+    CHECK(parsed.value().chunk_size.value() == profile.chunk_size.value());
+    CHECK(parsed.value().auto_algorithm_by_length == profile.auto_algorithm_by_length);
+
+    zenith::core::SearchRequest req;
+    zenith::core::apply_tuning_profile(parsed.value(), req);
+    CHECK(req.mmap_threshold_bytes == 256U * 1024U);
+    CHECK(req.chunk_size == 4U * 1024U * 1024U);
+    CHECK(req.auto_algorithm_by_length.size() == 5);
+}
+
+TEST_CASE("tuning profile rejects malformed lines and ignores unknown keys") {
+    auto parse = [](const std::string& s) {
+        std::istringstream in(s);
+        return zenith::core::parse_tuning_profile(in);
+    };
+    CHECK(parse("# comment\nversion=1\nfuture_key=7\n").has_value());
+    CHECK_FALSE(parse("version=2\n").has_value());
+    CHECK_FALSE(parse("chunk_size\n").has_value());
+    CHECK_FALSE(parse("chunk_size=0\n").has_value());
+    CHECK_FALSE(parse("mmap_threshold_bytes=12k\n").has_value());
+    CHECK_FALSE(parse("algo.0=short\n").has_value());
+    CHECK_FALSE(parse("algo.4=fastest\n").has_value());
+    CHECK_FALSE(parse("algo.4=auto\n").has_value());
+}
+
+TEST_CASE("ArgParser parses tune and --profile") {
+    zenith::cli::ArgParser parser;
+    auto tune = parser.parse({"tune", "--output", "p.txt"});
+    REQUIRE(tune.has_value());
+    CHECK(tune.value().run_tune);
+    CHECK(tune.value().tune_output == "p.txt");
+    CHECK_FALSE(parser.parse({"tune", "--bogus"}).has_value());
+
+    auto search = parser.parse({"--profile", "p.txt", "--algo", "rare_byte", "pat", "."});
+    REQUIRE(search.has_value());
+    CHECK(search.value().profile_path == "p.txt");
+    CHECK(search.value().request.algorithm_mode == zenith::core::AlgorithmMode::RareByte);
+}
+
+TEST_CASE("Auto mode follows the tuned kernel table, covering longer patterns with the last entry") {
+    namespace fs = std::filesystem;
+    const auto root = fs::temp_directory_path() / "zenith_tuning";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "a.txt") << "xx needle_in_a_haystack xx needle";
+
+    zenith::platform::StdFilesystemEnumerator enumerator;
+    zenith::platform::StdFileReader reader;
+    zenith::platform::MappedFileProvider mapped;
+    zenith::core::NaiveSearchAlgorithm naive;
+    CountingBmh bmh;
+    zenith::core::BoyerMooreSearchAlgorithm bm;
+    NullOut out;
+    NullErr err;
+    zenith::core::SearchEngine engine(enumerator, reader, mapped, naive, bmh, bm, out, err);
+
+    zenith::core::SearchRequest req;
+    req.input_paths = {root.string()};
+    req.auto_algorithm_by_length = {zenith::core::AlgorithmMode::Auto, zenith::core::AlgorithmMode::Auto,
+                                    zenith::core::AlgorithmMode::Bmh};
+    req.pattern = "needle_in_a_haystack";
+    auto stats = engine.run(req);
+    CHECK(stats.matches == 1);
+    CHECK(bmh.calls.load() == 1);
+
+    req.pattern = "x"; // below the first tuned entry: built-in rule
+    stats = engine.run(req);
+    CHECK(stats.matches == 4);
+    CHECK(bmh.calls.load() == 1);
+}
+
+TEST_CASE("profile files are saved and loaded") {
+    namespace fs = std::filesystem;
+    const auto path = fs::temp_directory_path() / "zenith_tuning_profile" / "nested" / "profile";
+    fs::remove_all(fs::temp_directory_path() / "zenith_tuning_profile");
+    zenith::core::TuningProfile profile;
+    profile.chunk_size = 65536;
+    REQUIRE(zenith::platform::save_tuning_profile(profile, path).has_value());
+    auto loaded = zenith::platform::load_tuning_profile(path);
+    REQUIRE(loaded.has_value());
+    CHECK(loaded.value().chunk_size.value() == 65536);
+    CHECK_FALSE(zenith::platform::load_tuning_profile(path.parent_path() / "missing").has_value());
+}